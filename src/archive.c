@@ -0,0 +1,441 @@
+#include "headers/archive.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define ARCHIVE_MAX_SEGMENTS 4096
+
+struct Archive {
+    char dir[256];
+    int index_fd;
+    int seg_fd;
+    uint32_t segment;
+    uint64_t seg_size;
+    uint64_t segment_max;
+    int compress;
+    int last_id;
+    pthread_mutex_t lock;
+};
+
+// Journal d'une partie en cours: seul le dernier morceau écrit est retenu.
+struct ArchiveStream {
+    Archive *a;
+    int game_id;
+    int failed;            // Un morceau n'a pas pu être écrit: pas d'entrée d'index
+    uint32_t last_segment; // 0: aucun morceau encore
+    uint64_t last_offset;
+    uint64_t stored;       // Octets dans les segments, en-têtes compris
+    uint64_t raw;
+    uint32_t flags;
+};
+
+typedef struct {
+    const char *base;
+    size_t size;
+} Mapping;
+
+struct ArchiveReader {
+    char dir[256];
+    Mapping index;
+    Mapping seg[ARCHIVE_MAX_SEGMENTS];
+    char *scratch;         // Tampon de décompression réutilisé
+    size_t scratch_cap;
+};
+
+static void segment_path(char *buf, size_t cap, const char *dir, uint32_t seg) {
+    snprintf(buf, cap, "%s/seg_%06u.dat", dir, seg);
+}
+
+// Ouvre (ou crée) le segment seg en ajout et relève sa taille.
+static int open_segment(Archive *a, uint32_t seg) {
+    char path[300];
+    segment_path(path, sizeof(path), a->dir, seg);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return 0;
+    }
+    if (a->seg_fd >= 0) close(a->seg_fd);
+    a->seg_fd = fd;
+    a->segment = seg;
+    a->seg_size = (uint64_t)st.st_size;
+    return 1;
+}
+
+// Ouvre l'archive en écriture; reprend au dernier segment et au dernier id.
+Archive *archive_open(const char *dir, uint64_t segment_max, int compress) {
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) return NULL;
+
+    Archive *a = calloc(1, sizeof(*a));
+    if (!a) return NULL;
+    snprintf(a->dir, sizeof(a->dir), "%s", dir);
+    a->seg_fd = -1;
+    a->segment_max = segment_max ? segment_max : ARCHIVE_SEGMENT_MAX;
+#ifdef HAVE_ZLIB
+    a->compress = compress;
+#else
+    (void)compress;
+#endif
+    pthread_mutex_init(&a->lock, NULL);
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s/index.dat", dir);
+    a->index_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (a->index_fd < 0) {
+        free(a);
+        return NULL;
+    }
+
+    // Parcours de l'index existant: l'emplacement le plus haut donne le dernier
+    // id, et le plus grand segment référencé est celui où reprendre l'ajout.
+    uint32_t seg = 1;
+    ArchiveEntry e;
+    off_t off = 0;
+    while (pread(a->index_fd, &e, sizeof(e), off) == (ssize_t)sizeof(e)) {
+        off += (off_t)sizeof(e);
+        if (e.game_id && e.segment > seg) seg = e.segment;
+    }
+    a->last_id = (int)(off / (off_t)sizeof(e));
+
+    if (!open_segment(a, seg)) {
+        close(a->index_fd);
+        free(a);
+        return NULL;
+    }
+    return a;
+}
+
+// Plus grand id de partie connu de l'index (0 pour une archive vide).
+int archive_last_id(const Archive *a) {
+    return a->last_id;
+}
+
+// Compresse un bloc hors verrou, conservé seulement s'il fait gagner de la
+// place. Renvoie le bloc à écrire; *packed (à libérer) le tampon compressé.
+static const char *pack_block(const Archive *a, const char *data, size_t len, size_t *block_len,
+                              uint32_t *flags, char **packed) {
+    *packed = NULL;
+    *block_len = len;
+#ifdef HAVE_ZLIB
+    if (a->compress && len > 0) {
+        uLongf cap = compressBound((uLong)len);
+        *packed = malloc(cap);
+        if (*packed && compress2((Bytef *)*packed, &cap, (const Bytef *)data, (uLong)len, Z_DEFAULT_COMPRESSION) == Z_OK &&
+            cap < len) {
+            *block_len = cap;
+            *flags |= ARCHIVE_ZLIB;
+            return *packed;
+        }
+    }
+#else
+    (void)a;
+    (void)flags;
+#endif
+    return data;
+}
+
+// Passe au segment suivant si len octets ne tiennent plus dans le courant;
+// 0 si le nouveau segment ne s'ouvre pas. Appelée avec le verrou tenu.
+static int segment_room(Archive *a, size_t len) {
+    if (a->seg_size > 0 && a->seg_size + len > a->segment_max) return open_segment(a, a->segment + 1);
+    return 1;
+}
+
+// Écrit tout le tampon en fin de segment; 0 sinon. Appelée avec le verrou tenu.
+static int segment_write(Archive *a, const void *buf, size_t len) {
+    const char *p = buf;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t w = write(a->seg_fd, p + done, len - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        done += (size_t)w;
+    }
+    a->seg_size += done;
+    return done == len;
+}
+
+// Publie l'entrée d'index d'une partie. Appelée avec le verrou tenu.
+static int index_publish(Archive *a, const ArchiveEntry *e) {
+    off_t at = (off_t)(e->game_id - 1) * (off_t)sizeof(*e);
+    if (pwrite(a->index_fd, e, sizeof(*e), at) != (ssize_t)sizeof(*e)) return 0;
+    if ((int)e->game_id > a->last_id) a->last_id = (int)e->game_id;
+    return 1;
+}
+
+// Commence le journal d'une partie; NULL si la mémoire manque.
+ArchiveStream *archive_stream_open(Archive *a, int game_id) {
+    if (game_id <= 0) return NULL;
+    ArchiveStream *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->a = a;
+    s->game_id = game_id;
+    return s;
+}
+
+// Écrit un morceau du journal (compressé à part s'il y gagne), chaîné au
+// précédent. Après un échec, les morceaux suivants sont refusés: la partie
+// ne sera pas indexée avec un journal troué.
+int archive_stream_append(ArchiveStream *s, const char *data, size_t len) {
+    if (s->failed) return 0;
+    if (len == 0) return 1;
+    if (s->raw + len > 0xffffffffu) {
+        s->failed = 1;
+        return 0;
+    }
+
+    ArchiveChunk h;
+    memset(&h, 0, sizeof(h));
+    h.game_id = (uint32_t)s->game_id;
+    h.raw_size = (uint32_t)len;
+    h.prev_segment = s->last_segment;
+    h.prev_offset = s->last_offset;
+
+    char *packed;
+    size_t block_len;
+    const char *block = pack_block(s->a, data, len, &block_len, &h.flags, &packed);
+    h.stored_size = (uint32_t)block_len;
+
+    Archive *a = s->a;
+    pthread_mutex_lock(&a->lock);
+    int ok = segment_room(a, sizeof(h) + block_len);
+    uint32_t seg = a->segment;
+    uint64_t off = a->seg_size;
+    ok = ok && segment_write(a, &h, sizeof(h)) && segment_write(a, block, block_len);
+    pthread_mutex_unlock(&a->lock);
+    free(packed);
+
+    if (!ok) {
+        s->failed = 1;
+        return 0;
+    }
+    s->last_segment = seg;
+    s->last_offset = off;
+    s->stored += sizeof(h) + block_len;
+    s->raw += len;
+    s->flags |= h.flags;
+    return 1;
+}
+
+// Publie l'entrée d'index du journal écrit par morceaux et libère le flux.
+// 0 si un morceau manque ou si l'index n'a pas pu être écrit.
+int archive_stream_commit(ArchiveStream *s, time_t start, time_t end) {
+    int ok = !s->failed && s->stored <= 0xffffffffu;
+    if (ok && s->last_segment) {
+        ArchiveEntry e;
+        memset(&e, 0, sizeof(e));
+        e.game_id = (uint32_t)s->game_id;
+        e.segment = s->last_segment;
+        e.offset = s->last_offset;
+        e.stored_size = (uint32_t)s->stored;
+        e.raw_size = (uint32_t)s->raw;
+        e.start_time = start;
+        e.end_time = end;
+        e.flags = ARCHIVE_CHAINED | s->flags;
+
+        Archive *a = s->a;
+        pthread_mutex_lock(&a->lock);
+        ok = index_publish(a, &e);
+        pthread_mutex_unlock(&a->lock);
+    }
+    free(s);
+    return ok;
+}
+
+// Abandonne un journal sans entrée d'index (ses morceaux ne seront pas lus).
+void archive_stream_abort(ArchiveStream *s) {
+    free(s);
+}
+
+void archive_close(Archive *a) {
+    if (!a) return;
+    if (a->seg_fd >= 0) close(a->seg_fd);
+    close(a->index_fd);
+    pthread_mutex_destroy(&a->lock);
+    free(a);
+}
+
+// Projette un fichier entier en lecture seule (taille 0 acceptée).
+static int map_file(const char *path, Mapping *m) {
+    m->base = NULL;
+    m->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    int ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size > 0) {
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) ok = 0;
+        else {
+            m->base = p;
+            m->size = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+// Ouvre l'archive en lecture: l'index est projeté, les segments à la demande.
+ArchiveReader *archive_reader_open(const char *dir) {
+    ArchiveReader *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    snprintf(r->dir, sizeof(r->dir), "%s", dir);
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s/index.dat", dir);
+    if (!map_file(path, &r->index)) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+// Nombre d'emplacements de l'index (= plus grand id archivable).
+int archive_reader_count(const ArchiveReader *r) {
+    return (int)(r->index.size / sizeof(ArchiveEntry));
+}
+
+// Entrée d'index d'une partie, NULL si elle n'est pas archivée.
+const ArchiveEntry *archive_entry(const ArchiveReader *r, int game_id) {
+    if (game_id <= 0 || game_id > archive_reader_count(r)) return NULL;
+    const ArchiveEntry *e = (const ArchiveEntry *)r->index.base + (game_id - 1);
+    return e->game_id == (uint32_t)game_id ? e : NULL;
+}
+
+// len octets à l'offset off du segment seg, projeté au besoin. Le pointeur
+// reste valable jusqu'à la prochaine projection de ce segment.
+static const char *segment_bytes(ArchiveReader *r, uint32_t seg, uint64_t off, size_t len) {
+    if (seg == 0 || seg >= ARCHIVE_MAX_SEGMENTS) return NULL;
+    Mapping *m = &r->seg[seg];
+    if (!m->base || off + len > m->size) {
+        // Projection (ou reprojection si le segment a grandi depuis)
+        char path[300];
+        segment_path(path, sizeof(path), r->dir, seg);
+        if (m->base) munmap((void *)m->base, m->size);
+        if (!map_file(path, m)) return NULL;
+    }
+    if (off + len > m->size) return NULL;
+    return m->base + off;
+}
+
+// Tampon interne d'au moins cap octets.
+static int scratch_reserve(ArchiveReader *r, size_t cap) {
+    if (r->scratch_cap >= cap) return 1;
+    char *p = realloc(r->scratch, cap ? cap : 1);
+    if (!p) return 0;
+    r->scratch = p;
+    r->scratch_cap = cap;
+    return 1;
+}
+
+// Copie (ou décompresse) un bloc de raw octets dans dst.
+static int unpack_block(const char *block, uint32_t stored, uint32_t flags, char *dst, uint32_t raw) {
+    if (!(flags & ARCHIVE_ZLIB)) {
+        if (stored != raw) return 0;
+        memcpy(dst, block, raw);
+        return 1;
+    }
+#ifdef HAVE_ZLIB
+    uLongf out = raw;
+    return uncompress((Bytef *)dst, &out, (const Bytef *)block, stored) == Z_OK && out == raw;
+#else
+    return 0;
+#endif
+}
+
+// Journal écrit par morceaux: remonté depuis le dernier, chaque morceau est
+// placé à sa position dans le tampon interne (la taille totale est connue).
+static const char *read_chained(ArchiveReader *r, const ArchiveEntry *e, size_t *len) {
+    if (!scratch_reserve(r, e->raw_size)) return NULL;
+    uint64_t pos = e->raw_size;
+    uint32_t seg = e->segment;
+    uint64_t off = e->offset;
+    while (seg) {
+        const char *p = segment_bytes(r, seg, off, sizeof(ArchiveChunk));
+        if (!p) return NULL;
+        ArchiveChunk h;
+        memcpy(&h, p, sizeof(h));
+        if (h.game_id != e->game_id || h.raw_size == 0 || h.raw_size > pos) return NULL;
+
+        const char *block = segment_bytes(r, seg, off + sizeof(h), h.stored_size);
+        if (!block) return NULL;
+        pos -= h.raw_size;
+        if (!unpack_block(block, h.stored_size, h.flags, r->scratch + pos, h.raw_size)) return NULL;
+        seg = h.prev_segment;
+        off = h.prev_offset;
+    }
+    if (pos != 0) return NULL;
+    *len = e->raw_size;
+    return r->scratch;
+}
+
+// Journal d'une partie. D'un seul bloc sans compression, pointe directement
+// dans le segment; sinon dans un tampon interne valable jusqu'au prochain appel.
+const char *archive_read(ArchiveReader *r, int game_id, size_t *len) {
+    const ArchiveEntry *e = archive_entry(r, game_id);
+    if (!e) return NULL;
+    if (e->flags & ARCHIVE_CHAINED) return read_chained(r, e, len);
+
+    const char *block = segment_bytes(r, e->segment, e->offset, e->stored_size);
+    if (!block) return NULL;
+
+    if (!(e->flags & ARCHIVE_ZLIB)) {
+        *len = e->stored_size;
+        return block;
+    }
+    if (!scratch_reserve(r, e->raw_size) ||
+        !unpack_block(block, e->stored_size, e->flags, r->scratch, e->raw_size))
+        return NULL;
+    *len = e->raw_size;
+    return r->scratch;
+}
+
+// Parcours commun: avec with_data, chaque journal est lu (et décompressé).
+static int scan(ArchiveReader *r, time_t from, time_t to, ArchiveScanFn fn, void *ctx, int with_data) {
+    int n = archive_reader_count(r);
+    int seen = 0;
+
+    for (int id = 1; id <= n; id++) {
+        const ArchiveEntry *e = archive_entry(r, id);
+        if (!e) continue;
+        if (e->start_time < from || (to && e->start_time > to)) continue;
+
+        size_t len = 0;
+        const char *data = with_data ? archive_read(r, id, &len) : NULL;
+        if (with_data && !data) continue;
+        seen++;
+        if (!fn(e, data, len, ctx)) break;
+    }
+    return seen;
+}
+
+// Parcourt les parties commencées dans [from, to] (to = 0: sans borne).
+// Arrête dès que fn renvoie 0; renvoie le nombre de parties visitées.
+int archive_scan(ArchiveReader *r, time_t from, time_t to, ArchiveScanFn fn, void *ctx) {
+    return scan(r, from, to, fn, ctx, 1);
+}
+
+// Comme archive_scan, sur l'index seul: fn reçoit data NULL et len 0, aucun
+// segment n'est lu.
+int archive_scan_index(ArchiveReader *r, time_t from, time_t to, ArchiveScanFn fn, void *ctx) {
+    return scan(r, from, to, fn, ctx, 0);
+}
+
+void archive_reader_close(ArchiveReader *r) {
+    if (!r) return;
+    if (r->index.base) munmap((void *)r->index.base, r->index.size);
+    for (int i = 0; i < ARCHIVE_MAX_SEGMENTS; i++)
+        if (r->seg[i].base) munmap((void *)r->seg[i].base, r->seg[i].size);
+    free(r->scratch);
+    free(r);
+}
@@ -0,0 +1,97 @@
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/archive.h"
+
+/*
+ * Lecture de l'archive des parties (tout passe par mmap; liste ne lit que l'index).
+ * Usage: ./archive [-d dossier] cat <id>
+ *        ./archive [-d dossier] liste [debut [fin]]
+ *        ./archive [-d dossier] periode <debut> <fin>
+ * Les bornes sont des dates Unix (secondes); fin = 0 signifie sans borne.
+ */
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-d dossier] cat <id>\n"
+            "       %s [-d dossier] liste [debut [fin]]\n"
+            "       %s [-d dossier] periode <debut> <fin>\n",
+            prog, prog, prog);
+}
+
+// Lit une date Unix en secondes (0 accepté).
+static int parse_time(const char *s, time_t *out) {
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    if (errno || end == s || *end || v < 0) return 0;
+    *out = (time_t)v;
+    return 1;
+}
+
+// Une ligne par partie: id, dates, emplacement et tailles.
+static int print_entry(const ArchiveEntry *e, const char *data, size_t len, void *ctx) {
+    (void)data;
+    (void)len;
+    (void)ctx;
+    printf("%u %lld %lld seg_%06u.dat@%llu %u/%u%s%s\n", e->game_id, (long long)e->start_time,
+           (long long)e->end_time, e->segment, (unsigned long long)e->offset, e->stored_size,
+           e->raw_size, (e->flags & ARCHIVE_ZLIB) ? " zlib" : "", (e->flags & ARCHIVE_CHAINED) ? " morceaux" : "");
+    return 1;
+}
+
+static int print_data(const ArchiveEntry *e, const char *data, size_t len, void *ctx) {
+    (void)e;
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = ARCHIVE_DIR;
+    int a = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-d") == 0) {
+        dir = argv[2];
+        a = 3;
+    }
+    if (a >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ArchiveReader *r = archive_reader_open(dir);
+    if (!r) {
+        fprintf(stderr, "Archive introuvable: %s\n", dir);
+        return 1;
+    }
+
+    const char *cmd = argv[a++];
+    int rc = 0;
+
+    if (strcmp(cmd, "cat") == 0 && a == argc - 1) {
+        int id;
+        size_t len;
+        const char *data = parse_int(argv[a], &id) ? archive_read(r, id, &len) : NULL;
+        if (!data) {
+            fprintf(stderr, "Partie absente de l'archive: %s\n", argv[a]);
+            rc = 1;
+        } else {
+            fwrite(data, 1, len, stdout);
+        }
+    } else if ((strcmp(cmd, "liste") == 0 && argc - a <= 2) ||
+               (strcmp(cmd, "periode") == 0 && argc - a == 2)) {
+        time_t from = 0, to = 0;
+        if ((a < argc && !parse_time(argv[a], &from)) || (a + 1 < argc && !parse_time(argv[a + 1], &to))) {
+            usage(argv[0]);
+            rc = 1;
+        } else {
+            if (cmd[0] == 'l') archive_scan_index(r, from, to, print_entry, NULL);
+            else archive_scan(r, from, to, print_data, NULL);
+        }
+    } else {
+        usage(argv[0]);
+        rc = 1;
+    }
+
+    archive_reader_close(r);
+    return rc;
+}
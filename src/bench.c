@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/game.h"
+#include "headers/proto.h"
+#include "headers/stats.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Micro-benchmarks du moteur et des analyseurs du protocole.
+ * Graines fixes: deux exécutions mesurent exactement le même travail.
+ * Usage: ./microbench [iterations] [filtre]
+ */
+
+#define BENCH_REPEAT 5
+#define BENCH_SEED 0x6b696c6cULL
+
+static volatile int sink;
+
+typedef struct {
+    const char *name;
+    void (*run)(long iters);
+} BenchCase;
+
+static Game bench_game;
+static Game bench_ref;
+static int bench_cards[1024];
+
+// Prépare une table et des mains reproductibles pour tous les cas.
+static void bench_setup(void) {
+    game_init(&bench_game, 10);
+    game_reseed(&bench_game, BENCH_SEED);
+    game_setup_rows(&bench_game);
+    game_deal(&bench_game);
+
+    bench_ref = bench_game;
+    bench_ref.k = game_reference_kernel();
+
+    uint64_t x = BENCH_SEED;
+    for (int i = 0; i < 1024; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        bench_cards[i] = (int)(x % DECK_SIZE) + 1;
+    }
+}
+
+static void run_bulls(long iters) {
+    int s = 0;
+    for (long i = 0; i < iters; i++) s += bulls(bench_cards[i & 1023]);
+    sink = s;
+}
+
+static void run_best_row(long iters) {
+    int s = 0;
+    for (long i = 0; i < iters; i++) s += game_best_row(&bench_game, bench_cards[i & 1023], NULL);
+    sink = s;
+}
+
+// Place des cartes en continu; les scores sont remis à zéro pour éviter tout débordement.
+static void run_place_with(Game *g, long iters) {
+    Game w = *g;
+    int row, b;
+    for (long i = 0; i < iters; i++) {
+        w.k->place(&w, (int)(i % 10), bench_cards[i & 1023], (int)(i & 3), &row, &b);
+        if ((i & 1023) == 1023) memset(w.scores, 0, sizeof(w.scores));
+    }
+    sink = w.rows[0].len;
+}
+
+static void run_place(long iters) { run_place_with(&bench_game, iters); }
+static void run_place_ref(long iters) { run_place_with(&bench_ref, iters); }
+
+static void run_deal_with(Game *g, long iters) {
+    Game w = *g;
+    for (long i = 0; i < iters; i++) {
+        w.top = ROWS;
+        w.k->deal(&w);
+    }
+    sink = w.hands[0][0];
+}
+
+static void run_deal(long iters) { run_deal_with(&bench_game, iters); }
+static void run_deal_ref(long iters) { run_deal_with(&bench_ref, iters); }
+
+// Table représentative de milieu de manche (rangées de longueurs variées).
+static Game bench_table(const GameKernel *k) {
+    Game w = bench_game;
+    int fill[ROWS] = { 5, 3, 1, 4 };
+    for (int r = 0; r < ROWS; r++) {
+        w.rows[r].len = fill[r];
+        for (int i = 0; i < fill[r]; i++) w.rows[r].cards[i] = 10 + r * 25 + i * 4;
+    }
+    if (k) w.k = k;
+    return w;
+}
+
+static void run_table_with(const GameKernel *k, long iters) {
+    Game w = bench_table(k);
+    char buf[LINE_MAX];
+    for (long i = 0; i < iters; i++) w.k->table_string(&w, buf, sizeof(buf));
+    sink = buf[0];
+}
+
+static void run_table(long iters) { run_table_with(NULL, iters); }
+static void run_table_ref(long iters) { run_table_with(game_reference_kernel(), iters); }
+
+static void run_hand_with(const GameKernel *k, long iters) {
+    Game w = bench_game;
+    if (k) w.k = k;
+    char buf[LINE_MAX];
+    for (long i = 0; i < iters; i++) w.k->hand_string(&w, (int)(i % 10), buf, sizeof(buf));
+    sink = buf[0];
+}
+
+static void run_hand(long iters) { run_hand_with(NULL, iters); }
+static void run_hand_ref(long iters) { run_hand_with(game_reference_kernel(), iters); }
+
+static void run_score(long iters) {
+    Game w = bench_game;
+    char buf[LINE_MAX];
+    for (int p = 0; p < 10; p++) w.scores[p] = p * 7;
+    for (long i = 0; i < iters; i++) game_score_string(&w, buf, sizeof(buf));
+    sink = buf[0];
+}
+
+static void run_parse_play(long iters) {
+    static const char *lines[4] = { "JOUER 42", "jouer 7 2", "  103", "JOUER x" };
+    int s = 0, c, r;
+    for (long i = 0; i < iters; i++) s += parse_play(lines[i & 3], &c, &r);
+    sink = s;
+}
+
+static void run_parse_hand(long iters) {
+    char line[LINE_MAX];
+    char hand[LINE_MAX / 2];
+    int cards[HAND_SIZE];
+    int s = 0;
+    game_hand_string(&bench_game, 0, hand, sizeof(hand));
+    snprintf(line, sizeof(line), "MAIN %s", hand);
+    for (long i = 0; i < iters; i++) s += parse_hand(line, cards, HAND_SIZE);
+    sink = s;
+}
+
+static void run_parse_table(long iters) {
+    Game w = bench_table(NULL);
+    char line[LINE_MAX];
+    Row rows[ROWS];
+    game_table_string(&w, line, sizeof(line));
+    for (long i = 0; i < iters; i++) parse_table_rows(line, rows);
+    sink = rows[0].len;
+}
+
+#define BENCH_STATS_PLAYERS 1000000
+
+static char bench_names[1024][PLAYER_NAME_MAX];
+
+// Statistiques persistantes (-J) dans un fichier temporaire à la capacité par
+// défaut, BENCH_STATS_PLAYERS joueurs inscrits; créées au premier cas qui s'en sert.
+static StatsStore *bench_stats(void) {
+    static StatsStore *st;
+    if (!st) {
+        char path[] = "/tmp/microbench-statsXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) die("mkstemp");
+        close(fd);
+        unlink(path);
+        if (!(st = stats_open(path, STATS_SLOTS_DEFAULT))) die("stats_open");
+        unlink(path);
+        StatsResult r[2] = { { NULL, 10, 1, 0, 0 }, { "bot", 20, 0, 0, 0 } };
+        char name[PLAYER_NAME_MAX];
+        for (int i = 0; i < BENCH_STATS_PLAYERS; i++) {
+            snprintf(name, sizeof(name), "joueur%d", i);
+            r[0].name = name;
+            stats_record_game(st, r, 2);
+        }
+        for (int i = 0; i < 1024; i++)
+            snprintf(bench_names[i], sizeof(bench_names[i]), "joueur%d", (i * 7919) % BENCH_STATS_PLAYERS);
+    }
+    return st;
+}
+
+static void run_stats_lookup(long iters) {
+    StatsStore *st = bench_stats();
+    PlayerStats ps;
+    int s = 0;
+    for (long i = 0; i < iters; i++) s += stats_lookup(st, bench_names[i & 1023], &ps);
+    sink = s;
+}
+
+// Fin de partie à quatre joueurs inscrits: recherches, Elo par paires et additions atomiques.
+static void run_stats_record(long iters) {
+    StatsStore *st = bench_stats();
+    StatsResult r[4];
+    for (long i = 0; i < iters; i++) {
+        for (int p = 0; p < 4; p++)
+            r[p] = (StatsResult){ bench_names[(i * 4 + p) & 1023], (int)((i + p) % 70), 1, 0.5, 10 };
+        stats_record_game(st, r, 4);
+    }
+}
+
+static const BenchCase cases[] = {
+    { "bulls", run_bulls },
+    { "best_row_for_card", run_best_row },
+    { "game_place_card", run_place },
+    { "game_place_card/ref", run_place_ref },
+    { "game_deal", run_deal },
+    { "game_deal/ref", run_deal_ref },
+    { "game_table_string", run_table },
+    { "game_table_string/ref", run_table_ref },
+    { "game_hand_string", run_hand },
+    { "game_hand_string/ref", run_hand_ref },
+    { "game_score_string", run_score },
+    { "parse_play", run_parse_play },
+    { "parse_hand", run_parse_hand },
+    { "parse_table_rows", run_parse_table },
+    { "stats_lookup", run_stats_lookup },
+    { "stats_record_game", run_stats_record },
+};
+
+/* Compteurs matériels (perf_event_open); absents hors Linux ou sans droits. */
+
+enum { HW_CYCLES, HW_INSNS, HW_BRMISS, HW_COUNT };
+
+typedef struct {
+    int fd[HW_COUNT];
+    uint64_t val[HW_COUNT];
+} HwCounters;
+
+static void hw_open(HwCounters *h) {
+    for (int i = 0; i < HW_COUNT; i++) h->fd[i] = -1;
+#ifdef __linux__
+    static const uint64_t cfg[HW_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i = 0; i < HW_COUNT; i++) {
+        struct perf_event_attr a;
+        memset(&a, 0, sizeof(a));
+        a.type = PERF_TYPE_HARDWARE;
+        a.size = sizeof(a);
+        a.config = cfg[i];
+        a.disabled = 1;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        h->fd[i] = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+    }
+#endif
+}
+
+static void hw_start(HwCounters *h) {
+#ifdef __linux__
+    for (int i = 0; i < HW_COUNT; i++) {
+        if (h->fd[i] < 0) continue;
+        ioctl(h->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(h->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)h;
+#endif
+}
+
+static void hw_stop(HwCounters *h) {
+    for (int i = 0; i < HW_COUNT; i++) {
+        h->val[i] = 0;
+        if (h->fd[i] < 0) continue;
+#ifdef __linux__
+        ioctl(h->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+        if (read(h->fd[i], &h->val[i], sizeof(h->val[i])) != (ssize_t)sizeof(h->val[i]))
+            h->val[i] = 0;
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Exécute un cas BENCH_REPEAT fois et affiche la médiane en ns/op.
+static void bench_one(const BenchCase *bc, long iters, HwCounters *hw) {
+    double t[BENCH_REPEAT];
+    uint64_t best[HW_COUNT] = { 0 };
+
+    bc->run(iters / 10 + 1);
+
+    for (int k = 0; k < BENCH_REPEAT; k++) {
+        hw_start(hw);
+        double t0 = now_ns();
+        bc->run(iters);
+        t[k] = (now_ns() - t0) / (double)iters;
+        hw_stop(hw);
+        for (int i = 0; i < HW_COUNT; i++)
+            if (k == 0 || hw->val[i] < best[i]) best[i] = hw->val[i];
+    }
+    qsort(t, BENCH_REPEAT, sizeof(t[0]), cmp_double);
+
+    printf("%-24s %9.2f ns/op", bc->name, t[BENCH_REPEAT / 2]);
+    if (hw->fd[HW_CYCLES] >= 0 && best[HW_CYCLES] > 0) {
+        printf("  %7.1f cyc/op  %7.1f ins/op  IPC %.2f  %6.3f br-miss/op",
+               (double)best[HW_CYCLES] / iters, (double)best[HW_INSNS] / iters,
+               (double)best[HW_INSNS] / (double)best[HW_CYCLES],
+               (double)best[HW_BRMISS] / iters);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    long iters = 2000000;
+    const char *filter = NULL;
+
+    if (argc > 1) {
+        int v;
+        if (!parse_int(argv[1], &v) || v <= 0) {
+            fprintf(stderr, "Usage: %s [iterations] [filtre]\n", argv[0]);
+            return 1;
+        }
+        iters = v;
+    }
+    if (argc > 2) filter = argv[2];
+
+    bench_setup();
+
+    HwCounters hw;
+    hw_open(&hw);
+    printf("microbench: %ld iterations x %d, compteurs materiels %s\n",
+           iters, BENCH_REPEAT, hw.fd[HW_CYCLES] >= 0 ? "actifs" : "indisponibles");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (filter && !strstr(cases[i].name, filter)) continue;
+        bench_one(&cases[i], iters, &hw);
+    }
+    return 0;
+}
@@ -1,10 +1,34 @@
-#include <stdarg.h>
-#include <ctype.h>
 #include "headers/common.h"
 #include "headers/net.h"
+#include "headers/transport.h"
 #include "headers/util.h"
+#include "headers/proto.h"
 
+#include <stdarg.h>
+#include <ctype.h>
+#include <poll.h>
 
+/*
+ * Client humain. Il annonce +DELTA +PIPELINE et tient sa propre copie de la
+ * main et des rangées: une carte absente de la main ou une rangée hors bornes
+ * est refusée sans aller-retour, la rangée à ramasser est demandée avant
+ * l'envoi si la carte en impose une, et chaque question affiche où irait
+ * chaque carte. Le socket et le clavier sont surveillés ensemble (poll): les
+ * messages du serveur s'affichent pendant la saisie, et un PING du serveur
+ * reçoit son PONG même pendant que le joueur réfléchit.
+ */
+
+typedef enum { ATTENTE, CARTE, RANGEE, RANGEE_LOCALE } Question;
+
+static int hand[HAND_SIZE];
+static int hn = -1;                // -1: main inconnue, pas de contrôle local
+static Row rows[ROWS];
+static int have_rows = 0;
+static int row_max = ROW_MAX;
+static Question question = ATTENTE;
+static int pending = 0;            // Carte envoyée, pas encore posée
+static int held_card = 0;          // Carte en attente de sa rangée (RANGEE_LOCALE)
+static FILE *out;
 
 static int est_entier_valide(const char *s) {
     while (*s && isspace((unsigned char)*s)) s++;
@@ -15,65 +39,256 @@ static int est_entier_valide(const char *s) {
     return *s == 0;
 }
 
-static int est_commande_jouer(const char *s) {
-    while (*s && isspace((unsigned char)*s)) s++;
-    if (est_entier_valide(s)) return 1;
-    if (tolower((unsigned char)s[0])=='j' &&
-        tolower((unsigned char)s[1])=='o' &&
-        tolower((unsigned char)s[2])=='u' &&
-        tolower((unsigned char)s[3])=='e' &&
-        tolower((unsigned char)s[4])=='r') return 1;
+// Rangée où la carte serait posée d'après la copie locale, -1 si elle
+// est plus petite que toutes les fins de rangée (rangée au choix).
+static int dest_row(int c) {
+    int best = -1;
+    for (int r = 0; r < ROWS; r++) {
+        if (rows[r].len == 0) continue;
+        int last = rows[r].cards[rows[r].len - 1];
+        if (last < c && (best < 0 || last > rows[best].cards[rows[best].len - 1])) best = r;
+    }
+    return best;
+}
+
+static int row_heads(const Row *r) {
+    int s = 0;
+    for (int i = 0; i < r->len; i++) s += bulls(r->cards[i]);
+    return s;
+}
+
+// Retire une carte de la main locale; 0 si elle n'y est pas.
+static int hand_take(int c) {
+    for (int i = 0; i < hn; i++)
+        if (hand[i] == c) {
+            hand[i] = hand[--hn];
+            return 1;
+        }
     return 0;
 }
 
+// Affiche la table reconstruite, la main et la destination de chaque carte
+// (sous réserve des cartes plus petites jouées avant dans le tour).
+static void show_state(int with_table) {
+    if (with_table && have_rows) {
+        for (int r = 0; r < ROWS; r++) {
+            printf("%sR%d:", r ? " | " : "", r + 1);
+            for (int k = 0; k < rows[r].len; k++) printf(" %d", rows[r].cards[k]);
+        }
+        printf("\n");
+    }
+    if (hn < 0 || !have_rows) return;
+
+    for (int i = 1; i < hn; i++)
+        for (int j = i; j > 0 && hand[j] < hand[j - 1]; j--) {
+            int t = hand[j];
+            hand[j] = hand[j - 1];
+            hand[j - 1] = t;
+        }
+    printf("Votre main:");
+    for (int i = 0; i < hn; i++) {
+        int d = dest_row(hand[i]);
+        if (d < 0) printf(" %d(choix)", hand[i]);
+        else if (rows[d].len >= row_max) printf(" %d(R%d ramasse %d)", hand[i], d + 1, row_heads(&rows[d]));
+        else printf(" %d(R%d)", hand[i], d + 1);
+    }
+    printf("\n");
+}
+
+static void prompt(void) {
+    if (question == ATTENTE) return;
+    printf("> ");
+    fflush(stdout);
+}
+
+// Extrait une ligne complète du tampon; 0 s'il n'y en a pas encore.
+static int take_line(char *buf, int *len, char *line, int cap) {
+    char *nl = memchr(buf, '\n', (size_t)*len);
+    if (!nl) {
+        if (*len == cap - 1) *len = 0;   // Ligne démesurée
+        return 0;
+    }
+    *nl = 0;
+    snprintf(line, (size_t)cap, "%s", buf);
+    trim_crlf(line);
+    *len -= (int)(nl + 1 - buf);
+    memmove(buf, nl + 1, (size_t)*len);
+    return 1;
+}
+
+// Met à jour la copie locale d'après une ligne du serveur.
+static void server_line(const char *line) {
+    if (strcmp(line, "PING") == 0) {
+        send_line(out, "PONG");
+        return;
+    }
+    printf("%s\n", line);
+
+    if (str_starts(line, "R1:")) {
+        parse_table_rows(line, rows);
+        have_rows = 1;
+    } else if (str_starts(line, "MAIN ")) {
+        hn = parse_hand(line, hand, HAND_SIZE);
+        pending = 0;
+        question = CARTE;
+        show_state(0);
+    } else if (str_starts(line, "TOUR ")) {
+        pending = 0;
+        question = CARTE;
+        show_state(1);
+    } else if (str_starts(line, "POSE ") || str_starts(line, "RAMASSE ")) {
+        apply_table_event(line, rows);
+    } else if (str_starts(line, "REGLES ")) {
+        int deck, rm;
+        if (sscanf(line, "REGLES %*s %d %d", &deck, &rm) == 2 && rm >= 1 && rm <= ROW_MAX) row_max = rm;
+    } else if (strcmp(line, "DEMANDE_CARTE") == 0) {
+        question = CARTE;
+    } else if (str_starts(line, "CHOISIR_RANGEES")) {
+        question = RANGEE;
+    } else if (str_starts(line, "ERREUR Carte")) {
+        // Refus malgré le contrôle local: la copie n'est plus fiable jusqu'à la prochaine MAIN
+        hn = -1;
+        pending = 0;
+    } else if (str_starts(line, "INFO Trop de commandes")) {
+        hn = -1;                   // Coup joué par le serveur à notre place
+    }
+}
+
+// Envoie la carte (et la rangée annoncée) et la retire de la main locale.
+static void play(int c, int r) {
+    char cmd[64];
+    if (r > 0) snprintf(cmd, sizeof(cmd), "JOUER %d %d", c, r);
+    else snprintf(cmd, sizeof(cmd), "JOUER %d", c);
+    send_line(out, cmd);
+    if (hn >= 0) hand_take(c);
+    pending = c;
+    question = ATTENTE;
+}
+
+// Traite une ligne tapée au clavier selon la question en cours.
+static void user_line(char *cmd) {
+    trim_crlf(cmd);
+    int c, r;
+
+    switch (question) {
+    case ATTENTE:
+        if (*cmd) printf("Pas de question en cours%s.\n", pending ? " (carte deja jouee)" : "");
+        return;
+
+    case CARTE:
+        if (!parse_play(cmd, &c, &r)) {
+            printf("Commande invalide. Exemple: JOUER 42 (ou juste 42, ou JOUER 3 2 pour annoncer la rangee)\n");
+            return;
+        }
+        if (hn >= 0) {
+            int held = 0;
+            for (int i = 0; i < hn; i++) held |= hand[i] == c;
+            if (!held) {
+                printf("Vous n'avez pas la carte %d.\n", c);
+                show_state(0);
+                return;
+            }
+        }
+        if (r == 0 && have_rows && dest_row(c) < 0) {
+            held_card = c;
+            question = RANGEE_LOCALE;
+            printf("La carte %d est plus petite que toutes les rangees: laquelle ramasser (1-%d)?\n", c, ROWS);
+            return;
+        }
+        play(c, r);
+        return;
+
+    case RANGEE_LOCALE:
+    case RANGEE:
+        if (!parse_int(cmd, &r) || !est_entier_valide(cmd) || r < 1 || r > ROWS) {
+            printf("Choix invalide. Entrez un numero (1-%d)\n", ROWS);
+            return;
+        }
+        if (have_rows)
+            printf("Rangee %d: %d tetes de boeuf\n", r, row_heads(&rows[r - 1]));
+        if (question == RANGEE_LOCALE) {
+            play(held_card, r);
+            return;
+        }
+        char line[16];
+        snprintf(line, sizeof(line), "%d", r);
+        send_line(out, line);
+        question = ATTENTE;
+        return;
+    }
+}
+
 int main(int argc, char **argv) {
     if (argc < 4) {
-        fprintf(stderr, "Usage: %s <host> <port> <pseudo>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <host|unix:/chemin|shm:/chemin> <port> <pseudo>\n", argv[0]);
         return 1;
     }
 
-    int fd = tcp_connect(argv[1], argv[2]);
-    if (fd < 0) die("connect");
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    FILE *in;
+    if (!net_open(argv[1], argv[2], &in, &out)) die("connect");
 
-    FILE *in = fdopen_r(fd);
-    FILE *out = fdopen_w(fd);
-    if (!in || !out) die("fdopen");
+    // shm: lecture bloquante du clavier, pas de PONG possible pendant la saisie
+    char hello[LINE_MAX];
+    snprintf(hello, sizeof(hello), "%s +DELTA +PIPELINE%s", argv[3], fileno(in) < 0 ? "" : " +PING");
+    send_line(out, hello);
 
-    send_line(out, argv[3]);
+    // Lignes du serveur lues directement sur le descripteur (poll ne voit
+    // pas le tampon de stdio); shm: pas de descripteur, lecture bloquante.
+    char buf[LINE_MAX], kbd[LINE_MAX];
+    int blen = 0, klen = 0;
+    char cmd[LINE_MAX];
 
-    char line[LINE_MAX];
-    while (recv_line(in, line, sizeof(line))) {
-        printf("%s\n", line);
+    for (;;) {
+        int fd = fileno(in);
+        char line[LINE_MAX];
 
-        if (strcmp(line, "DEMANDE_CARTE") == 0) {
-            char cmd[64];
-            for (;;) {
-                printf("> ");
-                fflush(stdout);
+        if (fd < 0) {
+            if (!recv_line(in, line, sizeof(line))) break;
+            int redir = net_follow_redirect(line, hello, &in, &out);
+            if (redir < 0) die("redirection");
+            if (redir) continue;
+            server_line(line);
+            while (question != ATTENTE) {
+                prompt();
                 if (!fgets(cmd, sizeof(cmd), stdin)) return 0;
-                trim_crlf(cmd);
-                if (est_commande_jouer(cmd)) break;
-                printf("Commande invalide. Exemple: JOUER 42 (ou juste 42)\n");
+                user_line(cmd);
             }
-            send_line(out, cmd);
+            continue;
         }
 
-        if (str_starts(line, "CHOISIR_RANGEES")) {
-            char cmd[64];
-            for (;;) {
-                printf("> ");
-                fflush(stdout);
-                if (!fgets(cmd, sizeof(cmd), stdin)) return 0;
-                trim_crlf(cmd);
-                if (est_entier_valide(cmd)) break;
-                printf("Choix invalide. Entrez un numero (1-4)\n");
+        struct pollfd pfd[2] = { { fd, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            die("poll");
+        }
+
+        if (pfd[1].revents & (POLLIN | POLLHUP)) {
+            ssize_t n = read(STDIN_FILENO, kbd + klen, sizeof(kbd) - 1 - (size_t)klen);
+            if (n <= 0) break;
+            klen += (int)n;
+            while (take_line(kbd, &klen, cmd, sizeof(kbd))) user_line(cmd);
+            prompt();
+        }
+
+        if (!(pfd[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        ssize_t n = read(fd, buf + blen, sizeof(buf) - 1 - (size_t)blen);
+        if (n <= 0) break;
+        blen += (int)n;
+
+        while (take_line(buf, &blen, line, sizeof(buf))) {
+            int redir = net_follow_redirect(line, hello, &in, &out);
+            if (redir < 0) die("redirection");
+            if (redir) {
+                blen = 0;          // La suite appartenait à l'ancien serveur
+                break;
             }
-            send_line(out, cmd);
+            server_line(line);
         }
+        prompt();
     }
 
     fclose(in);
     fclose(out);
-    close(fd);
     return 0;
 }
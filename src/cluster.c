@@ -0,0 +1,114 @@
+#include "headers/cluster.h"
+#include "headers/net.h"
+#include "headers/util.h"
+
+#include <sys/time.h>
+
+/* Côté nœud: un thread publie l'état local et mémorise la dernière cible. */
+
+static char coord_host[CLUSTER_HOST_MAX];
+static char coord_port[CLUSTER_PORT_MAX];
+static char self_host[CLUSTER_HOST_MAX];
+static char self_port[CLUSTER_PORT_MAX];
+static int self_per_table;
+static char self_variant[CLUSTER_VARIANT_MAX];
+static int self_end_score;
+static void (*read_state)(ClusterState *st);
+
+static ClusterTarget target;
+static int target_valid = 0;
+static pthread_mutex_t target_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Oublie la cible (coordinateur injoignable ou sans autre nœud).
+static void target_clear(void) {
+    pthread_mutex_lock(&target_lock);
+    target_valid = 0;
+    pthread_mutex_unlock(&target_lock);
+}
+
+// Une session avec le coordinateur, jusqu'à la première erreur.
+static void coord_session(int fd) {
+    struct timeval tv = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    FILE *in = fdopen_r(fd);
+    FILE *out = fdopen_w(fd);
+    close(fd);
+    if (!in || !out) goto done;
+
+    char line[LINE_MAX];
+    snprintf(line, sizeof(line), "NOEUD %s %s %d %s %d", self_host, self_port, self_per_table,
+             self_variant, self_end_score);
+    if (!send_line(out, line)) goto done;
+    printf("Grappe: inscrit aupres du coordinateur %s:%s\n", coord_host, coord_port);
+    fflush(stdout);
+
+    for (;;) {
+        ClusterState st;
+        read_state(&st);
+        snprintf(line, sizeof(line), "ETAT %d %d %d", st.waiting, st.free_places, st.games);
+        if (!send_line(out, line) || !recv_line(in, line, sizeof(line))) break;
+
+        ClusterTarget t;
+        int ok = sscanf(line, "CIBLE %63s %15s %d %d", t.host, t.port, &t.waiting, &t.free_places) == 4;
+        pthread_mutex_lock(&target_lock);
+        if (ok) target = t;
+        target_valid = ok;
+        pthread_mutex_unlock(&target_lock);
+
+        struct timespec ts = { CLUSTER_PERIOD_MS / 1000, (CLUSTER_PERIOD_MS % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+
+done:
+    target_clear();
+    if (in) fclose(in);
+    if (out) fclose(out);
+    printf("Grappe: coordinateur %s:%s injoignable, nouvel essai dans %d s\n",
+           coord_host, coord_port, CLUSTER_RETRY_S);
+    fflush(stdout);
+}
+
+static void *cluster_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        int fd = tcp_connect(coord_host, coord_port);
+        if (fd >= 0) coord_session(fd);
+        sleep(CLUSTER_RETRY_S);
+    }
+    return NULL;
+}
+
+// Rejoint la grappe: coord "hote:port" du coordinateur, host/port annoncés aux clients redirigés.
+int cluster_start(const char *coord, const char *host, const char *port, int per_table,
+                  const char *variant, int end_score, void (*state)(ClusterState *st)) {
+    const char *colon = strrchr(coord, ':');
+    if (!colon || colon == coord || (size_t)(colon - coord) >= sizeof(coord_host) ||
+        strlen(colon + 1) >= sizeof(coord_port) || !colon[1] ||
+        strlen(host) >= sizeof(self_host) || strlen(port) >= sizeof(self_port) ||
+        strlen(variant) >= sizeof(self_variant))
+        return 0;
+
+    memcpy(coord_host, coord, (size_t)(colon - coord));
+    coord_host[colon - coord] = 0;
+    strcpy(coord_port, colon + 1);
+    strcpy(self_host, host);
+    strcpy(self_port, port);
+    self_per_table = per_table;
+    strcpy(self_variant, variant);
+    self_end_score = end_score;
+    read_state = state;
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, cluster_thread, NULL) != 0) return 0;
+    pthread_detach(tid);
+    return 1;
+}
+
+// Dernière cible reçue du coordinateur; 0 si aucune.
+int cluster_target(ClusterTarget *t) {
+    pthread_mutex_lock(&target_lock);
+    int ok = target_valid;
+    if (ok) *t = target;
+    pthread_mutex_unlock(&target_lock);
+    return ok;
+}
@@ -0,0 +1,202 @@
+#include "headers/common.h"
+#include "headers/net.h"
+#include "headers/util.h"
+#include "headers/cluster.h"
+
+/*
+ * Coordinateur de grappe: chaque serveur lancé avec -C s'inscrit (NOEUD) puis
+ * publie son état (ETAT) chaque seconde; le coordinateur répond par le nœud
+ * vers lequel rediriger un joueur (CIBLE). Un seul thread, select() sur les
+ * nœuds; tout tient sur une machine pour les essais.
+ * Usage: ./coordinateur <port>
+ */
+
+#define NODES_MAX 64
+#define NODE_RBUF 512
+
+typedef struct {
+    int fd;                // -1: emplacement libre
+    int known;             // NOEUD reçu
+    char host[CLUSTER_HOST_MAX];
+    char port[CLUSTER_PORT_MAX];
+    int per_table;
+    char variant[CLUSTER_VARIANT_MAX];
+    int end_score;
+    int waiting;
+    int free_places;
+    int games;
+    int rlen;
+    char rbuf[NODE_RBUF];
+} Node;
+
+static Node nodes[NODES_MAX];
+
+// Mêmes règles: un joueur redirigé retrouve la taille de table et la variante.
+static int same_rules(const Node *a, const Node *b) {
+    return a->per_table == b->per_table && a->end_score == b->end_score && strcmp(a->variant, b->variant) == 0;
+}
+
+// Nœud conseillé à la place de self, parmi ceux aux mêmes règles: d'abord
+// celui dont une table attend le plus de joueurs (on la complète), sinon
+// celui qui a le plus de places.
+static const Node *best_target(const Node *self) {
+    const Node *best = NULL;
+    for (int i = 0; i < NODES_MAX; i++) {
+        const Node *n = &nodes[i];
+        if (n == self || n->fd < 0 || !n->known || n->free_places <= 0 || !same_rules(n, self)) continue;
+        if (!best ||
+            n->waiting > best->waiting ||
+            (n->waiting == best->waiting && n->free_places > best->free_places))
+            best = n;
+    }
+    return best;
+}
+
+// Répond à un ETAT par la cible courante du nœud.
+static void send_target(Node *n) {
+    char line[LINE_MAX];
+    const Node *t = best_target(n);
+    if (t)
+        snprintf(line, sizeof(line), "CIBLE %s %s %d %d\n", t->host, t->port, t->waiting, t->free_places);
+    else
+        snprintf(line, sizeof(line), "CIBLE -\n");
+    if (write(n->fd, line, strlen(line)) < 0) {}
+}
+
+// Traite une ligne reçue d'un nœud; 0 pour une ligne invalide (nœud déconnecté).
+static int node_line(Node *n, const char *line) {
+    char host[CLUSTER_HOST_MAX], port[CLUSTER_PORT_MAX], variant[CLUSTER_VARIANT_MAX] = "classique";
+    int per_table, waiting, free_places, games, end_score = END_SCORE;
+
+    // Variante et score de fin absents: nœud d'avant leur annonce, règles par défaut
+    if (sscanf(line, "NOEUD %63s %15s %d %15s %d", host, port, &per_table, variant, &end_score) >= 3) {
+        snprintf(n->host, sizeof(n->host), "%s", host);
+        snprintf(n->port, sizeof(n->port), "%s", port);
+        snprintf(n->variant, sizeof(n->variant), "%s", variant);
+        n->per_table = per_table;
+        n->end_score = end_score;
+        n->known = 1;
+        printf("[NOEUD %s:%s] inscrit (%d joueurs par partie, %s, %d points)\n", n->host, n->port, per_table,
+               n->variant, n->end_score);
+        fflush(stdout);
+        return 1;
+    }
+    if (n->known && sscanf(line, "ETAT %d %d %d", &waiting, &free_places, &games) == 3) {
+        n->waiting = waiting;
+        n->free_places = free_places;
+        n->games = games;
+        send_target(n);
+        return 1;
+    }
+    return 0;
+}
+
+// Ferme la connexion d'un nœud et libère son emplacement.
+static void node_drop(Node *n) {
+    if (n->known) printf("[NOEUD %s:%s] parti\n", n->host, n->port);
+    fflush(stdout);
+    close(n->fd);
+    n->fd = -1;
+    n->known = 0;
+}
+
+// Lit ce qui est disponible et traite les lignes complètes.
+static void node_read(Node *n) {
+    ssize_t r = read(n->fd, n->rbuf + n->rlen, sizeof(n->rbuf) - 1 - (size_t)n->rlen);
+    if (r <= 0) {
+        node_drop(n);
+        return;
+    }
+    n->rlen += (int)r;
+    n->rbuf[n->rlen] = 0;
+
+    char *start = n->rbuf;
+    char *nl;
+    while ((nl = strchr(start, '\n'))) {
+        *nl = 0;
+        trim_crlf(start);
+        if (!node_line(n, start)) {
+            node_drop(n);
+            return;
+        }
+        start = nl + 1;
+    }
+    n->rlen = (int)(n->rbuf + n->rlen - start);
+    memmove(n->rbuf, start, (size_t)n->rlen);
+    if (n->rlen == (int)sizeof(n->rbuf) - 1) node_drop(n);   // Ligne démesurée
+}
+
+// Affiche l'état de la grappe (un nœud par ligne).
+static void print_cluster(void) {
+    int total_wait = 0, total_free = 0, total_games = 0, count = 0;
+    for (int i = 0; i < NODES_MAX; i++) count += nodes[i].fd >= 0 && nodes[i].known;
+    if (!count) return;
+
+    printf("Grappe: %d noeuds\n", count);
+    for (int i = 0; i < NODES_MAX; i++) {
+        Node *n = &nodes[i];
+        if (n->fd < 0 || !n->known) continue;
+        printf("  %s:%s  en attente=%d  places libres=%d  parties=%d\n",
+               n->host, n->port, n->waiting, n->free_places, n->games);
+        total_wait += n->waiting;
+        total_free += n->free_places;
+        total_games += n->games;
+    }
+    printf("  total: en attente=%d  places libres=%d  parties=%d\n", total_wait, total_free, total_games);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <port>\n", argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    int lfd = tcp_listen(argv[1]);
+    if (lfd < 0) die("listen");
+    for (int i = 0; i < NODES_MAX; i++) nodes[i].fd = -1;
+    printf("Coordinateur: ecoute sur le port %s\n", argv[1]);
+    fflush(stdout);
+
+    double next_report = mono_now() + 10;
+    for (;;) {
+        fd_set rs;
+        FD_ZERO(&rs);
+        FD_SET(lfd, &rs);
+        int maxfd = lfd;
+        for (int i = 0; i < NODES_MAX; i++) {
+            if (nodes[i].fd < 0) continue;
+            FD_SET(nodes[i].fd, &rs);
+            if (nodes[i].fd > maxfd) maxfd = nodes[i].fd;
+        }
+
+        struct timeval tv = { 1, 0 };
+        if (select(maxfd + 1, &rs, NULL, NULL, &tv) < 0) {
+            if (errno == EINTR) continue;
+            die("select");
+        }
+
+        if (FD_ISSET(lfd, &rs)) {
+            int fd = accept(lfd, NULL, NULL);
+            int slot = -1;
+            for (int i = 0; fd >= 0 && i < NODES_MAX && slot < 0; i++)
+                if (nodes[i].fd < 0) slot = i;
+            if (slot < 0) {
+                if (fd >= 0) close(fd);
+            } else {
+                memset(&nodes[slot], 0, sizeof(nodes[slot]));
+                nodes[slot].fd = fd;
+            }
+        }
+
+        for (int i = 0; i < NODES_MAX; i++)
+            if (nodes[i].fd >= 0 && FD_ISSET(nodes[i].fd, &rs)) node_read(&nodes[i]);
+
+        if (mono_now() >= next_report) {
+            print_cluster();
+            next_report = mono_now() + 10;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/game.h"
+#include "headers/proto.h"
+
+/*
+ * Fuzzer différentiel: joue des parties aléatoires en parallèle sur le noyau
+ * spécialisé de la variante et sur le noyau de référence, puis compare l'état
+ * complet et les rendus après chaque action. Les rendus sont aussi relus par
+ * les analyseurs du protocole (aller-retour texte).
+ * Usage: ./fuzz_moteur [parties] [graine]
+ */
+
+static uint64_t fz_state;
+
+static uint64_t fz_next(void) {
+    uint64_t x = fz_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    fz_state = x;
+    return x;
+}
+
+static int fz_range(int n) {
+    return (int)(fz_next() % (uint64_t)n);
+}
+
+static uint64_t fz_game_seed;
+static int fz_game_no;
+
+// Signale une divergence avec de quoi la rejouer, puis quitte.
+static void fz_fail(const Game *g, const char *what) {
+    fprintf(stderr, "DIVERGENCE partie %d (graine %llu, variante %s, %d joueurs) manche %d tour %d: %s\n",
+            fz_game_no, (unsigned long long)fz_game_seed, g->rules.name, g->nplayers,
+            g->manche, g->tour, what);
+    exit(1);
+}
+
+// Compare l'état observable de deux parties (hors pointeur de noyau).
+static void fz_compare(const Game *a, const Game *b) {
+    if (a->top != b->top) fz_fail(a, "sommet du paquet");
+    if (memcmp(a->deck, b->deck, sizeof(a->deck)) != 0) fz_fail(a, "paquet");
+    for (int r = 0; r < ROWS; r++) {
+        if (a->rows[r].len != b->rows[r].len) fz_fail(a, "longueur de rangee");
+        if (memcmp(a->rows[r].cards, b->rows[r].cards, sizeof(int) * (size_t)a->rows[r].len) != 0)
+            fz_fail(a, "cartes de rangee");
+    }
+    if (memcmp(a->scores, b->scores, sizeof(a->scores)) != 0) fz_fail(a, "scores");
+    for (int p = 0; p < a->nplayers; p++) {
+        if (a->hand_len[p] != b->hand_len[p]) fz_fail(a, "taille de main");
+        if (memcmp(a->hands[p], b->hands[p], sizeof(int) * (size_t)a->hand_len[p]) != 0)
+            fz_fail(a, "main");
+    }
+}
+
+// Compare les rendus texte et vérifie qu'ils se relisent à l'identique.
+static void fz_compare_strings(Game *a, Game *b) {
+    char sa[LINE_MAX], sb[LINE_MAX];
+
+    a->k->table_string(a, sa, sizeof(sa));
+    b->k->table_string(b, sb, sizeof(sb));
+    if (strcmp(sa, sb) != 0) fz_fail(a, "rendu de table");
+
+    Row rows[ROWS];
+    parse_table_rows(sa, rows);
+    for (int r = 0; r < ROWS; r++) {
+        if (rows[r].len != a->rows[r].len ||
+            memcmp(rows[r].cards, a->rows[r].cards, sizeof(int) * (size_t)rows[r].len) != 0)
+            fz_fail(a, "relecture de table");
+    }
+
+    /* Un tampon court doit être tronqué de la même façon. */
+    int cap = 1 + fz_range(24);
+    a->k->table_string(a, sa, cap);
+    b->k->table_string(b, sb, cap);
+    if (strcmp(sa, sb) != 0) fz_fail(a, "rendu de table tronque");
+
+    for (int p = 0; p < a->nplayers; p++) {
+        a->k->hand_string(a, p, sa, sizeof(sa));
+        b->k->hand_string(b, p, sb, sizeof(sb));
+        if (strcmp(sa, sb) != 0) fz_fail(a, "rendu de main");
+
+        char line[LINE_MAX];
+        int cards[HAND_SIZE];
+        snprintf(line, sizeof(line), "MAIN %.1000s", sa);
+        int n = parse_hand(line, cards, HAND_SIZE);
+        if (n != a->hand_len[p] || memcmp(cards, a->hands[p], sizeof(int) * (size_t)n) != 0)
+            fz_fail(a, "relecture de main");
+    }
+}
+
+// Joue une partie complète avec des choix aléatoires identiques des deux côtés.
+static void fz_play(void) {
+    Rules rules = *rules_get((Variant)fz_range(VARIANT_COUNT));
+    int n;
+    do {
+        n = MIN_PLAYERS + fz_range(rules.max_players - MIN_PLAYERS + 1);
+    } while (!rules_check(&rules, n));
+    rules.end_score = 20 + fz_range(80);
+
+    Game a, b;
+    fz_game_seed = fz_next();
+    game_init_rules(&a, n, &rules);
+    game_reseed(&a, fz_game_seed);
+    b = a;
+    b.k = game_reference_kernel();
+
+    game_setup_rows(&a);
+    game_setup_rows(&b);
+    a.k->deal(&a);
+    b.k->deal(&b);
+    fz_compare(&a, &b);
+
+    while (!game_over(&a, rules.end_score)) {
+        fz_compare_strings(&a, &b);
+
+        for (int p = 0; p < n; p++) {
+            int c = a.hands[p][fz_range(a.hand_len[p])];
+            game_hand_remove(&a, p, c);
+            game_hand_remove(&b, p, c);
+            a.carte_jouee[p] = b.carte_jouee[p] = c;
+        }
+
+        int order[MAX_PLAYERS];
+        for (int i = 0; i < n; i++) order[i] = i;
+        for (int i = 1; i < n; i++)
+            for (int j = i; j > 0 && a.carte_jouee[order[j]] < a.carte_jouee[order[j - 1]]; j--) {
+                int t = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = t;
+            }
+
+        for (int k = 0; k < n; k++) {
+            int pid = order[k];
+            int chosen = fz_range(ROWS + 2) - 1; /* -1 et ROWS testent le choix par défaut */
+            int ra, ba, rb, bb;
+            a.k->place(&a, pid, a.carte_jouee[pid], chosen, &ra, &ba);
+            b.k->place(&b, pid, b.carte_jouee[pid], chosen, &rb, &bb);
+            if (ra != rb || ba != bb) fz_fail(&a, "rangee ou boeufs ramasses");
+            fz_compare(&a, &b);
+        }
+
+        a.tour++;
+        b.tour++;
+        if (a.tour > rules.hand_size) {
+            game_next_manche(&a);
+            /* game_next_manche passe par le noyau de b pour la donne */
+            game_next_manche(&b);
+            if (a.fin != b.fin) fz_fail(&a, "fin de paquet");
+            fz_compare(&a, &b);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int games = 10000;
+    int seed = 12345;
+
+    if ((argc > 1 && (!parse_int(argv[1], &games) || games <= 0)) ||
+        (argc > 2 && !parse_int(argv[2], &seed))) {
+        fprintf(stderr, "Usage: %s [parties] [graine]\n", argv[0]);
+        return 1;
+    }
+
+    fz_state = (uint64_t)(unsigned)seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (fz_game_no = 1; fz_game_no <= games; fz_game_no++)
+        fz_play();
+
+    printf("fuzz_moteur: %d parties sans divergence (graine %d)\n", games, seed);
+    return 0;
+}
@@ -4,9 +4,9 @@
 int bulls(int c) {
  if (c == 55) return 7; // Carte spéciale 55 qui 7 têtes de bœufs
  if (c % 11 == 0) return 5; // Multiple de 11 qui 5 points
- if (c % 10 == 0) return 3; 
- if (c % 5 == 0) return 2; 
- return 1; 
+ if (c % 10 == 0) return 3;
+ if (c % 5 == 0) return 2;
+ return 1;
 }
 
 // Échange de deux entiers (utilisé pour le mélange et le tri)
@@ -16,33 +16,81 @@ static void swap_int(int *a, int *b) {
  *b = t;
 }
 
+// Descripteurs des variantes prises en charge (indexés par Variant).
+static const Rules rules_table[VARIANT_COUNT] = {
+ [VARIANT_CLASSIQUE] = { VARIANT_CLASSIQUE, "classique", DECK_SIZE, ROW_MAX, HAND_SIZE, 10, END_SCORE, 0 },
+ [VARIANT_PRO] = { VARIANT_PRO, "pro", 0, ROW_MAX, HAND_SIZE, 10, END_SCORE, 1 },
+ [VARIANT_ETENDU] = { VARIANT_ETENDU, "etendu", DECK_MAX, ROW_MAX, HAND_SIZE, MAX_PLAYERS, END_SCORE, 0 },
+ [VARIANT_COURTES] = { VARIANT_COURTES, "courtes", DECK_SIZE, 4, HAND_SIZE, 10, END_SCORE, 0 },
+};
+
+// Retourne le descripteur d’une variante (classique si inconnue).
+const Rules *rules_get(Variant v) {
+ if ((int)v < 0 || v >= VARIANT_COUNT) v = VARIANT_CLASSIQUE;
+ return &rules_table[v];
+}
+
+// Recherche une variante par son nom et copie son descripteur.
+int rules_lookup(const char *name, Rules *out) {
+ for (int v = 0; v < VARIANT_COUNT; v++) {
+ if (strcmp(rules_table[v].name, name) == 0) {
+ *out = rules_table[v];
+ return 1;
+ }
+ }
+ return 0;
+}
+
+// Vérifie que les règles permettent une partie à nplayers joueurs.
+int rules_check(const Rules *r, int nplayers) {
+ if (nplayers < MIN_PLAYERS || nplayers > r->max_players || nplayers > MAX_PLAYERS) return 0;
+ if (r->row_max < 1 || r->row_max > ROW_MAX) return 0;
+ if (r->hand_size < 1 || r->hand_size > HAND_SIZE) return 0;
+ if (r->end_score <= 0) return 0;
+
+ int need = ROWS + nplayers * r->hand_size;
+ int have = r->deck_size ? r->deck_size : need;
+ return have >= need && have <= DECK_MAX;
+}
+
+// Générateur xorshift64* propre à chaque partie (rand() est partagé entre threads).
+static uint64_t next_rand(Game *g) {
+ uint64_t x = g->rng;
+ x ^= x >> 12;
+ x ^= x << 25;
+ x ^= x >> 27;
+ g->rng = x;
+ return x * 0x2545F4914F6CDD1DULL;
+}
 
 // Mélange aléatoire du paquet de cartes
 void game_shuffle(Game *g) {
- // Initialisation du générateur pseudo-aléatoire
- // time(NULL) + PID pour éviter les répétitions
- srand((unsigned)time(NULL) ^ (unsigned)getpid());
-
  // Algorithme de Fisher-Yates
- for (int i = DECK_SIZE - 1; i > 0; i--) {
- int j = rand() % (i + 1);
+ for (int i = g->deck_len - 1; i > 0; i--) {
+ int j = (int)(next_rand(g) % (uint64_t)(i + 1));
  swap_int(&g->deck[i], &g->deck[j]);
  }
 }
 
+static const GameKernel kernels[VARIANT_COUNT];
 
-// Initialisation complète d’une partie
+// Initialisation complète d’une partie (règles classiques)
 void game_init(Game *g, int nplayers) {
- memset(g, 0, sizeof(*g)); // Remise à zéro de toute la structure Game
- g->nplayers = nplayers; // Nombre de joueurs
+ game_init_rules(g, nplayers, rules_get(VARIANT_CLASSIQUE));
+}
 
- // Initialisation du deck avec les cartes 1 à 104
- for (int i = 0; i < DECK_SIZE; i++) g->deck[i] = i + 1;
+// Initialisation complète d’une partie selon un descripteur de règles
+void game_init_rules(Game *g, int nplayers, const Rules *r) {
+ static unsigned long seq = 0;
 
- g->top = 0; // Indice du sommet du paquet
+ memset(g, 0, sizeof(*g)); // Remise à zéro de toute la structure Game
+ g->nplayers = nplayers; // Nombre de joueurs
+ g->rules = *r;
+ g->k = &kernels[r->id]; // Noyaux spécialisés pour la variante
+ g->deck_len = r->deck_size ? r->deck_size : nplayers * r->hand_size + ROWS;
 
  // Initialisation des rangées
- for (int r = 0; r < ROWS; r++) g->rows[r].len = 0;
+ for (int i = 0; i < ROWS; i++) g->rows[i].len = 0;
 
  // Initialisation des joueurs
  for (int p = 0; p < MAX_PLAYERS; p++) {
@@ -55,6 +103,20 @@ void game_init(Game *g, int nplayers) {
  g->tour = 1; // Premier tour
  g->fin = 0; // Partie non terminée
 
+ // Graine: time(NULL) + PID + compteur pour éviter les répétitions
+ unsigned long n = __atomic_add_fetch(&seq, 1, __ATOMIC_RELAXED);
+ game_reseed(g, ((uint64_t)time(NULL) << 20) ^ ((uint64_t)getpid() << 40) ^ n);
+}
+
+// Remet le paquet dans l’ordre puis le mélange avec une graine donnée
+void game_reseed(Game *g, uint64_t seed) {
+ g->rng = seed * 0x9E3779B97F4A7C15ULL + 1; // Jamais nul pour xorshift
+ if (!g->rng) g->rng = 1;
+
+ // Initialisation du deck avec les cartes 1 à deck_len
+ for (int i = 0; i < g->deck_len; i++) g->deck[i] = i + 1;
+ g->top = 0; // Indice du sommet du paquet
+
  game_shuffle(g); // Mélange du paquet
 }
 
@@ -68,23 +130,28 @@ void game_setup_rows(Game *g) {
 
 // Distribution des cartes aux joueurs
 void game_deal(Game *g) {
- for (int p = 0; p < g->nplayers; p++) {
- g->hand_len[p] = HAND_SIZE; // Chaque joueur reçoit HAND_SIZE cartes
+ g->k->deal(g);
+}
 
- // Distribution des cartes
- for (int k = 0; k < HAND_SIZE; k++) {
- g->hands[p][k] = g->deck[g->top++];
+// Passe à la manche suivante; renvoie 0 si le paquet ne suffit plus.
+int game_next_manche(Game *g) {
+ g->manche++;
+ g->tour = 1;
+
+ if (g->rules.reshuffle) {
+ // Variante pro: toutes les cartes reviennent dans le paquet
+ g->top = 0;
+ game_shuffle(g);
+ } else if (g->top + ROWS + g->nplayers * g->rules.hand_size > g->deck_len) {
+ g->fin = 1;
+ return 0;
  }
 
- // Tri de la main du joueur (ordre croissant)
- for (int i = 0; i < HAND_SIZE; i++) {
- for (int j = i + 1; j < HAND_SIZE; j++) {
- if (g->hands[p][j] < g->hands[p][i])
- swap_int(&g->hands[p][i], &g->hands[p][j]);
- }
- }
- }
+ game_setup_rows(g);
+ game_deal(g);
+ return 1;
 }
+
 // Vérifie si une carte c est présente dans la main du joueur pid
 int game_hand_has(Game *g, int pid, int c) {
  for (int i = 0; i < g->hand_len[pid]; i++)
@@ -157,11 +224,84 @@ static int min_bulls_row(Game *g) {
  return best;
 }
 
+// Rangée où irait la carte c (-1 si elle doit en ramasser une)
+int game_best_row(Game *g, int c, int *out_diff) {
+ return best_row_for_card(g, c, out_diff);
+}
+
 // Placement d’une carte pour un joueur
 int game_place_card(Game *g, int pid, int c,
  int chosen_row_if_needed,
  int *out_row_taken,
  int *out_bulls_taken) {
+ return g->k->place(g, pid, c, chosen_row_if_needed, out_row_taken, out_bulls_taken);
+}
+
+
+
+// Vérifie si la partie est terminée
+int game_over(Game *g, int limit) {
+ for (int p = 0; p < g->nplayers; p++)
+ if (g->scores[p] >= limit) return 1;
+
+ if (g->fin) return 1;
+ return 0;
+}
+
+// Génère une chaîne représentant l’état de la table
+void game_table_string(Game *g, char *buf, int cap) {
+ g->k->table_string(g, buf, cap);
+}
+
+// Génère une chaîne représentant la main d’un joueur
+void game_hand_string(Game *g, int pid, char *buf, int cap) {
+ g->k->hand_string(g, pid, buf, cap);
+}
+
+// Génère une chaîne représentant les scores
+void game_score_string(Game *g, char *buf, int cap) {
+ char tmp[64];
+ buf[0] = 0;
+
+ for (int p = 0; p < g->nplayers; p++) {
+ snprintf(tmp, sizeof(tmp), "J%d=%d", p+1, g->scores[p]);
+ strncat(buf, tmp, cap - (int)strlen(buf) - 1);
+ if (p + 1 < g->nplayers)
+ strncat(buf, " ", cap - (int)strlen(buf) - 1);
+ }
+}
+
+/*
+ * Noyaux spécialisés par variante.
+ * Les corps *_impl reçoivent les paramètres de la variante en constantes:
+ * chaque GAME_KERNEL() en instancie une copie où row_max et hand_size sont
+ * repliés par le compilateur, comme l’étaient ROW_MAX et HAND_SIZE.
+ */
+
+// Distribution et tri des mains (tri par insertion, hand_size connu).
+static inline void deal_impl(Game *g, const int hand_size) {
+ for (int p = 0; p < g->nplayers; p++) {
+ int *h = g->hands[p];
+ g->hand_len[p] = hand_size; // Chaque joueur reçoit hand_size cartes
+
+ for (int k = 0; k < hand_size; k++) {
+ int v = g->deck[g->top++];
+ int i = k;
+ while (i > 0 && h[i - 1] > v) {
+ h[i] = h[i - 1];
+ i--;
+ }
+ h[i] = v;
+ }
+ }
+}
+
+// Placement d’une carte avec une longueur de rangée constante.
+static inline int place_impl(Game *g, int pid, int c,
+ int chosen_row_if_needed,
+ int *out_row_taken,
+ int *out_bulls_taken,
+ const int row_max) {
 
  int taken_row = -1; // Rangée ramassée
  int bulls_taken = 0; // Points gagnés
@@ -180,8 +320,8 @@ int game_place_card(Game *g, int pid, int c,
  g->rows[cr].len = 1;
  g->rows[cr].cards[0] = c;
  } else {
- // Cas où la rangée est pleine (6ème carte)
- if (g->rows[r].len == ROW_MAX) {
+ // Cas où la rangée est pleine (carte row_max + 1)
+ if (g->rows[r].len == row_max) {
  taken_row = r;
  bulls_taken = row_bulls(&g->rows[r]);
  g->scores[pid] += bulls_taken;
@@ -201,19 +341,145 @@ int game_place_card(Game *g, int pid, int c,
  return 1;
 }
 
+// Écrit un entier positif en décimal et renvoie le nombre de caractères.
+static inline int put_uint(char *p, int v) {
+ char t[12];
+ int n = 0;
+ do {
+ t[n++] = (char)('0' + v % 10);
+ v /= 10;
+ } while (v > 0);
+ for (int i = 0; i < n; i++) p[i] = t[n - 1 - i];
+ return n;
+}
 
+// Copie tronquée à cap - 1 caractères, comme strncat sur un tampon vide.
+static void copy_capped(char *buf, int cap, const char *src, int n) {
+ if (cap <= 0) return;
+ if (n > cap - 1) n = cap - 1;
+ memcpy(buf, src, (size_t)n);
+ buf[n] = 0;
+}
 
-// Vérifie si la partie est terminée
-int game_over(Game *g, int limit) {
- for (int p = 0; p < g->nplayers; p++)
- if (g->scores[p] >= limit) return 1;
+// Rendu de la table sans strncat (rangées d’au plus row_max cartes).
+static inline void table_impl(Game *g, char *buf, int cap, const int row_max) {
+ char tmp[ROWS * (8 + ROW_MAX * 12)];
+ char *p = tmp;
 
- if (g->fin) return 1;
- return 0;
+ for (int r = 0; r < ROWS; r++) {
+ int len = g->rows[r].len;
+ if (len > row_max) len = row_max;
+ *p++ = 'R';
+ p += put_uint(p, r + 1);
+ *p++ = ':';
+ for (int i = 0; i < len; i++) {
+ *p++ = ' ';
+ p += put_uint(p, g->rows[r].cards[i]);
+ }
+ memcpy(p, " | ", 3);
+ p += 3;
+ }
+ copy_capped(buf, cap, tmp, (int)(p - tmp));
 }
 
-// Génère une chaîne représentant l’état de la table
-void game_table_string(Game *g, char *buf, int cap) {
+// Rendu de la main d’un joueur (au plus hand_size cartes).
+static inline void hand_impl(Game *g, int pid, char *buf, int cap, const int hand_size) {
+ char tmp[HAND_SIZE * 12 + 1];
+ char *p = tmp;
+ int n = g->hand_len[pid];
+ if (n > hand_size) n = hand_size;
+
+ for (int i = 0; i < n; i++) {
+ if (i > 0) *p++ = ' ';
+ p += put_uint(p, g->hands[pid][i]);
+ }
+ copy_capped(buf, cap, tmp, (int)(p - tmp));
+}
+
+#define GAME_KERNEL(nom, RMAX, HSIZE) \
+ static int place_##nom(Game *g, int pid, int c, int cr, int *orow, int *obulls) { \
+ return place_impl(g, pid, c, cr, orow, obulls, RMAX); \
+ } \
+ static void deal_##nom(Game *g) { deal_impl(g, HSIZE); } \
+ static void table_##nom(Game *g, char *buf, int cap) { table_impl(g, buf, cap, RMAX); } \
+ static void hand_##nom(Game *g, int pid, char *buf, int cap) { hand_impl(g, pid, buf, cap, HSIZE); }
+
+GAME_KERNEL(classique, ROW_MAX, HAND_SIZE)
+GAME_KERNEL(courtes, 4, HAND_SIZE)
+
+#define KERNEL_ENTRY(nom) { place_##nom, deal_##nom, table_##nom, hand_##nom }
+
+// Table de dispatch: pro et étendu partagent les constantes du classique.
+static const GameKernel kernels[VARIANT_COUNT] = {
+ [VARIANT_CLASSIQUE] = KERNEL_ENTRY(classique),
+ [VARIANT_PRO] = KERNEL_ENTRY(classique),
+ [VARIANT_ETENDU] = KERNEL_ENTRY(classique),
+ [VARIANT_COURTES] = KERNEL_ENTRY(courtes),
+};
+
+/*
+ * Noyau de référence: implémentation générique d’origine, paramètres lus
+ * dans g->rules à l’exécution. Sert d’oracle au fuzzer différentiel
+ * (voir src/fuzz.c); ne pas l’optimiser.
+ */
+
+static int place_ref(Game *g, int pid, int c,
+ int chosen_row_if_needed,
+ int *out_row_taken,
+ int *out_bulls_taken) {
+
+ int taken_row = -1;
+ int bulls_taken = 0;
+
+ int r = best_row_for_card(g, c, NULL);
+ if (r < 0) {
+ int cr = chosen_row_if_needed;
+ if (cr < 0 || cr >= ROWS) cr = min_bulls_row(g);
+
+ taken_row = cr;
+ bulls_taken = row_bulls(&g->rows[cr]);
+ g->scores[pid] += bulls_taken;
+
+ g->rows[cr].len = 1;
+ g->rows[cr].cards[0] = c;
+ } else {
+ if (g->rows[r].len == g->rules.row_max) {
+ taken_row = r;
+ bulls_taken = row_bulls(&g->rows[r]);
+ g->scores[pid] += bulls_taken;
+
+ g->rows[r].len = 1;
+ g->rows[r].cards[0] = c;
+ } else {
+ g->rows[r].cards[g->rows[r].len++] = c;
+ }
+ }
+
+ if (out_row_taken) *out_row_taken = taken_row;
+ if (out_bulls_taken) *out_bulls_taken = bulls_taken;
+
+ return 1;
+}
+
+static void deal_ref(Game *g) {
+ int hand_size = g->rules.hand_size;
+ for (int p = 0; p < g->nplayers; p++) {
+ g->hand_len[p] = hand_size;
+
+ for (int k = 0; k < hand_size; k++) {
+ g->hands[p][k] = g->deck[g->top++];
+ }
+
+ for (int i = 0; i < hand_size; i++) {
+ for (int j = i + 1; j < hand_size; j++) {
+ if (g->hands[p][j] < g->hands[p][i])
+ swap_int(&g->hands[p][i], &g->hands[p][j]);
+ }
+ }
+ }
+}
+
+static void table_ref(Game *g, char *buf, int cap) {
  char tmp[256];
  buf[0] = 0;
 
@@ -229,8 +495,7 @@ void game_table_string(Game *g, char *buf, int cap) {
  }
 }
 
-// Génère une chaîne représentant la main d’un joueur
-void game_hand_string(Game *g, int pid, char *buf, int cap) {
+static void hand_ref(Game *g, int pid, char *buf, int cap) {
  char tmp[64];
  buf[0] = 0;
 
@@ -242,15 +507,9 @@ void game_hand_string(Game *g, int pid, char *buf, int cap) {
  }
 }
 
-// Génère une chaîne représentant les scores
-void game_score_string(Game *g, char *buf, int cap) {
- char tmp[64];
- buf[0] = 0;
+static const GameKernel reference_kernel = { place_ref, deal_ref, table_ref, hand_ref };
 
- for (int p = 0; p < g->nplayers; p++) {
- snprintf(tmp, sizeof(tmp), "J%d=%d", p+1, g->scores[p]);
- strncat(buf, tmp, cap - (int)strlen(buf) - 1);
- if (p + 1 < g->nplayers)
- strncat(buf, " ", cap - (int)strlen(buf) - 1);
- }
-}
\ No newline at end of file
+// Noyau générique de référence (pour les tests différentiels).
+const GameKernel *game_reference_kernel(void) {
+ return &reference_kernel;
+}
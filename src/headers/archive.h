@@ -0,0 +1,72 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "common.h"
+
+/*
+ * Archive des journaux de partie: quelques gros segments en ajout seul
+ * (seg_NNNNNN.dat) et un index à accès direct (index.dat) où l'entrée
+ * de la partie N est à l'offset (N-1) * sizeof(ArchiveEntry).
+ *
+ * Une partie en cours écrit son journal par morceaux (ArchiveStream, au plus
+ * ARCHIVE_CHUNK_MAX octets chacun): chaque morceau est précédé d'un
+ * ArchiveChunk qui désigne le précédent, et l'entrée d'index publiée en fin
+ * de partie désigne le dernier (ARCHIVE_CHAINED). Les morceaux d'une partie
+ * sans entrée (processus arrêté) restent dans le segment, jamais lus. Une
+ * entrée sans ARCHIVE_CHAINED (archive plus ancienne) désigne un bloc unique.
+ */
+
+#define ARCHIVE_DIR "logs/archive"
+#define ARCHIVE_SEGMENT_MAX (64ULL << 20)
+
+#define ARCHIVE_ZLIB 0x1      // Bloc compressé avec zlib (au moins un morceau si ARCHIVE_CHAINED)
+#define ARCHIVE_CHAINED 0x2   // Morceaux chaînés à rebours depuis segment/offset
+#define ARCHIVE_CHUNK_MAX 4096   // Journal tenu en mémoire par partie avant envoi d'un morceau
+
+typedef struct {
+    uint32_t game_id;      // 0: emplacement vide (partie non archivée)
+    uint32_t segment;
+    uint64_t offset;
+    uint32_t stored_size;  // Octets dans le segment
+    uint32_t raw_size;     // Octets une fois décompressé
+    int64_t start_time;
+    int64_t end_time;
+    uint32_t flags;
+    uint32_t reserved;
+} ArchiveEntry;
+
+// En-tête d'un morceau dans le segment, suivi de stored_size octets.
+typedef struct {
+    uint32_t game_id;
+    uint32_t stored_size;
+    uint32_t raw_size;
+    uint32_t flags;        // ARCHIVE_ZLIB
+    uint32_t prev_segment; // 0: premier morceau de la partie
+    uint32_t reserved;
+    uint64_t prev_offset;
+} ArchiveChunk;
+
+typedef struct Archive Archive;
+typedef struct ArchiveStream ArchiveStream;
+typedef struct ArchiveReader ArchiveReader;
+
+typedef int (*ArchiveScanFn)(const ArchiveEntry *e, const char *data, size_t len, void *ctx);
+
+Archive *archive_open(const char *dir, uint64_t segment_max, int compress);
+int archive_last_id(const Archive *a);
+void archive_close(Archive *a);
+
+ArchiveStream *archive_stream_open(Archive *a, int game_id);
+int archive_stream_append(ArchiveStream *s, const char *data, size_t len);
+int archive_stream_commit(ArchiveStream *s, time_t start, time_t end);
+void archive_stream_abort(ArchiveStream *s);
+
+ArchiveReader *archive_reader_open(const char *dir);
+int archive_reader_count(const ArchiveReader *r);
+const ArchiveEntry *archive_entry(const ArchiveReader *r, int game_id);
+const char *archive_read(ArchiveReader *r, int game_id, size_t *len);
+int archive_scan(ArchiveReader *r, time_t from, time_t to, ArchiveScanFn fn, void *ctx);
+int archive_scan_index(ArchiveReader *r, time_t from, time_t to, ArchiveScanFn fn, void *ctx);
+void archive_reader_close(ArchiveReader *r);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "common.h"
+
+/*
+ * Grappe de serveurs. Protocole ligne à ligne avec le coordinateur:
+ *   nœud -> coordinateur   NOEUD <hote> <port> <joueurs_par_partie> <variante> <score_fin>
+ *                                                                     (à l'inscription)
+ *                          ETAT <en_attente> <places_libres> <parties> (chaque seconde)
+ *   coordinateur -> nœud   CIBLE <hote> <port> <en_attente> <places_libres> | CIBLE -
+ * Seuls les nœuds aux mêmes règles (taille de table, variante, score de fin)
+ * échangent leurs joueurs. Un nœud plein, ou qui laisserait un joueur seul alors qu'une table attend
+ * ailleurs, répond au client "INFO REDIRECT <hote> <port>".
+ */
+
+#define CLUSTER_HOST_MAX 64
+#define CLUSTER_PORT_MAX 16
+#define CLUSTER_VARIANT_MAX 16
+#define CLUSTER_PERIOD_MS 1000
+#define CLUSTER_RETRY_S 2
+
+typedef struct {
+    int waiting;
+    int free_places;
+    int games;
+} ClusterState;
+
+typedef struct {
+    char host[CLUSTER_HOST_MAX];
+    char port[CLUSTER_PORT_MAX];
+    int waiting;
+    int free_places;
+} ClusterTarget;
+
+int cluster_start(const char *coord, const char *host, const char *port, int per_table,
+                  const char *variant, int end_score, void (*state)(ClusterState *st));
+int cluster_target(ClusterTarget *t);
+
+#endif
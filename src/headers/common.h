@@ -1,7 +1,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#define _POSIX_C_SOURCE 200112L
+#define _POSIX_C_SOURCE 200809L
 
 
 #include <stdio.h>
@@ -32,13 +32,15 @@
 
 
 
-#define MAX_PLAYERS 10
+#define MAX_PLAYERS 12
 #define MIN_PLAYERS 2
 
 #define DECK_SIZE 104
+#define DECK_MAX 124
 #define ROWS 4
 #define ROW_MAX 5
 #define HAND_SIZE 10
+#define END_SCORE 66
 
 #define LINE_MAX 2048
 #define PLAYER_NAME_MAX 32
@@ -8,8 +8,40 @@ typedef struct {
     int len;
 } Row;
 
+// Variantes de règles connues du serveur (une table de noyaux par variante).
+typedef enum {
+    VARIANT_CLASSIQUE = 0,
+    VARIANT_PRO,
+    VARIANT_ETENDU,
+    VARIANT_COURTES,
+    VARIANT_COUNT
+} Variant;
+
+// Descripteur de règles choisi par table au lancement de la partie.
+typedef struct {
+    Variant id;
+    const char *name;
+    int deck_size;   // cartes 1..deck_size (0 = nplayers*hand_size + ROWS, variante pro)
+    int row_max;     // la (row_max+1)-ième carte ramasse la rangée
+    int hand_size;
+    int max_players;
+    int end_score;
+    int reshuffle;   // paquet complet remélangé à chaque manche
+} Rules;
+
+typedef struct Game Game;
+
+// Fonctions chaudes spécialisées pour une variante donnée.
 typedef struct {
-    int deck[DECK_SIZE];
+    int (*place)(Game *g, int pid, int c, int chosen_row_if_needed, int *out_row_taken, int *out_bulls_taken);
+    void (*deal)(Game *g);
+    void (*table_string)(Game *g, char *buf, int cap);
+    void (*hand_string)(Game *g, int pid, char *buf, int cap);
+} GameKernel;
+
+struct Game {
+    int deck[DECK_MAX];
+    int deck_len;
     int top;
 
     Row rows[ROWS];
@@ -24,18 +56,30 @@ typedef struct {
     int fin;
 
     int carte_jouee[MAX_PLAYERS];
-} Game;
+
+    Rules rules;
+    const GameKernel *k;
+    uint64_t rng;
+};
+
+const Rules *rules_get(Variant v);
+int rules_lookup(const char *name, Rules *out);
+int rules_check(const Rules *r, int nplayers);
 
 int bulls(int c);
 
 void game_init(Game *g, int nplayers);
+void game_init_rules(Game *g, int nplayers, const Rules *r);
+void game_reseed(Game *g, uint64_t seed);
 void game_shuffle(Game *g);
 void game_setup_rows(Game *g);
 void game_deal(Game *g);
+int game_next_manche(Game *g);
 
 int game_hand_has(Game *g, int pid, int c);
 int game_hand_remove(Game *g, int pid, int c);
 
+int game_best_row(Game *g, int c, int *out_diff);
 int game_place_card(Game *g, int pid, int c, int chosen_row_if_needed, int *out_row_taken, int *out_bulls_taken);
 
 void game_apply_turn(Game *g, int chosen_row[MAX_PLAYERS], int out_taken_row[MAX_PLAYERS], int out_bulls[MAX_PLAYERS]);
@@ -46,4 +90,6 @@ void game_table_string(Game *g, char *buf, int cap);
 void game_hand_string(Game *g, int pid, char *buf, int cap);
 void game_score_string(Game *g, char *buf, int cap);
 
+const GameKernel *game_reference_kernel(void);
+
 #endif
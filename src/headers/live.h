@@ -0,0 +1,65 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include "common.h"
+#include "game.h"
+#include "stats.h"
+
+#include <stdatomic.h>
+
+/*
+ * Vue en direct des parties, pour le socket d'administration (-a). Chaque
+ * thread de partie publie l'état de sa table en début de tour dans un
+ * seqlock (un seul écrivain, jamais de verrou); un lecteur recopie la vue et
+ * recommence si un tour a été publié pendant la copie. Le registre des
+ * parties n'est verrouillé qu'au démarrage et à la fin d'une partie, et par
+ * un lecteur le temps de marquer les parties qu'il lit (readers): la copie
+ * se fait hors verrou, live_remove attend seulement les lecteurs de sa partie.
+ * Chaque session d'administration a son thread (LIVE_SESSIONS_MAX au plus).
+ * Commandes, une par ligne, réponses terminées par "FIN":
+ *   PARTIES          une ligne PARTIE par partie en cours
+ *   PARTIE <id>      rangées, scores et sièges d'une partie
+ *   JOUEUR <pseudo>  statistiques persistantes d'un joueur (-J)
+ *   CLASSEMENT [n]   les n meilleurs Elo (défaut 10)
+ */
+
+#define LIVE_IDLE_S 30              // Session d'administration inactive fermée
+#define LIVE_SESSIONS_MAX 16        // Sessions simultanées, les suivantes sont refusées
+
+typedef enum { SEAT_HUMAN, SEAT_BOT, SEAT_TAKEN_OVER } SeatState;
+
+typedef struct {
+    char name[PLAYER_NAME_MAX];
+    SeatState state;
+    int score;
+    int hand_len;
+    int card;              // Carte jouée au tour précédent, -1 sinon
+} LiveSeat;
+
+typedef struct {
+    int game_id;
+    char variant[16];
+    int nplayers;
+    int manche;
+    int tour;
+    int64_t started;       // time()
+    Row rows[ROWS];
+    LiveSeat seats[MAX_PLAYERS];
+} GameView;
+
+typedef struct LiveGame {
+    _Atomic unsigned seq;  // Impair: publication en cours
+    int game_id;           // Fixe pendant la partie, lisible sans le seqlock
+    int readers;           // Lecteurs en cours de copie (live_lock)
+    GameView view;
+    struct LiveGame *prev;
+    struct LiveGame *next;
+} LiveGame;
+
+void live_add(LiveGame *lg, const GameView *v);
+void live_remove(LiveGame *lg);
+void live_publish(LiveGame *lg, const GameView *v);
+void live_read(LiveGame *lg, GameView *out);
+int live_admin_start(const char *path, StatsStore *stats);
+
+#endif
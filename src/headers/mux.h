@@ -0,0 +1,50 @@
+#ifndef MUX_H
+#define MUX_H
+
+#include "common.h"
+#include "net.h"
+
+/*
+ * Sessions multiplexées (+MUX): une connexion tient plusieurs sièges, chacun
+ * à sa propre table. Chaque siège est une connexion virtuelle (ConnOps) que
+ * le thread de partie utilise comme un socket ordinaire: ses lignes partent
+ * préfixées de "@<partie>.<joueur> " (numéro de joueur à la table: une
+ * session peut tenir plusieurs places d'une même partie) dans la sortie
+ * commune de la session, vidée par un thread d'écriture à travers le
+ * transport de la connexion (TCP, io_uring, socket local ou mémoire
+ * partagée: jamais d'écriture directe sur le descripteur); un thread de
+ * lecture aiguille les réponses "@<partie>.<joueur> ..." vers le siège.
+ * Commandes de session (sans préfixe):
+ *   JOINDRE [n]      ouvre n sièges de plus (défaut 1), pseudos "pseudo.k"
+ * Réponses de session: "INFO <n> sieges en attente", "ERREUR ...".
+ * Un siège dont la partie est finie reçoit "@<partie>.<joueur> FIN".
+ */
+
+#define MUX_SEATS_MAX 1024          // Sièges ouverts à la fois par session
+#define MUX_OUT_MAX (256 * 1024)    // Sortie commune d'une session (lignes complètes)
+#define MUX_IN_MAX 1024             // Réponses en attente de lecture, par siège
+#define MUX_WRITE_WAIT_MS 1000      // Attente d'écriture avant de revérifier la session
+
+typedef struct MuxSession MuxSession;
+
+// Rappels du serveur: placement d'un siège en file d'attente (1 si placé;
+// variant: celle demandée au hello de la session) et restitution de la
+// connexion de session une fois tout fermé.
+typedef struct {
+    int (*join)(MuxSession *s, const char *name, int caps, int variant, uint32_t addr);
+    void (*release)(Conn *sock);
+} MuxHooks;
+
+typedef struct {
+    long sessions;         // Sessions ouvertes
+    long seats;            // Sièges ouverts, toutes sessions
+    long dropped;          // Réponses perdues: siège inconnu ou entrée pleine
+} MuxStats;
+
+int mux_session_start(Conn *sock, const char *name, int caps, int variant, uint32_t addr, const MuxHooks *h);
+int mux_chan_init(Conn *c, MuxSession *s);
+void mux_bind(Conn *c, int gid, int player);
+int conn_is_mux(const Conn *c);
+void mux_stats(MuxStats *st);
+
+#endif
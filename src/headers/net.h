@@ -5,10 +5,81 @@
 
 int tcp_listen(const char *port);
 int tcp_connect(const char *host, const char *port);
+int unix_listen(const char *path);
+int unix_connect(const char *path);
 FILE *fdopen_r(int fd);
 FILE *fdopen_w(int fd);
 
+// Sondes TCP keepalive des sockets acceptés (-K); idle_s == 0: désactivées.
+typedef struct {
+    int idle_s;            // Silence avant la première sonde
+    int interval_s;        // Écart entre deux sondes
+    int count;             // Sondes sans réponse avant de déclarer le pair mort
+} Keepalive;
+
+int tcp_keepalive(int fd, const Keepalive *k);
+
 int send_line(FILE *out, const char *line);
 int recv_line(FILE *in, char *buf, int cap);
 
+#define CONN_RBUF 200   // sizeof(Conn) == 256: quatre lignes de cache
+
+// File de sortie d'une connexion: les écritures ne bloquent jamais, le
+// surplus attend ici. Au-dessus de CONN_OUTQ_HIGH le client est marqué lent,
+// il ne redevient normal que sous CONN_OUTQ_LOW; au-delà de CONN_OUTQ_MAX
+// l'envoi échoue.
+#define CONN_OUTQ_MAX (64 * 1024)
+#define CONN_OUTQ_HIGH (16 * 1024)
+#define CONN_OUTQ_LOW (4 * 1024)
+#define CONN_FLUSH_SLICE_MS 5   // conn_flush_all: attente sur une connexion avant de repasser sur les autres
+
+typedef struct Conn Conn;
+
+// Transport d'une connexion: socket (défaut) ou anneaux en mémoire partagée.
+typedef struct {
+    ssize_t (*read)(Conn *c, char *buf, size_t n);
+    ssize_t (*write)(Conn *c, const char *buf, size_t n);
+    void (*close)(Conn *c);
+    int (*wait_writable)(Conn *c, int timeout_ms);   // 1 si une écriture peut avancer
+    int (*wait_readable)(Conn *c, int timeout_ms);   // 1 si une lecture peut avancer
+    void (*detach)(Conn *c);   // Libère localement, sans rien signaler au pair
+} ConnOps;
+
+// Connexion côté serveur: le socket et un petit tampon de lecture, sans stdio.
+struct Conn {
+    const ConnOps *ops;
+    void *priv;            // État propre au transport
+    int fd;
+    int passed_fd;         // Descripteur reçu par SCM_RIGHTS (memfd shm), -1 sinon
+    int rpos;
+    int rlen;
+    char *oq;              // File de sortie circulaire (CONN_OUTQ_MAX), allouée au besoin
+    uint32_t oq_head;
+    uint32_t oq_len;
+    double slow_since;     // Passage au-dessus de CONN_OUTQ_HIGH (mono_now), 0 sinon
+    char rbuf[CONN_RBUF];
+};
+
+// Compteurs globaux des files de sortie (tous transports confondus).
+typedef struct {
+    long slow;             // Passages au-dessus de CONN_OUTQ_HIGH
+    long recovered;        // Retours sous CONN_OUTQ_LOW
+    long overflows;        // Envois refusés, file pleine
+    long queued;           // Octets actuellement en file
+    long timeouts;         // Lectures ou écritures en ETIMEDOUT (keepalive)
+} ConnOutStats;
+
+void conn_init(Conn *c, int fd);
+int sock_wait_writable(Conn *c, int timeout_ms);
+int sock_wait_readable(Conn *c, int timeout_ms);
+void conn_close(Conn *c);
+void conn_detach(Conn *c);
+int conn_send_line(Conn *c, const char *line);
+int conn_recv_line(Conn *c, char *buf, int cap);
+int conn_recv_line_timed(Conn *c, char *buf, int cap, int timeout_ms);
+int conn_flush(Conn *c, int timeout_ms);
+int conn_flush_all(Conn **cs, int n, int timeout_ms, int *ok);
+double conn_slow_for(const Conn *c);
+void conn_out_stats(ConnOutStats *s);
+
 #endif
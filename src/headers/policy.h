@@ -0,0 +1,48 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "common.h"
+
+/*
+ * Tables de décision précalculées par ./tables à partir de parties simulées
+ * sur les règles de game.c, pour une variante et un nombre de joueurs.
+ * Le fichier est projeté par mmap: l'ouverture ne valide que l'en-tête, les
+ * pages sont lues à la demande et partagées entre tous les robots qui
+ * l'ouvrent. Valeurs: têtes de bœuf x POLICY_SCALE (uint16_t, ordre de l'hôte).
+ *   place[main][longueur][ecart][boeufs]  têtes ramassées au tour même par une
+ *        carte posée à `ecart` de la fin d'une rangée de `longueur` cartes
+ *        valant `boeufs` têtes, avec `main` cartes en main avant de jouer
+ *   pick[longueur][boeufs]  têtes de la rangée prise plus celles ramassées
+ *        au tour suivant par le même joueur
+ */
+
+#define POLICY_VERSION 1
+#define POLICY_SCALE 256
+#define POLICY_BULLS_MAX 31        // Rangées plus chères: dernière case
+
+typedef struct PolicyTables PolicyTables;
+
+// Dimensions d'un jeu de tables (relues dans l'en-tête).
+typedef struct {
+    int nplayers;
+    int row_max;
+    int hand_size;
+    int gap_max;                   // Écarts 1..gap_max (plus grande carte - 1)
+    char variant[16];
+} PolicyShape;
+
+size_t policy_place_cells(const PolicyShape *s);
+size_t policy_pick_cells(const PolicyShape *s);
+size_t policy_place_index(const PolicyShape *s, int hn, int len, int gap, int bulls);
+size_t policy_pick_index(const PolicyShape *s, int len, int bulls);
+int policy_write(const char *path, const PolicyShape *s, uint64_t games,
+                 const uint16_t *place, const uint16_t *pick);
+
+PolicyTables *policy_open(const char *path);
+void policy_close(PolicyTables *t);
+const PolicyShape *policy_shape(const PolicyTables *t);
+uint64_t policy_games(const PolicyTables *t);
+double policy_place(const PolicyTables *t, int hn, int len, int gap, int bulls);
+double policy_pick(const PolicyTables *t, int len, int bulls);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "common.h"
+
+/*
+ * Pool d'objets de taille fixe: tranches alignées sur la ligne de cache,
+ * allouées par blocs et jamais rendues au système; les objets libres sont
+ * chaînés entre eux (le premier mot sert de lien).
+ */
+
+#define POOL_ALIGN 64
+
+typedef struct {
+    const char *name;
+    size_t obj_size;       // Taille arrondie à POOL_ALIGN
+    size_t chunk_objs;     // Objets par bloc alloué
+    void *free_list;
+    size_t capacity;       // Objets alloués (libres + utilisés)
+    size_t in_use;
+    size_t peak;
+    pthread_mutex_t lock;
+} Pool;
+
+void pool_init(Pool *p, const char *name, size_t obj_size, size_t chunk_objs);
+int pool_reserve(Pool *p, size_t count);
+void *pool_get(Pool *p);
+void pool_put(Pool *p, void *obj);
+int pool_report(Pool *p, char *buf, size_t cap);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef PROTO_H
+#define PROTO_H
+
+#include "common.h"
+#include "game.h"
+
+// Capacités annoncées par le client après son pseudo ("pseudo +DELTA +PIPELINE").
+#define CAP_DELTA 0x1
+#define CAP_PIPELINE 0x2   // Joue sans attendre DEMANDE_CARTE
+#define CAP_PING 0x4       // Répond PONG au PING envoyé pendant une attente silencieuse
+#define CAP_MUX 0x8        // Session multiplexée: plusieurs sièges, lignes "@<partie> ..."
+
+// Variante demandée dans le même message ("pseudo +DELTA +VARIANTE=pro"):
+// le client attend dans la file de ces règles, sinon dans celle du serveur (-v).
+#define HELLO_VARIANT "+VARIANTE="
+
+// Réponse d'accueil d'un nœud de grappe plein ou sans partenaire: "INFO REDIRECT hote port".
+#define REDIRECT_PREFIX "INFO REDIRECT "
+
+int parse_hello(const char *line, char *name, int cap, int *caps, int *variant);
+int parse_play(const char *line, int *card, int *row);
+int parse_hand(const char *line, int *cards, int cap);
+void parse_table_rows(const char *line, Row rows[ROWS]);
+int apply_table_event(const char *line, Row rows[ROWS]);
+int parse_redirect(const char *line, char *host, int hcap, char *port, int pcap);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include "common.h"
+
+#include <stdint.h>
+
+/*
+ * Limitation de débit par seaux à jetons. Chaque connexion a ses seaux
+ * (lignes reçues, commandes invalides); chaque adresse source en a d'autres,
+ * partagés par toutes ses connexions (mêmes limites multipliées par
+ * RATE_ADDR_FACTOR, plus les tentatives de connexion). Les connexions locales
+ * (socket Unix, 127.0.0.0/8) n'ont pas de limite par adresse.
+ */
+
+#define RATE_ADDR_SLOTS 4096        // Adresses suivies (les plus anciennes sont oubliées)
+#define RATE_ADDR_PROBE 8
+#define RATE_ADDR_FACTOR 8
+
+typedef enum { RATE_LINES, RATE_INVALID, RATE_CONNECTS, RATE_KINDS } RateKind;
+
+// Ce qui arrive à un joueur qui dépasse sa limite pendant une partie.
+typedef enum {
+    PENALTY_DELAY,         // Attendre le prochain jeton avant de traiter la ligne
+    PENALTY_BOT,           // Le bot interne joue ce coup à sa place
+    PENALTY_DISCONNECT     // Connexion fermée, le bot finit la partie
+} Penalty;
+
+typedef struct {
+    double rate;           // Jetons par seconde (0: pas de limite)
+    double burst;          // Contenance du seau
+} RateLimit;
+
+typedef struct {
+    RateLimit limits[RATE_KINDS];
+    Penalty penalty;
+} RateConfig;
+
+typedef struct {
+    double tokens;
+    double stamp;          // Dernier remplissage (mono_now)
+} Bucket;
+
+extern RateConfig rate_config;
+
+void bucket_init(Bucket *b, const RateLimit *l, double now);
+int bucket_take(Bucket *b, const RateLimit *l, double now);
+double bucket_wait(const Bucket *b, const RateLimit *l, double now);
+
+int rate_addr_take(uint32_t addr, RateKind kind, double now);
+double rate_addr_wait(uint32_t addr, RateKind kind, double now);
+int rate_addr_limited(uint32_t addr);
+
+int rate_parse(const char *spec, RateConfig *cfg);
+int penalty_lookup(const char *name, Penalty *p);
+const char *penalty_name(Penalty p);
+const char *rate_kind_name(RateKind k);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "common.h"
+#include "net.h"
+#include "archive.h"
+
+/*
+ * Processus de parties (-w). Le processus frontal accepte les connexions et
+ * forme les tables; chaque table part vers le processus le moins chargé avec
+ * les descripteurs de ses joueurs (SCM_RIGHTS sur un socketpair SEQPACKET,
+ * un message par table). Le processus de parties renvoie le journal de chaque
+ * partie par morceaux (SHARD_LOG) puis sa fin (SHARD_DONE): le
+ * frontal reste le seul écrivain de l'archive.
+ */
+
+#define SHARD_ENV "SIXQP_SHARD"     // Présente dans l'environnement d'un processus de parties
+#define SHARD_CHAN_FD 3             // Canal vers le frontal, côté processus de parties
+#define SHARD_MAX 64
+
+typedef struct {
+    char name[PLAYER_NAME_MAX];
+    int caps;
+    uint32_t addr;         // Adresse source, pour les limites de débit
+    int human;             // 0: siège tenu par un bot interne
+    int shm;               // Le socket est suivi du memfd de ses anneaux
+    int rlen;              // Octets déjà reçus mais pas encore lus
+    char rbuf[CONN_RBUF];
+} ShardSeat;
+
+typedef struct {
+    int game_id;
+    int nplayers;
+    int variant;
+    int end_score;
+    ShardSeat seats[MAX_PLAYERS];
+} ShardTable;
+
+#define SHARD_LOG 1                 // Morceau du journal d'une partie en cours
+#define SHARD_DONE 2                // Fin de partie
+
+// Compte rendu d'un processus de parties; seuls les log_len premiers octets
+// de log sont transmis.
+typedef struct {
+    int kind;
+    int game_id;
+    int aborted;           // SHARD_DONE
+    int64_t started;       // SHARD_DONE
+    int64_t ended;         // SHARD_DONE
+    uint32_t log_len;      // SHARD_LOG
+    char log[ARCHIVE_CHUNK_MAX];
+} ShardReport;
+
+pid_t shard_spawn(char **argv, int *chan);
+int shard_send_table(int chan, const ShardTable *t, const int *fds, int nfds);
+int shard_recv_table(int chan, ShardTable *t, int *fds, int *nfds);
+int shard_send_log(int chan, int game_id, const char *log, size_t len);
+int shard_send_done(int chan, int game_id, int aborted, int64_t started, int64_t ended);
+int shard_recv_report(int chan, ShardReport *d);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "common.h"
+
+/*
+ * Statistiques persistantes des joueurs, par pseudo (-J). Une table de
+ * hachage à adressage ouvert (sondage linéaire) dans un fichier projeté en
+ * mémoire et partagé par les processus de parties: pas de phase de
+ * chargement, une recherche touche une ou deux lignes de cache. Une entrée
+ * est réservée par compare-and-swap sur son empreinte puis n'est jamais
+ * déplacée; ses compteurs sont mis à jour par additions atomiques en fin
+ * de partie. La capacité est fixée à la création du fichier (fichier creux).
+ */
+
+#define STATS_MAGIC "6QPSTAT1"
+#define STATS_SLOTS_DEFAULT (1u << 21)    // 2 M joueurs, 256 Mo creux
+#define STATS_ELO_START 1500.0
+#define STATS_ELO_K 24.0
+#define STATS_TOP_MAX 100
+
+typedef struct StatsStore StatsStore;
+
+// Vue d'un joueur, moyennes calculées.
+typedef struct {
+    char name[PLAYER_NAME_MAX];
+    uint64_t games;
+    uint64_t wins;         // Parties finies premier (ex aequo compris)
+    uint64_t bulls;        // Têtes de bœuf cumulées
+    double avg_score;      // Score final moyen
+    double rating;         // Elo par paires, bots cotés STATS_ELO_START
+    double avg_resp_ms;    // Temps de réponse moyen aux demandes du serveur
+    int64_t last_seen;     // time() de la dernière partie
+} PlayerStats;
+
+// Résultat d'un siège en fin de partie.
+typedef struct {
+    const char *name;
+    int score;
+    int rated;             // 0: bot, pris en compte comme adversaire seulement
+    double resp_sum;       // Secondes cumulées d'attente de ses réponses
+    int resp_count;
+} StatsResult;
+
+StatsStore *stats_open(const char *path, uint64_t slots);
+void stats_close(StatsStore *s);
+int stats_lookup(StatsStore *s, const char *name, PlayerStats *out);
+void stats_record_game(StatsStore *s, const StatsResult *r, int n);
+int stats_top(StatsStore *s, PlayerStats *out, int n);
+void stats_usage(StatsStore *s, uint64_t *count, uint64_t *capacity, uint64_t *full);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "common.h"
+#include "game.h"
+#include "policy.h"
+
+// Stratégie de robot utilisable par les clients robots et les bots du serveur.
+typedef struct {
+    const char *name;
+    int (*choose_card)(int *hand, int hn, Row rows[ROWS], int row_max);
+    int (*choose_row)(Row rows[ROWS]);
+} Strategy;
+
+// Poids de l'heuristique "risque" (choose_card_fallback / choose_row_fallback).
+// Les valeurs par défaut reproduisent l'heuristique d'origine; ./reglage les
+// ajuste et écrit un fichier "cle valeur" relu au démarrage.
+typedef struct {
+    double forced;         // Carte qui impose un ramassage
+    double forced_bulls;   // ... par tête de bœuf de cette carte
+    double full;           // Carte qui serait la (row_max+1)-ième de sa rangée
+    double full_bulls;     // ... par tête de bœuf de la rangée ramassée
+    double gap;            // Écart avec la fin de la rangée visée
+    double len;            // Par carte déjà dans la rangée visée
+    double take_len;       // Choix de rangée: bonus par carte retirée (rangée longue = danger au tour suivant)
+} StrategyParams;
+
+#define STRATEGY_PARAMS_COUNT 7
+#define STRATEGY_PARAMS_ENV "SIXQP_PARAMS"   // Fichier de poids des robots
+#define STRATEGY_TABLES_ENV "SIXQP_TABLES"   // Tables de ./tables (stratégie "table")
+
+extern StrategyParams strategy_params;
+extern const StrategyParams strategy_params_default;
+extern PolicyTables *strategy_tables;
+
+int row_bulls_local(const Row *r);
+int choose_smallest_card(const int *hand, int hn);
+int choose_card_fallback(int *hand, int hn, Row rows[ROWS], int row_max);
+int choose_row_min_bulls(Row rows[ROWS]);
+int card_takes_row(Row rows[ROWS], int c);
+int choose_row_fallback(Row rows[ROWS]);
+int choose_card_params(const StrategyParams *p, int *hand, int hn, Row rows[ROWS], int row_max);
+int choose_row_params(const StrategyParams *p, Row rows[ROWS]);
+int choose_card_table(int *hand, int hn, Row rows[ROWS], int row_max);
+int choose_row_table(Row rows[ROWS]);
+
+double *strategy_param(StrategyParams *p, int i, const char **name);
+int strategy_params_load(const char *path, StrategyParams *p);
+int strategy_params_save(const char *path, const StrategyParams *p, const char *comment);
+int strategy_params_from_env(void);
+int strategy_tables_from_env(void);
+
+const Strategy *strategy_lookup(const char *name);
+
+#endif
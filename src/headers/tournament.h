@@ -0,0 +1,50 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include "common.h"
+#include "strategy.h"
+
+/*
+ * Tournoi: liste d'inscrits (stratégies internes ou clients connectés sous
+ * un pseudo), appariements par rondes tournantes ou système suisse,
+ * classement Elo par paires (moins de têtes de bœuf = victoire).
+ */
+
+#define TOURNAMENT_ELO_START 1500.0
+#define TOURNAMENT_ELO_K 24.0
+
+typedef enum { TOURNOI_RONDES, TOURNOI_SUISSE } TournamentMode;
+
+typedef struct {
+    char name[PLAYER_NAME_MAX];
+    const Strategy *bot;   // NULL: client connecté sous ce pseudo
+    double rating;
+    int games;
+    int points;            // n-1 pour la première place ... 0 pour la dernière
+    int firsts;
+    long bulls;
+    int met_len;           // Adversaires déjà croisés (suisse)
+} Entrant;
+
+typedef struct {
+    Entrant *entrants;
+    int count;
+    int clients;           // Inscrits de type client
+    TournamentMode mode;
+    int table_size;
+    int rounds;
+    int round;             // Ronde en cours (1..rounds)
+    long games_done;
+    double started;        // mono_now() au lancement
+    int *met;              // met_cap adversaires croisés par inscrit (suisse)
+    int met_cap;
+    pthread_mutex_t lock;
+} Tournament;
+
+int tournament_load(Tournament *t, const char *path, int table_size);
+int tournament_find_client(Tournament *t, const char *name);
+int tournament_pairings(Tournament *t, int round, int *seats);
+void tournament_record(Tournament *t, const int *entrant, const int *scores, int n);
+void tournament_leaderboard(Tournament *t, FILE *out);
+
+#endif
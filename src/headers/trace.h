@@ -0,0 +1,46 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common.h"
+
+/*
+ * Points de trace des phases du serveur, exportés au format Chrome
+ * (chrome://tracing, Perfetto). Compilés par défaut; coût quasi nul tant
+ * que trace_enabled vaut 0. -DNO_TRACE les retire complètement.
+ */
+
+typedef struct {
+    const char *name;
+    uint64_t t0;
+    int a0;
+    int a1;
+} TraceSpan;
+
+extern volatile int trace_enabled;
+
+uint64_t trace_clock(void);
+void trace_record(const TraceSpan *s, uint64_t t1);
+void trace_thread_name(const char *fmt, ...);
+int trace_dump(const char *path);
+
+// Ouvre une phase (t0 = 0 si la trace est désactivée).
+static inline TraceSpan trace_begin(const char *name, int a0, int a1) {
+    TraceSpan s = { name, 0, a0, a1 };
+    if (__builtin_expect(trace_enabled, 0)) s.t0 = trace_clock();
+    return s;
+}
+
+// Ferme une phase ouverte par trace_begin.
+static inline void trace_end(const TraceSpan *s) {
+    if (__builtin_expect(s->t0 != 0, 0)) trace_record(s, trace_clock());
+}
+
+#ifdef NO_TRACE
+#define TRACE_BEGIN(var, name, a0, a1) do { } while (0)
+#define TRACE_END(var) do { } while (0)
+#else
+#define TRACE_BEGIN(var, name, a0, a1) TraceSpan var = trace_begin(name, a0, a1)
+#define TRACE_END(var) trace_end(&var)
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "common.h"
+#include "net.h"
+
+/*
+ * Transports locaux. Adresses côté client:
+ *   hote port         TCP (défaut)
+ *   unix:/chemin -    socket local du serveur (-U)
+ *   shm:/chemin -     même socket pour l'accueil, puis deux anneaux en mémoire
+ *                     partagée (memfd passé par SCM_RIGHTS avec la ligne "SHM")
+ * Le protocole ligne à ligne est identique sur les trois.
+ */
+
+#define SHM_HELLO "SHM"
+#define NET_REDIRECT_MAX 4          // Rebonds suivis par un client (grappe)
+
+int net_open(const char *host, const char *port, FILE **in, FILE **out);
+int net_follow_redirect(const char *line, const char *hello, FILE **in, FILE **out);
+
+void conn_init_unix(Conn *c, int fd);
+int conn_attach_shm(Conn *c);
+int conn_is_shm(const Conn *c);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef URING_H
+#define URING_H
+
+#include "common.h"
+#include "net.h"
+
+/*
+ * Moteur d'entrées-sorties io_uring du serveur (-I uring), sous la même
+ * interface ConnOps que les sockets ordinaires. Un thread unique possède
+ * l'anneau: accept multishot sur le socket d'écoute TCP, réception
+ * multishot dans un anneau de tampons fournis au noyau, envois de tous les
+ * sièges soumis d'un seul appel (les deux morceaux d'une file circulaire
+ * sont liés). Les threads de partie ne font plus d'appel système pour lire
+ * ou écrire: ils échangent des octets avec ce thread sous verrou et le
+ * réveillent au besoin (eventfd). Les connexions locales (-U) restent sur
+ * leur transport; sans io_uring le serveur garde le moteur posix.
+ */
+
+typedef struct {
+    long enters;           // Appels io_uring_enter
+    long accepts;
+    long recvs;            // Complétions de réception
+    long sends;            // Complétions d'envoi
+    long wakeups;          // Réveils du thread par les threads de partie
+} UringStats;
+
+int uring_start(int listen_fd);
+int uring_accept_fd(void);
+int uring_accept_pop(struct sockaddr_in *cli);
+int uring_conn_init(Conn *c, int fd);
+void uring_stats(UringStats *st);
+
+#endif
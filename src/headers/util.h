@@ -7,5 +7,6 @@ void die(const char *m);
 int str_starts(const char *s, const char *p);
 int parse_int(const char *s, int *out);
 void trim_crlf(char *s);
+double mono_now(void);
 
 #endif
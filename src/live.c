@@ -0,0 +1,248 @@
+#include "headers/live.h"
+#include "headers/net.h"
+#include "headers/util.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
+
+static LiveGame *live_head = NULL;
+static int live_count = 0;
+static pthread_mutex_t live_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t live_unread = PTHREAD_COND_INITIALIZER;   // Un lecteur a fini sa copie
+static atomic_int admin_sessions;
+
+static const char *seat_states[] = { "joueur", "bot", "repris" };
+static StatsStore *admin_stats;   // NULL: serveur lancé sans -J
+
+// Inscrit une partie qui démarre, avec sa première vue.
+void live_add(LiveGame *lg, const GameView *v) {
+    atomic_store_explicit(&lg->seq, 0, memory_order_relaxed);
+    lg->game_id = v->game_id;
+    lg->readers = 0;
+    lg->view = *v;
+    pthread_mutex_lock(&live_lock);
+    lg->prev = NULL;
+    lg->next = live_head;
+    if (live_head) live_head->prev = lg;
+    live_head = lg;
+    live_count++;
+    pthread_mutex_unlock(&live_lock);
+}
+
+// Retire une partie terminée: plus aucun lecteur ne la voit ensuite, et
+// ceux qui la copiaient ont fini au retour (la table peut être réutilisée).
+void live_remove(LiveGame *lg) {
+    pthread_mutex_lock(&live_lock);
+    if (lg->prev) lg->prev->next = lg->next;
+    else live_head = lg->next;
+    if (lg->next) lg->next->prev = lg->prev;
+    live_count--;
+    while (lg->readers > 0) pthread_cond_wait(&live_unread, &live_lock);
+    pthread_mutex_unlock(&live_lock);
+}
+
+// Fin de copie des parties marquées par un lecteur.
+static void live_release(LiveGame **games, int n) {
+    pthread_mutex_lock(&live_lock);
+    for (int i = 0; i < n; i++) games[i]->readers--;
+    pthread_cond_broadcast(&live_unread);
+    pthread_mutex_unlock(&live_lock);
+}
+
+// Publie une nouvelle vue (seul le thread de la partie écrit).
+void live_publish(LiveGame *lg, const GameView *v) {
+    unsigned s = atomic_load_explicit(&lg->seq, memory_order_relaxed);
+    atomic_store_explicit(&lg->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    lg->view = *v;
+    atomic_store_explicit(&lg->seq, s + 2, memory_order_release);
+}
+
+// Copie cohérente de la dernière vue publiée.
+void live_read(LiveGame *lg, GameView *out) {
+    for (;;) {
+        unsigned s1 = atomic_load_explicit(&lg->seq, memory_order_acquire);
+        if (s1 & 1) continue;
+        memcpy(out, &lg->view, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&lg->seq, memory_order_relaxed) == s1) return;
+    }
+}
+
+// Une ligne de résumé par partie. Les parties sont marquées sous le verrou,
+// copiées ensuite sans lui.
+static void list_games(FILE *f) {
+    pthread_mutex_lock(&live_lock);
+    LiveGame **games = malloc((size_t)(live_count ? live_count : 1) * sizeof(*games));
+    int n = 0;
+    for (LiveGame *lg = live_head; lg && games; lg = lg->next) {
+        lg->readers++;
+        games[n++] = lg;
+    }
+    pthread_mutex_unlock(&live_lock);
+    if (!games) {
+        fprintf(f, "ERREUR Memoire insuffisante\n");
+        return;
+    }
+
+    GameView v;
+    for (int k = 0; k < n; k++) {
+        live_read(games[k], &v);
+        int humans = 0;
+        for (int i = 0; i < v.nplayers; i++) humans += v.seats[i].state == SEAT_HUMAN;
+        fprintf(f, "PARTIE %d %s joueurs=%d humains=%d manche=%d tour=%d depuis=%lds\n",
+                v.game_id, v.variant, v.nplayers, humans, v.manche, v.tour,
+                (long)(time(NULL) - v.started));
+    }
+    live_release(games, n);
+    free(games);
+    fprintf(f, "FIN %d parties\n", n);
+}
+
+// Détail d'une partie: rangées puis sièges.
+static void dump_game(FILE *f, int gid) {
+    GameView v;
+    LiveGame *found = NULL;
+    pthread_mutex_lock(&live_lock);
+    for (LiveGame *lg = live_head; lg && !found; lg = lg->next)
+        if (lg->game_id == gid) found = lg;
+    if (found) found->readers++;
+    pthread_mutex_unlock(&live_lock);
+    if (found) {
+        live_read(found, &v);
+        live_release(&found, 1);
+    }
+
+    if (!found) {
+        fprintf(f, "ERREUR Partie %d inconnue\n", gid);
+        return;
+    }
+    fprintf(f, "PARTIE %d %s manche=%d tour=%d\n", v.game_id, v.variant, v.manche, v.tour);
+    for (int r = 0; r < ROWS; r++) {
+        fprintf(f, "R%d:", r + 1);
+        for (int k = 0; k < v.rows[r].len; k++) fprintf(f, " %d", v.rows[r].cards[k]);
+        fprintf(f, "\n");
+    }
+    for (int i = 0; i < v.nplayers; i++) {
+        const LiveSeat *s = &v.seats[i];
+        fprintf(f, "SIEGE %d %s %s score=%d main=%d carte=%d\n", i + 1, s->name,
+                seat_states[s->state], s->score, s->hand_len, s->card);
+    }
+    fprintf(f, "FIN\n");
+}
+
+// Une ligne de statistiques d'un joueur.
+static void print_player(FILE *f, const PlayerStats *ps) {
+    fprintf(f, "JOUEUR %s elo=%.1f parties=%llu victoires=%llu boeufs=%llu moyenne=%.1f reponse=%.0fms\n",
+            ps->name, ps->rating, (unsigned long long)ps->games, (unsigned long long)ps->wins,
+            (unsigned long long)ps->bulls, ps->avg_score, ps->avg_resp_ms);
+}
+
+// Statistiques d'un pseudo, ou classement des n meilleurs Elo.
+static void player_stats(FILE *f, const char *name, int top) {
+    if (!admin_stats) {
+        fprintf(f, "ERREUR Statistiques desactivees (-J)\n");
+        return;
+    }
+    if (name) {
+        PlayerStats ps;
+        if (!stats_lookup(admin_stats, name, &ps)) {
+            fprintf(f, "ERREUR Joueur %s inconnu\n", name);
+            return;
+        }
+        print_player(f, &ps);
+    } else {
+        PlayerStats best[STATS_TOP_MAX];
+        int n = stats_top(admin_stats, best, top);
+        for (int i = 0; i < n; i++) print_player(f, &best[i]);
+    }
+    fprintf(f, "FIN\n");
+}
+
+// Répond aux commandes d'une session jusqu'à sa fermeture. La réponse est
+// préparée en mémoire: un client lent ne retient jamais le registre.
+static void admin_session(int fd) {
+    struct timeval tv = { LIVE_IDLE_S, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    FILE *in = fdopen_r(fd);
+    FILE *out = fdopen_w(fd);
+    close(fd);
+    if (!in || !out) goto done;
+
+    char line[LINE_MAX];
+    while (fgets(line, sizeof(line), in)) {
+        trim_crlf(line);
+        char *buf = NULL;
+        size_t len = 0;
+        FILE *f = open_memstream(&buf, &len);
+        if (!f) break;
+
+        int gid;
+        if (strcmp(line, "PARTIES") == 0) list_games(f);
+        else if (str_starts(line, "PARTIE ") && parse_int(line + 7, &gid)) dump_game(f, gid);
+        else if (str_starts(line, "JOUEUR ")) player_stats(f, line + 7, 0);
+        else if (strcmp(line, "CLASSEMENT") == 0) player_stats(f, NULL, 10);
+        else if (str_starts(line, "CLASSEMENT ") && parse_int(line + 11, &gid) && gid > 0)
+            player_stats(f, NULL, gid);
+        else fprintf(f, "ERREUR Commandes: PARTIES, PARTIE <id>, JOUEUR <pseudo>, CLASSEMENT [n]\n");
+        fclose(f);
+
+        int ok = fwrite(buf, 1, len, out) == len && fflush(out) == 0;
+        free(buf);
+        if (!ok) break;
+    }
+done:
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+static void *session_thread(void *arg) {
+    admin_session((int)(intptr_t)arg);
+    atomic_fetch_sub(&admin_sessions, 1);
+    return NULL;
+}
+
+// Thread d'administration: un thread par session, une session inactive ne
+// retient pas les autres. Les signaux de contrôle restent au thread dédié.
+static void *admin_thread(void *arg) {
+    int lfd = (int)(intptr_t)arg;
+    sigset_t ctl;
+    sigemptyset(&ctl);
+    sigaddset(&ctl, SIGUSR1);
+    sigaddset(&ctl, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &ctl, NULL);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) continue;
+        pthread_t tid;
+        if (atomic_fetch_add(&admin_sessions, 1) >= LIVE_SESSIONS_MAX ||
+            pthread_create(&tid, &attr, session_thread, (void *)(intptr_t)fd) != 0) {
+            atomic_fetch_sub(&admin_sessions, 1);
+            static const char busy[] = "ERREUR Trop de sessions d'administration\n";
+            if (write(fd, busy, sizeof(busy) - 1) < 0) {}
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+// Ouvre le socket d'administration (AF_UNIX) et lance son thread.
+int live_admin_start(const char *path, StatsStore *stats) {
+    admin_stats = stats;
+    int lfd = unix_listen(path);
+    if (lfd < 0) return 0;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, admin_thread, (void *)(intptr_t)lfd) != 0) {
+        close(lfd);
+        return 0;
+    }
+    pthread_detach(tid);
+    return 1;
+}
@@ -0,0 +1,430 @@
+#include "headers/mux.h"
+#include "headers/util.h"
+
+#include <stdatomic.h>
+
+// Siège d'une session: connexion virtuelle d'un thread de partie.
+typedef struct MuxChan {
+    MuxSession *s;
+    int gid;                       // 0: pas encore attablé
+    int player;                    // Numéro de joueur à la table (1..n)
+    int stage_len;
+    char stage[LINE_MAX];          // Début de ligne écrit sans son \n
+    int in_len;
+    char in[MUX_IN_MAX];           // Réponses reçues, lignes terminées par \n
+    pthread_cond_t readable;
+    struct MuxChan *prev;
+    struct MuxChan *next;
+} MuxChan;
+
+struct MuxSession {
+    Conn *sock;
+    char name[PLAYER_NAME_MAX];
+    int caps;
+    int variant;                   // Variante demandée au hello (-1: celle du serveur)
+    uint32_t addr;
+    const MuxHooks *hooks;
+    pthread_mutex_t lock;
+    pthread_cond_t out_ready;      // Thread d'écriture: données à envoyer
+    pthread_cond_t out_space;      // Sièges: place libérée dans la sortie
+    char *out;                     // Rempli par les sièges
+    char *spare;                   // En cours d'envoi par le thread d'écriture
+    size_t out_len;
+    int dead;
+    int refs;                      // Sièges + threads de lecture et d'écriture
+    int opened;                    // Sièges ouverts depuis le début (pseudos)
+    int open;
+    MuxChan *chans;
+};
+
+static _Atomic long mux_sessions, mux_seats, mux_dropped;
+
+// Échéance absolue (horloge des conditions) dans timeout_ms.
+static struct timespec deadline_in(int timeout_ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// Session perdue: réveille tout le monde. Appelée avec le verrou tenu.
+static void session_kill(MuxSession *s) {
+    if (s->dead) return;
+    s->dead = 1;
+    shutdown(s->sock->fd, SHUT_RDWR);
+    for (MuxChan *ch = s->chans; ch; ch = ch->next) pthread_cond_broadcast(&ch->readable);
+    pthread_cond_broadcast(&s->out_ready);
+    pthread_cond_broadcast(&s->out_space);
+}
+
+// Rend une référence; la dernière libère la session.
+static void session_unref(MuxSession *s) {
+    pthread_mutex_lock(&s->lock);
+    int last = --s->refs == 0;
+    pthread_mutex_unlock(&s->lock);
+    if (!last) return;
+
+    s->hooks->release(s->sock);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->out_ready);
+    pthread_cond_destroy(&s->out_space);
+    free(s->out);
+    free(s->spare);
+    free(s);
+    mux_sessions--;
+}
+
+// Ajoute des octets à la sortie commune; 0 s'ils n'y tiennent pas. Verrou tenu.
+static int out_push(MuxSession *s, const char *p, size_t n) {
+    if (s->out_len + n > MUX_OUT_MAX) return 0;
+    memcpy(s->out + s->out_len, p, n);
+    s->out_len += n;
+    pthread_cond_signal(&s->out_ready);
+    return 1;
+}
+
+// Ligne de session, sans préfixe.
+static void session_reply(MuxSession *s, const char *line) {
+    pthread_mutex_lock(&s->lock);
+    if (!s->dead && s->out_len + strlen(line) + 1 <= MUX_OUT_MAX) {
+        out_push(s, line, strlen(line));
+        out_push(s, "\n", 1);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+// Écrit tout le tampon par les opérations du transport (non bloquantes),
+// en attendant la place; 0 si la connexion est rompue ou la session perdue.
+static int session_write(MuxSession *s, const char *buf, size_t len) {
+    Conn *c = s->sock;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t w = c->ops->write(c, buf + done, len - done);
+        if (w > 0) {
+            done += (size_t)w;
+            continue;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        if (w == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) return 0;
+
+        c->ops->wait_writable(c, MUX_WRITE_WAIT_MS);
+        pthread_mutex_lock(&s->lock);
+        int dead = s->dead;
+        pthread_mutex_unlock(&s->lock);
+        if (dead) return 0;
+    }
+    return 1;
+}
+
+// Envoie la sortie accumulée, hors verrou.
+static void *mux_writer(void *arg) {
+    MuxSession *s = arg;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->out_len && !s->dead) pthread_cond_wait(&s->out_ready, &s->lock);
+        if (s->dead) break;
+
+        char *buf = s->out;
+        size_t len = s->out_len;
+        s->out = s->spare;
+        s->spare = buf;
+        s->out_len = 0;
+        pthread_cond_broadcast(&s->out_space);
+        pthread_mutex_unlock(&s->lock);
+
+        int ok = session_write(s, buf, len);
+
+        pthread_mutex_lock(&s->lock);
+        if (!ok) session_kill(s);
+    }
+    pthread_mutex_unlock(&s->lock);
+    session_unref(s);
+    return NULL;
+}
+
+// Remet une réponse "@<partie>.<joueur> ..." au siège correspondant.
+static void route_line(MuxSession *s, const char *line) {
+    char *end;
+    long gid = strtol(line + 1, &end, 10);
+    long player = 0;
+    if (*end == '.') player = strtol(end + 1, &end, 10);
+    if (gid <= 0 || player <= 0 || (*end && *end != ' ')) {
+        session_reply(s, "ERREUR Prefixe de partie invalide");
+        return;
+    }
+    const char *rest = *end ? end + 1 : end;
+    size_t n = strlen(rest);
+
+    pthread_mutex_lock(&s->lock);
+    MuxChan *ch = s->chans;
+    while (ch && (ch->gid != gid || ch->player != player)) ch = ch->next;
+    if (ch && ch->in_len + (int)n + 1 <= MUX_IN_MAX) {
+        memcpy(ch->in + ch->in_len, rest, n);
+        ch->in[ch->in_len + (int)n] = '\n';
+        ch->in_len += (int)n + 1;
+        pthread_cond_signal(&ch->readable);
+    } else {
+        mux_dropped++;     // Partie finie (PONG tardif) ou siège qui ne lit plus
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+// Ouvre n sièges de plus et les confie à la file d'attente du serveur.
+static void session_join(MuxSession *s, int n) {
+    int placed = 0;
+    for (int i = 0; i < n; i++) {
+        pthread_mutex_lock(&s->lock);
+        int full = s->open >= MUX_SEATS_MAX;
+        int k = ++s->opened;
+        pthread_mutex_unlock(&s->lock);
+        if (full) break;
+
+        char name[PLAYER_NAME_MAX];
+        snprintf(name, sizeof(name), "%.*s.%d", PLAYER_NAME_MAX - 12, s->name, k);
+        if (!s->hooks->join(s, name, s->caps, s->variant, s->addr)) break;
+        placed++;
+    }
+
+    char line[64];
+    if (placed < n) snprintf(line, sizeof(line), "ERREUR %d sieges sur %d: serveur complet", placed, n);
+    else snprintf(line, sizeof(line), "INFO %d sieges en attente", placed);
+    session_reply(s, line);
+}
+
+// Lit les lignes de la session: réponses de sièges et commandes de session.
+static void *mux_reader(void *arg) {
+    MuxSession *s = arg;
+    char line[LINE_MAX];
+
+    while (conn_recv_line(s->sock, line, sizeof(line)) > 0) {
+        int n;
+        if (line[0] == '@') route_line(s, line);
+        else if (strcmp(line, "JOINDRE") == 0) session_join(s, 1);
+        else if (sscanf(line, "JOINDRE %d", &n) == 1 && n > 0 && n <= MUX_SEATS_MAX) session_join(s, n);
+        else if (strcmp(line, "PONG") != 0) session_reply(s, "ERREUR Commande de session inconnue");
+    }
+
+    pthread_mutex_lock(&s->lock);
+    session_kill(s);
+    pthread_mutex_unlock(&s->lock);
+    session_unref(s);
+    return NULL;
+}
+
+// Prend en charge une connexion annoncée +MUX (hello déjà lu). La session
+// garde la connexion jusqu'à ce que ses sièges et ses threads aient fini.
+int mux_session_start(Conn *sock, const char *name, int caps, int variant, uint32_t addr, const MuxHooks *h) {
+    MuxSession *s = calloc(1, sizeof(*s));
+    if (!s) return 0;
+    s->out = malloc(MUX_OUT_MAX);
+    s->spare = malloc(MUX_OUT_MAX);
+    if (!s->out || !s->spare) {
+        free(s->out);
+        free(s->spare);
+        free(s);
+        return 0;
+    }
+    s->sock = sock;
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->caps = caps;
+    s->variant = variant;
+    s->addr = addr;
+    s->hooks = h;
+    s->refs = 2;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->out_ready, NULL);
+    pthread_cond_init(&s->out_space, NULL);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, 128 * 1024);
+    pthread_t t;
+    mux_sessions++;
+    if (pthread_create(&t, &attr, mux_writer, s) != 0) {
+        pthread_attr_destroy(&attr);
+        mux_sessions--;
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->out_ready);
+        pthread_cond_destroy(&s->out_space);
+        free(s->out);
+        free(s->spare);
+        free(s);
+        return 0;
+    }
+    if (pthread_create(&t, &attr, mux_reader, s) != 0) {
+        // Le thread d'écriture rendra la session (avec sa connexion)
+        pthread_mutex_lock(&s->lock);
+        session_kill(s);
+        pthread_mutex_unlock(&s->lock);
+        session_unref(s);
+    }
+    pthread_attr_destroy(&attr);
+    return 1;
+}
+
+/* Connexion virtuelle d'un siège. */
+
+// Lit les réponses du siège; 0 quand la session est perdue.
+static ssize_t mux_read(Conn *c, char *buf, size_t n) {
+    MuxChan *ch = c->priv;
+    MuxSession *s = ch->s;
+    pthread_mutex_lock(&s->lock);
+    while (!ch->in_len && !s->dead) pthread_cond_wait(&ch->readable, &s->lock);
+    size_t k = (size_t)ch->in_len < n ? (size_t)ch->in_len : n;
+    memcpy(buf, ch->in, k);
+    memmove(ch->in, ch->in + k, (size_t)ch->in_len - k);
+    ch->in_len -= (int)k;
+    pthread_mutex_unlock(&s->lock);
+    return (ssize_t)k;
+}
+
+// Ne passe dans la sortie commune que des lignes complètes, préfixées: les
+// sièges d'une session ne peuvent pas s'entrelacer au milieu d'une ligne.
+// Un début de ligne attend dans stage; EAGAIN si la sortie est pleine.
+static ssize_t mux_write(Conn *c, const char *buf, size_t n) {
+    MuxChan *ch = c->priv;
+    MuxSession *s = ch->s;
+    size_t done = 0;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->dead) {
+        pthread_mutex_unlock(&s->lock);
+        errno = EPIPE;
+        return -1;
+    }
+    while (done < n) {
+        const char *nl = memchr(buf + done, '\n', n - done);
+        size_t part = nl ? (size_t)(nl - (buf + done)) : n - done;
+        size_t room = sizeof(ch->stage) - (size_t)ch->stage_len;
+        size_t keep = part < room ? part : room;   // Ligne démesurée: tronquée
+        if (!nl) {
+            memcpy(ch->stage + ch->stage_len, buf + done, keep);
+            ch->stage_len += (int)keep;
+            done = n;
+            break;
+        }
+
+        char prefix[32];
+        int plen = snprintf(prefix, sizeof(prefix), "@%d.%d ", ch->gid, ch->player);
+        if (s->out_len + (size_t)plen + (size_t)ch->stage_len + keep + 1 > MUX_OUT_MAX) break;
+        out_push(s, prefix, (size_t)plen);
+        out_push(s, ch->stage, (size_t)ch->stage_len);
+        out_push(s, buf + done, keep);
+        out_push(s, "\n", 1);
+        ch->stage_len = 0;
+        done += part + 1;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (done == 0 && n > 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return (ssize_t)done;
+}
+
+// Attend de la place dans la sortie commune, au plus timeout_ms.
+static int mux_wait_writable(Conn *c, int timeout_ms) {
+    MuxSession *s = ((MuxChan *)c->priv)->s;
+    struct timespec ts = deadline_in(timeout_ms);
+    pthread_mutex_lock(&s->lock);
+    while (!s->dead && s->out_len + 2 * LINE_MAX > MUX_OUT_MAX)
+        if (pthread_cond_timedwait(&s->out_space, &s->lock, &ts) == ETIMEDOUT) break;
+    int ok = !s->dead && s->out_len + 2 * LINE_MAX <= MUX_OUT_MAX;
+    pthread_mutex_unlock(&s->lock);
+    return ok;
+}
+
+// Attend une réponse du siège (ou la perte de la session), au plus timeout_ms.
+static int mux_wait_readable(Conn *c, int timeout_ms) {
+    MuxChan *ch = c->priv;
+    MuxSession *s = ch->s;
+    struct timespec ts = deadline_in(timeout_ms);
+    pthread_mutex_lock(&s->lock);
+    while (!ch->in_len && !s->dead)
+        if (pthread_cond_timedwait(&ch->readable, &s->lock, &ts) == ETIMEDOUT) break;
+    int ok = ch->in_len > 0 || s->dead;
+    pthread_mutex_unlock(&s->lock);
+    return ok;
+}
+
+// Ferme le siège: "@<partie>.<joueur> FIN" au client, la session continue.
+static void mux_close(Conn *c) {
+    MuxChan *ch = c->priv;
+    MuxSession *s = ch->s;
+    pthread_mutex_lock(&s->lock);
+    if (ch->gid && !s->dead) {
+        char line[48];
+        int len = snprintf(line, sizeof(line), "@%d.%d FIN\n", ch->gid, ch->player);
+        out_push(s, line, (size_t)len);
+    }
+    if (ch->prev) ch->prev->next = ch->next;
+    else s->chans = ch->next;
+    if (ch->next) ch->next->prev = ch->prev;
+    s->open--;
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_cond_destroy(&ch->readable);
+    free(ch);
+    c->priv = NULL;
+    mux_seats--;
+    session_unref(s);
+}
+
+static const ConnOps mux_ops = { mux_read, mux_write, mux_close, mux_wait_writable, mux_wait_readable, mux_close };
+
+// Fait de c un siège de la session; 0 si la session est perdue ou la mémoire manque.
+int mux_chan_init(Conn *c, MuxSession *s) {
+    MuxChan *ch = calloc(1, sizeof(*ch));
+    if (!ch) return 0;
+    ch->s = s;
+    pthread_cond_init(&ch->readable, NULL);
+
+    pthread_mutex_lock(&s->lock);
+    if (s->dead) {
+        pthread_mutex_unlock(&s->lock);
+        pthread_cond_destroy(&ch->readable);
+        free(ch);
+        return 0;
+    }
+    ch->next = s->chans;
+    if (s->chans) s->chans->prev = ch;
+    s->chans = ch;
+    s->open++;
+    s->refs++;
+    pthread_mutex_unlock(&s->lock);
+
+    conn_init(c, -1);
+    c->ops = &mux_ops;
+    c->priv = ch;
+    mux_seats++;
+    return 1;
+}
+
+// Attache le siège à sa place: ses lignes portent désormais ces numéros.
+void mux_bind(Conn *c, int gid, int player) {
+    if (!conn_is_mux(c)) return;
+    MuxChan *ch = c->priv;
+    pthread_mutex_lock(&ch->s->lock);
+    ch->gid = gid;
+    ch->player = player;
+    pthread_mutex_unlock(&ch->s->lock);
+}
+
+// Vrai pour un siège de session multiplexée (ne peut pas changer de processus).
+int conn_is_mux(const Conn *c) {
+    return c->ops == &mux_ops;
+}
+
+// Relevé des compteurs de sessions.
+void mux_stats(MuxStats *st) {
+    st->sessions = mux_sessions;
+    st->seats = mux_seats;
+    st->dropped = mux_dropped;
+}
@@ -1,6 +1,16 @@
+#define _GNU_SOURCE
+
 #include "headers/net.h"
 #include "headers/util.h"
 
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <sys/un.h>
+
+static _Atomic long out_slow, out_recovered, out_overflows, out_queued;
+static _Atomic long conn_timeouts;   // Échecs ETIMEDOUT: pair déclaré mort par le noyau
+
 // Utilise SO_REUSEADDR pour redémarrer un socket sans délai.
 static int set_reuseaddr(int fd) {
     int yes = 1;
@@ -34,6 +44,43 @@ int tcp_listen(const char *port) {
     return fd;
 }
 
+// Socket d'écoute local (AF_UNIX); un fichier restant d'un lancement précédent est remplacé.
+int unix_listen(const char *path) {
+    struct sockaddr_un sa;
+    if (strlen(path) >= sizeof(sa.sun_path)) return -1;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(fd, 32) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Se connecte au socket local du serveur.
+int unix_connect(const char *path) {
+    struct sockaddr_un sa;
+    if (strlen(path) >= sizeof(sa.sun_path)) return -1;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
 // Se connecte à un hôte distant en mode bloquant.
 int tcp_connect(const char *host, const char *port) {
     struct addrinfo hints, *res, *p;
@@ -86,3 +133,297 @@ int recv_line(FILE *in, char *buf, int cap) {
     trim_crlf(buf);
     return 1;
 }
+
+// Sondes keepalive sur un socket TCP accepté, et même échéance pour des
+// données envoyées jamais acquittées (TCP_USER_TIMEOUT): un hôte disparu
+// sans FIN fait échouer lectures et écritures en ETIMEDOUT.
+int tcp_keepalive(int fd, const Keepalive *k) {
+    int on = k->idle_s > 0;
+    if (setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) < 0) return 0;
+    if (!on) return 1;
+    unsigned user_ms = (unsigned)(k->idle_s + k->interval_s * k->count) * 1000u;
+    return setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &k->idle_s, sizeof(k->idle_s)) == 0 &&
+           setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &k->interval_s, sizeof(k->interval_s)) == 0 &&
+           setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &k->count, sizeof(k->count)) == 0 &&
+           setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_ms, sizeof(user_ms)) == 0;
+}
+
+static ssize_t sock_read(Conn *c, char *buf, size_t n) {
+    return read(c->fd, buf, n);
+}
+
+// Écriture non bloquante: EAGAIN quand le tampon noyau est plein.
+static ssize_t sock_write(Conn *c, const char *buf, size_t n) {
+    return send(c->fd, buf, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static void sock_close(Conn *c) {
+    close(c->fd);
+}
+
+// Attend que le socket accepte de nouveau des octets.
+int sock_wait_writable(Conn *c, int timeout_ms) {
+    struct pollfd pfd = { c->fd, POLLOUT, 0 };
+    int r;
+    while ((r = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {}
+    return r > 0;
+}
+
+// Attend des octets à lire (ou la fermeture) au plus timeout_ms.
+int sock_wait_readable(Conn *c, int timeout_ms) {
+    struct pollfd pfd = { c->fd, POLLIN, 0 };
+    int r;
+    while ((r = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {}
+    return r > 0;
+}
+
+static const ConnOps sock_ops = { sock_read, sock_write, sock_close, sock_wait_writable, sock_wait_readable, sock_close };
+
+// Associe un socket à une connexion au tampon vide.
+void conn_init(Conn *c, int fd) {
+    c->ops = &sock_ops;
+    c->priv = NULL;
+    c->fd = fd;
+    c->passed_fd = -1;
+    c->rpos = 0;
+    c->rlen = 0;
+    c->oq = NULL;
+    c->oq_head = 0;
+    c->oq_len = 0;
+    c->slow_since = 0;
+}
+
+// Rend les ressources locales communes aux deux fermetures.
+static void conn_release(Conn *c) {
+    if (c->passed_fd >= 0) close(c->passed_fd);
+    c->passed_fd = -1;
+    out_queued -= c->oq_len;
+    free(c->oq);
+    c->oq = NULL;
+    c->oq_len = 0;
+}
+
+// Ferme la connexion selon son transport.
+void conn_close(Conn *c) {
+    c->ops->close(c);
+    conn_release(c);
+}
+
+// Oublie une connexion transmise à un autre processus (qui en a ses propres copies).
+void conn_detach(Conn *c) {
+    c->ops->detach(c);
+    conn_release(c);
+}
+
+// Écrit sans attendre; renvoie le nombre d'octets passés, -1 si la connexion est rompue.
+static ssize_t write_some(Conn *c, const char *p, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t w = c->ops->write(c, p + done, n - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (w < 0 && errno == ETIMEDOUT) conn_timeouts++;
+        if (w <= 0) return -1;
+        done += (size_t)w;
+    }
+    return (ssize_t)done;
+}
+
+// Met à jour l'état lent/normal selon les seuils de la file.
+static void outq_watermarks(Conn *c) {
+    if (!c->slow_since && c->oq_len >= CONN_OUTQ_HIGH) {
+        c->slow_since = mono_now();
+        out_slow++;
+    } else if (c->slow_since && c->oq_len <= CONN_OUTQ_LOW) {
+        c->slow_since = 0;
+        out_recovered++;
+    }
+}
+
+// Vide autant que possible la file sans attendre; 0 si la connexion est rompue.
+static int outq_drain(Conn *c) {
+    while (c->oq_len > 0) {
+        size_t off = c->oq_head;
+        size_t chunk = CONN_OUTQ_MAX - off < c->oq_len ? CONN_OUTQ_MAX - off : c->oq_len;
+        ssize_t w = write_some(c, c->oq + off, chunk);
+        if (w < 0) return 0;
+        c->oq_head = (uint32_t)((off + (size_t)w) % CONN_OUTQ_MAX);
+        c->oq_len -= (uint32_t)w;
+        out_queued -= w;
+        if ((size_t)w < chunk) break;
+    }
+    if (c->oq_len == 0) c->oq_head = 0;
+    outq_watermarks(c);
+    return 1;
+}
+
+// Ajoute des octets en fin de file; 0 si la file déborderait.
+static int outq_push(Conn *c, const char *p, size_t n) {
+    if (c->oq_len + n > CONN_OUTQ_MAX) {
+        out_overflows++;
+        return 0;
+    }
+    if (!c->oq && !(c->oq = malloc(CONN_OUTQ_MAX))) return 0;
+
+    size_t off = (c->oq_head + c->oq_len) % CONN_OUTQ_MAX;
+    size_t first = CONN_OUTQ_MAX - off < n ? CONN_OUTQ_MAX - off : n;
+    memcpy(c->oq + off, p, first);
+    memcpy(c->oq, p + first, n - first);
+    c->oq_len += (uint32_t)n;
+    out_queued += (long)n;
+    return 1;
+}
+
+// Envoie sans jamais bloquer: ce qui ne passe pas tout de suite est mis en
+// file, derrière ce qui y attend déjà. 0 si la connexion est rompue ou la file pleine.
+static int conn_send(Conn *c, const char *p, size_t n) {
+    if (c->oq_len > 0) {
+        if (!outq_drain(c)) return 0;
+        if (c->oq_len > 0) {
+            int ok = outq_push(c, p, n);
+            outq_watermarks(c);
+            return ok;
+        }
+    }
+
+    ssize_t w = write_some(c, p, n);
+    if (w < 0) return 0;
+    if ((size_t)w == n) return 1;
+    int ok = outq_push(c, p + w, n - (size_t)w);
+    outq_watermarks(c);
+    return ok;
+}
+
+// Envoie une ligne terminée par \n en un seul write dans le cas courant.
+int conn_send_line(Conn *c, const char *line) {
+    char buf[LINE_MAX + 1];
+    size_t n = strlen(line);
+    if (n >= LINE_MAX) return conn_send(c, line, n) && conn_send(c, "\n", 1);
+    memcpy(buf, line, n);
+    buf[n] = '\n';
+    return conn_send(c, buf, n + 1);
+}
+
+// Attend au plus timeout_ms que la file de sortie soit vide; 0 sinon ou si la connexion est rompue.
+int conn_flush(Conn *c, int timeout_ms) {
+    double deadline = mono_now() + timeout_ms / 1000.0;
+    for (;;) {
+        if (!outq_drain(c)) return 0;
+        if (c->oq_len == 0) return 1;
+        int left = (int)((deadline - mono_now()) * 1000.0);
+        if (left <= 0 || !c->ops->wait_writable(c, left)) return 0;
+    }
+}
+
+// Vide plusieurs files avec une échéance commune: un client lent ne retarde
+// pas les suivants. Chaque passe pousse toutes les files; l'attente ne porte
+// que sur la première encore pleine, par tranches de CONN_FLUSH_SLICE_MS.
+// ok[i] vaut 1 si la file i est vide (ou cs[i] NULL), 0 sinon. Renvoie le
+// nombre d'échecs.
+int conn_flush_all(Conn **cs, int n, int timeout_ms, int *ok) {
+    double deadline = mono_now() + timeout_ms / 1000.0;
+    for (int i = 0; i < n; i++) ok[i] = cs[i] ? -1 : 1;
+    int failed = 0;
+    for (;;) {
+        Conn *full = NULL;
+        for (int i = 0; i < n; i++) {
+            if (ok[i] >= 0) continue;
+            if (!outq_drain(cs[i])) {
+                ok[i] = 0;
+                failed++;
+            } else if (cs[i]->oq_len == 0) ok[i] = 1;
+            else if (!full) full = cs[i];
+        }
+        if (!full) return failed;
+
+        int left = (int)((deadline - mono_now()) * 1000.0);
+        if (left <= 0) break;
+        full->ops->wait_writable(full, left < CONN_FLUSH_SLICE_MS ? left : CONN_FLUSH_SLICE_MS);
+    }
+    for (int i = 0; i < n; i++)
+        if (ok[i] < 0) {
+            ok[i] = 0;
+            failed++;
+        }
+    return failed;
+}
+
+// Durée (s) depuis laquelle la connexion est au-dessus du seuil haut, 0 sinon.
+double conn_slow_for(const Conn *c) {
+    return c->slow_since ? mono_now() - c->slow_since : 0;
+}
+
+// Relevé des compteurs de files de sortie.
+void conn_out_stats(ConnOutStats *s) {
+    s->slow = out_slow;
+    s->recovered = out_recovered;
+    s->overflows = out_overflows;
+    s->queued = out_queued;
+    s->timeouts = conn_timeouts;
+}
+
+// Lit une ligne (tronquée à cap - 1 octets, le reste est ignoré) sans CR/LF.
+int conn_recv_line(Conn *c, char *buf, int cap) {
+    return conn_recv_line_timed(c, buf, cap, -1);
+}
+
+// Comme conn_recv_line, mais renvoie -1 si aucune ligne complète n'est
+// arrivée en timeout_ms (< 0: sans limite); l'échéance vaut pour toute la
+// ligne. Une ligne entamée reste dans le tampon de lecture pour l'appel
+// suivant, sauf au-delà de CONN_RBUF octets (ligne démesurée: le début en
+// est pris, et perdu si l'échéance tombe avant la fin). À 0 (fermeture),
+// errno vaut ETIMEDOUT si le noyau a déclaré le pair mort, 0 pour une
+// fermeture normale.
+int conn_recv_line_timed(Conn *c, char *buf, int cap, int timeout_ms) {
+    double deadline = mono_now() + timeout_ms / 1000.0;
+    int n = 0;
+    for (;;) {
+        const char *start = c->rbuf + c->rpos;
+        int avail = c->rlen - c->rpos;
+        const char *nl = memchr(start, '\n', (size_t)avail);
+
+        // Ligne complète, ou tampon plein sans fin de ligne: on prend
+        if (nl || avail == CONN_RBUF) {
+            int take = nl ? (int)(nl - start) : avail;
+            int room = cap - 1 - n;
+            int copy = take < room ? take : room;
+            if (copy > 0) {
+                memcpy(buf + n, start, (size_t)copy);
+                n += copy;
+            }
+            c->rpos += nl ? take + 1 : take;
+            if (nl) break;
+            continue;
+        }
+
+        // Début de ligne ramené en tête, puis lecture à la suite
+        if (c->rpos > 0) {
+            memmove(c->rbuf, start, (size_t)avail);
+            c->rpos = 0;
+            c->rlen = avail;
+        }
+        if (timeout_ms >= 0) {
+            int left = (int)((deadline - mono_now()) * 1000.0);
+            if (left < 0 || !c->ops->wait_readable(c, left)) return -1;
+        }
+        ssize_t r = c->ops->read(c, c->rbuf + c->rlen, (size_t)(CONN_RBUF - c->rlen));
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && errno == ETIMEDOUT) conn_timeouts++;
+        if (r == 0) errno = 0;
+        if (r <= 0) {
+            // Fermeture au milieu d'une ligne: le morceau reçu tient lieu de ligne
+            if (n == 0 && avail == 0) return 0;
+            int copy = avail < cap - 1 - n ? avail : cap - 1 - n;
+            if (copy > 0) {
+                memcpy(buf + n, c->rbuf, (size_t)copy);
+                n += copy;
+            }
+            c->rpos = c->rlen = 0;
+            break;
+        }
+        c->rlen += (int)r;
+    }
+    buf[n] = 0;
+    trim_crlf(buf);
+    return 1;
+}
@@ -0,0 +1,167 @@
+#include "headers/policy.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define POLICY_MAGIC "6QPTABL"        // 8 octets, zéro final compris
+#define POLICY_HEADER_SIZE 4096        // Tables alignées sur une page
+#define POLICY_ENDIAN 0x01020304u      // Relu autrement: fichier d'une autre architecture
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t nplayers;
+    uint32_t row_max;
+    uint32_t hand_size;
+    uint32_t gap_max;
+    uint32_t bulls_max;
+    uint32_t scale;
+    uint64_t games;                    // Parties simulées
+    uint64_t place_off;                // Décalages des tableaux, en octets
+    uint64_t pick_off;
+    uint64_t size;                     // Taille totale attendue du fichier
+    char variant[16];
+} PolicyHeader;
+
+_Static_assert(sizeof(PolicyHeader) <= POLICY_HEADER_SIZE, "PolicyHeader");
+
+struct PolicyTables {
+    void *base;
+    size_t size;
+    const uint16_t *place;
+    const uint16_t *pick;
+    PolicyShape shape;
+    uint64_t games;
+};
+
+// Nombre de cases de chaque tableau.
+size_t policy_place_cells(const PolicyShape *s) {
+    return (size_t)s->hand_size * (size_t)s->row_max * (size_t)s->gap_max * (POLICY_BULLS_MAX + 1);
+}
+
+size_t policy_pick_cells(const PolicyShape *s) {
+    return (size_t)s->row_max * (POLICY_BULLS_MAX + 1);
+}
+
+// Case de place[hn][len][gap][bulls] (hn, len et gap comptés à partir de 1).
+size_t policy_place_index(const PolicyShape *s, int hn, int len, int gap, int bulls) {
+    if (bulls > POLICY_BULLS_MAX) bulls = POLICY_BULLS_MAX;
+    return (((size_t)(hn - 1) * (size_t)s->row_max + (size_t)(len - 1)) * (size_t)s->gap_max +
+            (size_t)(gap - 1)) * (POLICY_BULLS_MAX + 1) + (size_t)bulls;
+}
+
+size_t policy_pick_index(const PolicyShape *s, int len, int bulls) {
+    (void)s;
+    if (bulls > POLICY_BULLS_MAX) bulls = POLICY_BULLS_MAX;
+    return (size_t)(len - 1) * (POLICY_BULLS_MAX + 1) + (size_t)bulls;
+}
+
+// Écrit un jeu de tables (fichier temporaire renommé: un robot qui ouvre
+// le fichier pendant la génération voit l'ancienne version entière).
+int policy_write(const char *path, const PolicyShape *s, uint64_t games,
+                 const uint16_t *place, const uint16_t *pick) {
+    size_t nplace = policy_place_cells(s), npick = policy_pick_cells(s);
+    PolicyHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, POLICY_MAGIC, 8);
+    h.version = POLICY_VERSION;
+    h.endian = POLICY_ENDIAN;
+    h.nplayers = (uint32_t)s->nplayers;
+    h.row_max = (uint32_t)s->row_max;
+    h.hand_size = (uint32_t)s->hand_size;
+    h.gap_max = (uint32_t)s->gap_max;
+    h.bulls_max = POLICY_BULLS_MAX;
+    h.scale = POLICY_SCALE;
+    h.games = games;
+    h.place_off = POLICY_HEADER_SIZE;
+    h.pick_off = h.place_off + nplace * sizeof(uint16_t);
+    h.size = h.pick_off + npick * sizeof(uint16_t);
+    snprintf(h.variant, sizeof(h.variant), "%s", s->variant);
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+    static const char zero[POLICY_HEADER_SIZE];
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             fwrite(zero, POLICY_HEADER_SIZE - sizeof(h), 1, f) == 1 &&
+             fwrite(place, sizeof(uint16_t), nplace, f) == nplace &&
+             fwrite(pick, sizeof(uint16_t), npick, f) == npick;
+    ok = fclose(f) == 0 && ok;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) unlink(tmp);
+    return ok;
+}
+
+// Projette un fichier de tables en lecture seule; NULL (errno) si absent,
+// d'une autre version ou tronqué. Seul l'en-tête est lu ici.
+PolicyTables *policy_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    PolicyHeader h;
+    if (fstat(fd, &st) < 0 || pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        close(fd);
+        return NULL;
+    }
+
+    PolicyShape s = { (int)h.nplayers, (int)h.row_max, (int)h.hand_size, (int)h.gap_max, "" };
+    memcpy(s.variant, h.variant, sizeof(s.variant) - 1);
+    if (memcmp(h.magic, POLICY_MAGIC, 8) != 0 || h.version != POLICY_VERSION ||
+        h.endian != POLICY_ENDIAN || h.bulls_max != POLICY_BULLS_MAX || h.scale != POLICY_SCALE ||
+        h.row_max < 1 || h.row_max > ROW_MAX || h.hand_size < 1 || h.hand_size > HAND_SIZE ||
+        h.gap_max < 1 || h.gap_max >= DECK_MAX || h.place_off != POLICY_HEADER_SIZE ||
+        h.pick_off != h.place_off + policy_place_cells(&s) * sizeof(uint16_t) ||
+        h.size != h.pick_off + policy_pick_cells(&s) * sizeof(uint16_t) ||
+        (uint64_t)st.st_size != h.size) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    void *base = mmap(NULL, (size_t)h.size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    PolicyTables *t = calloc(1, sizeof(*t));
+    if (!t) {
+        munmap(base, (size_t)h.size);
+        return NULL;
+    }
+    t->base = base;
+    t->size = (size_t)h.size;
+    t->place = (const uint16_t *)((char *)base + h.place_off);
+    t->pick = (const uint16_t *)((char *)base + h.pick_off);
+    t->shape = s;
+    t->games = h.games;
+    return t;
+}
+
+void policy_close(PolicyTables *t) {
+    if (!t) return;
+    munmap(t->base, t->size);
+    free(t);
+}
+
+const PolicyShape *policy_shape(const PolicyTables *t) {
+    return &t->shape;
+}
+
+uint64_t policy_games(const PolicyTables *t) {
+    return t->games;
+}
+
+// Espérance tabulée pour une pose; -1 hors des dimensions du fichier.
+double policy_place(const PolicyTables *t, int hn, int len, int gap, int bulls) {
+    const PolicyShape *s = &t->shape;
+    if (hn < 1 || hn > s->hand_size || len < 1 || len > s->row_max || gap < 1 || gap > s->gap_max || bulls < 0)
+        return -1;
+    return (double)t->place[policy_place_index(s, hn, len, gap, bulls)] / POLICY_SCALE;
+}
+
+// Valeur tabulée d'une rangée ramassée; -1 hors des dimensions du fichier.
+double policy_pick(const PolicyTables *t, int len, int bulls) {
+    if (len < 1 || len > t->shape.row_max || bulls < 0) return -1;
+    return (double)t->pick[policy_pick_index(&t->shape, len, bulls)] / POLICY_SCALE;
+}
@@ -0,0 +1,71 @@
+#include "headers/pool.h"
+
+// Prépare un pool vide; les objets sont alloués à la demande par blocs.
+void pool_init(Pool *p, const char *name, size_t obj_size, size_t chunk_objs) {
+    memset(p, 0, sizeof(*p));
+    p->name = name;
+    if (obj_size < sizeof(void *)) obj_size = sizeof(void *);
+    p->obj_size = (obj_size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    p->chunk_objs = chunk_objs ? chunk_objs : 64;
+    pthread_mutex_init(&p->lock, NULL);
+}
+
+// Ajoute un bloc de count objets à la liste libre. Appelée avec le verrou tenu.
+static int pool_grow(Pool *p, size_t count) {
+    char *chunk = aligned_alloc(POOL_ALIGN, p->obj_size * count);
+    if (!chunk) return 0;
+
+    for (size_t i = count; i-- > 0;) {
+        void *obj = chunk + i * p->obj_size;
+        *(void **)obj = p->free_list;
+        p->free_list = obj;
+    }
+    p->capacity += count;
+    return 1;
+}
+
+// Préalloue de quoi servir count objets sans nouvelle allocation.
+int pool_reserve(Pool *p, size_t count) {
+    pthread_mutex_lock(&p->lock);
+    int ok = 1;
+    if (count > p->capacity) ok = pool_grow(p, count - p->capacity);
+    pthread_mutex_unlock(&p->lock);
+    return ok;
+}
+
+// Fournit un objet remis à zéro (NULL si la mémoire manque).
+void *pool_get(Pool *p) {
+    pthread_mutex_lock(&p->lock);
+    if (!p->free_list && !pool_grow(p, p->chunk_objs)) {
+        pthread_mutex_unlock(&p->lock);
+        return NULL;
+    }
+    void *obj = p->free_list;
+    p->free_list = *(void **)obj;
+    p->in_use++;
+    if (p->in_use > p->peak) p->peak = p->in_use;
+    pthread_mutex_unlock(&p->lock);
+
+    memset(obj, 0, p->obj_size);
+    return obj;
+}
+
+// Rend un objet au pool.
+void pool_put(Pool *p, void *obj) {
+    if (!obj) return;
+    pthread_mutex_lock(&p->lock);
+    *(void **)obj = p->free_list;
+    p->free_list = obj;
+    p->in_use--;
+    pthread_mutex_unlock(&p->lock);
+}
+
+// Une ligne d'état: taille d'objet, occupation, pic et mémoire réservée.
+int pool_report(Pool *p, char *buf, size_t cap) {
+    pthread_mutex_lock(&p->lock);
+    int n = snprintf(buf, cap, "%-10s objet=%zu o  utilises=%zu  pic=%zu  capacite=%zu  reserve=%zu Ko",
+                     p->name, p->obj_size, p->in_use, p->peak, p->capacity,
+                     p->capacity * p->obj_size / 1024);
+    pthread_mutex_unlock(&p->lock);
+    return n;
+}
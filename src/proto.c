@@ -0,0 +1,157 @@
+#include "headers/proto.h"
+#include "headers/util.h"
+
+#include <ctype.h>
+#include <strings.h>
+
+// Sépare le pseudo des capacités "+XXX" qui le suivent sur la ligne d'accueil;
+// variant: variante demandée, -1 si aucune.
+int parse_hello(const char *line, char *name, int cap, int *caps, int *variant) {
+    static const struct { const char *tok; int flag; } known[] = {
+        { "+DELTA", CAP_DELTA },
+        { "+PIPELINE", CAP_PIPELINE },
+        { "+PING", CAP_PING },
+        { "+MUX", CAP_MUX },
+    };
+    const char *end = line + strlen(line);
+
+    *caps = 0;
+    *variant = -1;
+    for (;;) {
+        const char *e = end;
+        while (e > line && isspace((unsigned char)e[-1])) e--;
+        const char *b = e;
+        while (b > line && !isspace((unsigned char)b[-1])) b--;
+        if (b == e || *b != '+') {
+            end = e;
+            break;
+        }
+
+        // "+VARIANTE=<nom>": règles demandées (VARIANT_COUNT si inconnues)
+        size_t plen = strlen(HELLO_VARIANT);
+        if ((size_t)(e - b) > plen && strncasecmp(b, HELLO_VARIANT, plen) == 0) {
+            char vname[32];
+            Rules r;
+            snprintf(vname, sizeof(vname), "%.*s", (int)(e - b) - (int)plen, b + plen);
+            *variant = rules_lookup(vname, &r) ? (int)r.id : VARIANT_COUNT;
+            end = b;
+            continue;
+        }
+
+        int flag = 0;
+        for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++)
+            if ((size_t)(e - b) == strlen(known[i].tok) && strncasecmp(b, known[i].tok, (size_t)(e - b)) == 0)
+                flag = known[i].flag;
+        *caps |= flag; // Capacité inconnue: ignorée
+        end = b;
+    }
+
+    int n = (int)(end - line);
+    if (n > cap - 1) n = cap - 1;
+    memcpy(name, line, (size_t)n);
+    name[n] = 0;
+    return n > 0;
+}
+
+// Analyse  d'une commande JOUER envoyée par un client: "JOUER <carte> [rangee]".
+// La rangée annoncée (1..ROWS) sera ramassée si la carte en impose une; 0 sinon.
+int parse_play(const char *line, int *card, int *row) {
+    while (*line && isspace((unsigned char)*line)) line++;
+    if (strncasecmp(line, "JOUER", 5) == 0) {
+        line += 5;
+        while (*line && isspace((unsigned char)*line)) line++;
+    }
+
+    char *e;
+    long c = strtol(line, &e, 10);
+    if (e == line || c <= 0 || c > 2147483647L) return 0;
+
+    long r = 0;
+    line = e;
+    while (*line && isspace((unsigned char)*line)) line++;
+    if (*line) {
+        r = strtol(line, &e, 10);
+        if (e == line || r < 1 || r > ROWS) return 0;
+        line = e;
+        while (*line && isspace((unsigned char)*line)) line++;
+        if (*line) return 0;
+    }
+
+    *card = (int)c;
+    *row = (int)r;
+    return 1;
+}
+
+// Extrait les valeurs entières de la main envoyée par le serveur.
+int parse_hand(const char *line, int *cards, int cap) {
+    int n = 0;
+    const char *p = line;
+
+    while (*p && *p != ' ') p++;
+    while (*p == ' ') p++;
+
+    while (*p && n < cap) {
+        int v = atoi(p);
+        if (v > 0) cards[n++] = v;
+        while (*p && *p != ' ') p++;
+        while (*p == ' ') p++;
+    }
+    return n;
+}
+
+// Reconstruit les quatre rangées décrites dans la ligne R1:/R2:.
+void parse_table_rows(const char *line, Row rows[ROWS]) {
+    for (int r = 0; r < ROWS; r++) rows[r].len = 0;
+
+    const char *p = line;
+    for (int r = 0; r < ROWS; r++) {
+        while (*p && *p != ':') p++;
+        if (!*p) break;
+        p++;
+        while (*p == ' ') p++;
+
+        while (*p && *p != '|') {
+            int v = atoi(p);
+            if (v > 0 && rows[r].len < ROW_MAX)
+                rows[r].cards[rows[r].len++] = v;
+
+            while (*p && *p != ' ' && *p != '|') p++;
+            while (*p == ' ') p++;
+        }
+        while (*p && *p != 'R')
+            p++;
+    }
+}
+
+// Applique un événement POSE/RAMASSE du mode delta aux rangées locales.
+// Renvoie la carte jouée, ou 0 si la ligne n'est pas un événement valide.
+int apply_table_event(const char *line, Row rows[ROWS]) {
+    int j, c, r, b;
+
+    if (sscanf(line, "POSE %d %d %d", &j, &c, &r) == 3) {
+        if (r < 1 || r > ROWS || c <= 0) return 0;
+        Row *row = &rows[r - 1];
+        if (row->len < ROW_MAX) row->cards[row->len++] = c;
+        return c;
+    }
+
+    if (sscanf(line, "RAMASSE %d %d %d %d", &j, &r, &b, &c) == 4) {
+        if (r < 1 || r > ROWS || c <= 0) return 0;
+        rows[r - 1].len = 1;
+        rows[r - 1].cards[0] = c;
+        return c;
+    }
+    return 0;
+}
+
+// Analyse "INFO REDIRECT <hote> <port>": le nœud conseille un autre serveur de la grappe.
+int parse_redirect(const char *line, char *host, int hcap, char *port, int pcap) {
+    if (!str_starts(line, REDIRECT_PREFIX)) return 0;
+
+    char h[LINE_MAX], p[LINE_MAX];
+    if (sscanf(line + strlen(REDIRECT_PREFIX), "%1023s %1023s", h, p) != 2) return 0;
+    if ((int)strlen(h) >= hcap || (int)strlen(p) >= pcap) return 0;
+    strcpy(host, h);
+    strcpy(port, p);
+    return 1;
+}
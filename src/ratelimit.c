@@ -0,0 +1,164 @@
+#include "headers/ratelimit.h"
+
+#include <pthread.h>
+
+static const char *kind_names[RATE_KINDS] = { "lignes", "invalides", "connexions" };
+static const char *penalty_names[] = { "delai", "bot", "deconnexion" };
+
+RateConfig rate_config = {
+    { { 100, 200 }, { 2, 5 }, { 5, 20 } },
+    PENALTY_BOT
+};
+
+// Seaux d'une adresse source; addr 0: emplacement libre.
+typedef struct {
+    uint32_t addr;
+    double seen;
+    Bucket b[RATE_KINDS];
+} AddrSlot;
+
+static AddrSlot addr_slots[RATE_ADDR_SLOTS];
+static pthread_mutex_t addr_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Remplit un seau au maximum.
+void bucket_init(Bucket *b, const RateLimit *l, double now) {
+    b->tokens = l->burst;
+    b->stamp = now;
+}
+
+// Ajoute les jetons accumulés depuis le dernier passage.
+static void bucket_refill(Bucket *b, const RateLimit *l, double now) {
+    if (now > b->stamp) {
+        b->tokens += (now - b->stamp) * l->rate;
+        if (b->tokens > l->burst) b->tokens = l->burst;
+    }
+    b->stamp = now;
+}
+
+// Prend un jeton; 0 si le seau est vide (limite dépassée).
+int bucket_take(Bucket *b, const RateLimit *l, double now) {
+    if (l->rate <= 0) return 1;
+    bucket_refill(b, l, now);
+    if (b->tokens < 1) return 0;
+    b->tokens -= 1;
+    return 1;
+}
+
+// Secondes avant qu'un jeton soit disponible.
+double bucket_wait(const Bucket *b, const RateLimit *l, double now) {
+    if (l->rate <= 0) return 0;
+    double tokens = b->tokens + (now > b->stamp ? (now - b->stamp) * l->rate : 0);
+    return tokens >= 1 ? 0 : (1 - tokens) / l->rate;
+}
+
+// Adresse soumise aux limites: ni connexion locale, ni boucle locale.
+int rate_addr_limited(uint32_t addr) {
+    return addr != 0 && (addr >> 24) != 127;
+}
+
+// Limite appliquée à une adresse pour un type d'événement.
+static RateLimit addr_limit(RateKind kind) {
+    RateLimit l = rate_config.limits[kind];
+    if (kind != RATE_CONNECTS) {
+        l.rate *= RATE_ADDR_FACTOR;
+        l.burst *= RATE_ADDR_FACTOR;
+    }
+    return l;
+}
+
+// Emplacement d'une adresse (créé au besoin en oubliant la plus ancienne
+// des voisines: un seau plein équivaut à une adresse inconnue).
+// Appelée avec addr_lock tenu.
+static AddrSlot *addr_slot(uint32_t addr, double now) {
+    uint32_t h = (addr * 2654435761u) % RATE_ADDR_SLOTS;
+    AddrSlot *oldest = NULL;
+    for (int i = 0; i < RATE_ADDR_PROBE; i++) {
+        AddrSlot *s = &addr_slots[(h + (uint32_t)i) % RATE_ADDR_SLOTS];
+        if (s->addr == addr) {
+            s->seen = now;
+            return s;
+        }
+        if (s->addr == 0) {
+            if (!oldest || oldest->addr != 0) oldest = s;
+        } else if (!oldest || (oldest->addr != 0 && s->seen < oldest->seen)) {
+            oldest = s;
+        }
+    }
+    oldest->addr = addr;
+    oldest->seen = now;
+    for (int k = 0; k < RATE_KINDS; k++) {
+        RateLimit l = addr_limit((RateKind)k);
+        bucket_init(&oldest->b[k], &l, now);
+    }
+    return oldest;
+}
+
+// Prend un jeton dans le seau d'une adresse; 1 si l'événement est permis.
+int rate_addr_take(uint32_t addr, RateKind kind, double now) {
+    if (!rate_addr_limited(addr) || rate_config.limits[kind].rate <= 0) return 1;
+    RateLimit l = addr_limit(kind);
+    pthread_mutex_lock(&addr_lock);
+    int ok = bucket_take(&addr_slot(addr, now)->b[kind], &l, now);
+    pthread_mutex_unlock(&addr_lock);
+    return ok;
+}
+
+// Secondes avant qu'un jeton soit disponible pour cette adresse.
+double rate_addr_wait(uint32_t addr, RateKind kind, double now) {
+    if (!rate_addr_limited(addr) || rate_config.limits[kind].rate <= 0) return 0;
+    RateLimit l = addr_limit(kind);
+    pthread_mutex_lock(&addr_lock);
+    double w = bucket_wait(&addr_slot(addr, now)->b[kind], &l, now);
+    pthread_mutex_unlock(&addr_lock);
+    return w;
+}
+
+// Lit "lignes=100/200,invalides=2/5,connexions=5/20" (débit/rafale, 0: sans
+// limite; la rafale vaut le débit si elle est omise). Types absents inchangés.
+int rate_parse(const char *spec, RateConfig *cfg) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(item, '=');
+        if (!eq) return 0;
+        *eq = 0;
+        int k = 0;
+        while (k < RATE_KINDS && strcmp(item, kind_names[k]) != 0) k++;
+        if (k == RATE_KINDS) return 0;
+
+        char *end;
+        double rate = strtod(eq + 1, &end);
+        double burst = rate;
+        if (end == eq + 1) return 0;
+        if (*end == '/') {
+            char *b = end + 1;
+            burst = strtod(b, &end);
+            if (end == b) return 0;
+        }
+        if (*end || rate < 0 || (rate > 0 && burst < 1)) return 0;
+        cfg->limits[k].rate = rate;
+        cfg->limits[k].burst = burst;
+    }
+    return 1;
+}
+
+// Pénalité par son nom (delai, bot, deconnexion).
+int penalty_lookup(const char *name, Penalty *p) {
+    for (int i = 0; i < (int)(sizeof(penalty_names) / sizeof(penalty_names[0])); i++)
+        if (strcmp(name, penalty_names[i]) == 0) {
+            *p = (Penalty)i;
+            return 1;
+        }
+    return 0;
+}
+
+// Nom d'une pénalité, pour les rapports.
+const char *penalty_name(Penalty p) {
+    return penalty_names[p];
+}
+
+// Nom d'un type de limite, tel qu'écrit dans -R.
+const char *rate_kind_name(RateKind k) {
+    return kind_names[k];
+}
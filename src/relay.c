@@ -0,0 +1,579 @@
+#define _GNU_SOURCE
+
+#include "headers/common.h"
+#include "headers/net.h"
+#include "headers/util.h"
+
+#include <math.h>
+#include <poll.h>
+#include <netinet/tcp.h>
+#include <sys/signalfd.h>
+
+/*
+ * Relais d'essai entre les clients (client, robot) et le serveur, pour jouer
+ * en local dans les conditions d'un réseau étendu. Chaque connexion acceptée
+ * ouvre la sienne vers le serveur et reçoit un profil réseau (les -r sont
+ * attribués à tour de rôle). Dans chaque sens, chaque ligne est retenue le
+ * temps d'un trajet simulé: émission au débit du profil, puis latence ±
+ * gigue. Une ligne "perdue" attend en plus un délai de retransmission; le
+ * flux TCP reste intact, comme après une perte réelle: elle et les lignes
+ * suivantes arrivent en retard. L'ordre des lignes est conservé. Une coupure
+ * ferme les deux côtés, ou avec -m les rend muets (plus rien ne passe, comme
+ * un hôte disparu sans FIN).
+ * Mesures par profil: réponse d'un siège (de l'invite lue du serveur à la
+ * carte ou la rangée remise au serveur, ce qu'attend game_thread), durée
+ * d'un tour (écart entre deux MAIN/TOUR d'un siège) et trajet des lignes.
+ * SIGUSR2 affiche le rapport; SIGINT, SIGTERM ou la fin de -d l'affichent
+ * puis arrêtent le relais. Un seul thread, poll() sur toutes les connexions.
+ * Usage: ./relais [-r profil]... [-m] [-o journal] [-d secondes] [-s graine]
+ *                 <port_local> <hote> <port>
+ */
+
+#define PROFILES_MAX 16
+#define RELAY_RBUF 4096
+#define RTO_MIN_MS 200.0              // Délai minimal de retransmission TCP (Linux)
+#define DEFAULT_PROFILE "50/10"
+
+// Conditions réseau d'une connexion, dans chaque sens.
+typedef struct {
+    double latency_ms;
+    double jitter_ms;                 // Écart uniforme dans [-gigue, +gigue]
+    double rate;                      // Octets/s, 0: illimité
+    double loss;                      // Probabilité de perte d'une ligne
+    double lifetime_s;                // Durée de vie moyenne (exponentielle), 0: jamais coupée
+    char spec[48];
+} Profile;
+
+// Échantillons d'une mesure en ms, triés pour le rapport.
+typedef struct {
+    double *v;
+    long n, cap;
+} Samples;
+
+enum { S_RESP, S_TURN, S_TRIP, SAMPLES };
+
+typedef struct {
+    Profile p;
+    long links, cuts, lines, losses;
+    Samples s[SAMPLES];
+} ProfileStats;
+
+// Ligne en transit: lue à read_at, remise au destinataire à partir de due.
+typedef struct Msg {
+    struct Msg *next;
+    double read_at;
+    double due;
+    int len;
+    int off;                          // Octets déjà écrits
+    char data[];
+} Msg;
+
+// Un sens d'une connexion: lignes lues sur from, en attente d'écriture sur to.
+typedef struct {
+    int from, to;
+    int eof;                          // from fermé: to est fermé en écriture après la file
+    int shut;
+    int blocked;                      // Dernière écriture en EAGAIN: attendre POLLOUT
+    Msg *head, *tail;
+    double busy_until;                // Fin d'émission de la dernière ligne (débit)
+    double last_due;                  // Arrivée de la dernière ligne (ordre conservé)
+    int rlen;
+    char rbuf[RELAY_RBUF];
+} Dir;
+
+enum { UP, DOWN };                    // client -> serveur, serveur -> client
+
+// Horloges d'un siège (gid 0 hors session multiplexée).
+typedef struct {
+    int used;
+    int gid, player;
+    double asked;                     // Invite en attente de réponse, 0 sinon
+    double last_turn;                 // Dernier MAIN/TOUR de la partie, 0 sinon
+} SeatClock;
+
+typedef struct {
+    long id;
+    ProfileStats *ps;
+    Dir d[2];
+    double cut_at;                    // 0: jamais
+    int mute;
+    SeatClock *seats;
+    int nseats;
+} Link;
+
+static ProfileStats profiles[PROFILES_MAX];
+static int nprofiles;
+static Link **links;
+static int nlinks, links_cap;
+static long links_total;
+static int mute_cuts;                 // -m
+static FILE *journal;                 // -o
+static double t0;
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng_next(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static double rng_unit(void) {
+    return (double)(rng_next() >> 11) / 9007199254740992.0;
+}
+
+// Profil "latence[/gigue[/debit[/perte[/coupure]]]]": ms, ms, Ko/s, probabilité, s.
+static int parse_profile(const char *s, Profile *p) {
+    double v[5] = { 0, 0, 0, 0, 0 };
+    int n = sscanf(s, "%lf/%lf/%lf/%lf/%lf", &v[0], &v[1], &v[2], &v[3], &v[4]);
+    if (n < 1) return 0;
+    for (int i = 0; i < 5; i++)
+        if (!(v[i] >= 0)) return 0;
+    if (v[3] >= 1) return 0;
+    p->latency_ms = v[0];
+    p->jitter_ms = v[1];
+    p->rate = v[2] * 1024;
+    p->loss = v[3];
+    p->lifetime_s = v[4];
+    snprintf(p->spec, sizeof(p->spec), "%s", s);
+    return 1;
+}
+
+// Délai de retransmission d'une ligne perdue: RTT lissé + 4 x variation, au moins RTO_MIN_MS.
+static double profile_rto_ms(const Profile *p) {
+    double rto = 2 * p->latency_ms + 4 * p->jitter_ms;
+    return rto > RTO_MIN_MS ? rto : RTO_MIN_MS;
+}
+
+static void sample_add(Samples *s, double ms) {
+    if (s->n == s->cap) {
+        long cap = s->cap ? s->cap * 2 : 1024;
+        double *v = realloc(s->v, (size_t)cap * sizeof(double));
+        if (!v) die("realloc");
+        s->v = v;
+        s->cap = cap;
+    }
+    s->v[s->n++] = ms;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Quantile q d'échantillons triés.
+static double quantile(const double *v, long n, double q) {
+    long i = (long)ceil(q * n) - 1;
+    if (i < 0) i = 0;
+    return v[i];
+}
+
+// Horloges du siège gid.player, créées à la première ligne; NULL si plus de mémoire.
+static SeatClock *seat_clock(Link *l, int gid, int player) {
+    SeatClock *free_seat = NULL;
+    for (int i = 0; i < l->nseats; i++) {
+        SeatClock *s = &l->seats[i];
+        if (s->used && s->gid == gid && s->player == player) return s;
+        if (!s->used && !free_seat) free_seat = s;
+    }
+    if (!free_seat) {
+        int n = l->nseats ? l->nseats * 2 : 4;
+        SeatClock *seats = realloc(l->seats, (size_t)n * sizeof(SeatClock));
+        if (!seats) return NULL;
+        memset(seats + l->nseats, 0, (size_t)(n - l->nseats) * sizeof(SeatClock));
+        free_seat = &seats[l->nseats];
+        l->seats = seats;
+        l->nseats = n;
+    }
+    memset(free_seat, 0, sizeof(*free_seat));
+    free_seat->used = 1;
+    free_seat->gid = gid;
+    free_seat->player = player;
+    return free_seat;
+}
+
+// Copie une ligne en transit sans fin de ligne et sépare le préfixe "@gid.joueur".
+static const char *line_view(const char *data, int len, char *buf, int cap, int *gid, int *player) {
+    if (len >= cap) len = cap - 1;
+    memcpy(buf, data, (size_t)len);
+    buf[len] = '\0';
+    trim_crlf(buf);
+    *gid = *player = 0;
+    int skip = 0;
+    if (buf[0] == '@' && sscanf(buf, "@%d.%d %n", gid, player, &skip) == 2 && skip > 0) return buf + skip;
+    *gid = *player = 0;
+    return buf;
+}
+
+// Ligne du serveur, à sa lecture: invites et débuts de tour.
+static void observe_down(Link *l, const char *data, int len, double now) {
+    char buf[LINE_MAX];
+    int gid, player;
+    const char *line = line_view(data, len, buf, sizeof(buf), &gid, &player);
+    int turn = str_starts(line, "MAIN ") || str_starts(line, "TOUR ");
+    int prompt = strcmp(line, "DEMANDE_CARTE") == 0 || strcmp(line, "CHOISIR_RANGEES") == 0;
+    int start = str_starts(line, "INFO Partie");
+    int fin = gid && strcmp(line, "FIN") == 0;
+    if (!turn && !prompt && !start && !fin) return;
+
+    SeatClock *s = seat_clock(l, gid, player);
+    if (!s) return;
+    if (start || fin) {
+        s->asked = s->last_turn = 0;
+        if (fin) s->used = 0;      // Place de session libérée
+        return;
+    }
+    if (turn) {
+        if (s->last_turn > 0) sample_add(&l->ps->s[S_TURN], (now - s->last_turn) * 1000);
+        s->last_turn = now;
+    }
+    // Client +PIPELINE: la main ou TOUR n est l'invite; sinon DEMANDE_CARTE la remplace.
+    if (prompt || !s->asked) s->asked = now;
+}
+
+// Ligne du client, à sa remise au serveur: une carte ou une rangée répond à l'invite.
+static void observe_up(Link *l, const char *data, int len, double now) {
+    char buf[LINE_MAX];
+    int gid, player;
+    const char *line = line_view(data, len, buf, sizeof(buf), &gid, &player);
+    if (strncasecmp(line, "JOUER", 5) != 0 && !(line[0] >= '0' && line[0] <= '9')) return;
+    SeatClock *s = seat_clock(l, gid, player);
+    if (!s || !s->asked) return;
+    sample_add(&l->ps->s[S_RESP], (now - s->asked) * 1000);
+    s->asked = 0;
+}
+
+// Met une ligne lue en transit, avec son heure d'arrivée simulée.
+static void dir_push(Link *l, int k, const char *data, int len, double now) {
+    Dir *d = &l->d[k];
+    const Profile *p = &l->ps->p;
+    Msg *m = malloc(sizeof(*m) + (size_t)len);
+    if (!m) die("malloc");
+    memcpy(m->data, data, (size_t)len);
+    m->next = NULL;
+    m->len = len;
+    m->off = 0;
+    m->read_at = now;
+
+    double start = now > d->busy_until ? now : d->busy_until;
+    d->busy_until = start + (p->rate > 0 ? len / p->rate : 0);
+    double delay = p->latency_ms + (2 * rng_unit() - 1) * p->jitter_ms;
+    if (delay < 0) delay = 0;
+    if (p->loss > 0 && rng_unit() < p->loss) {
+        delay += profile_rto_ms(p);
+        l->ps->losses++;
+    }
+    m->due = d->busy_until + delay / 1000;
+    if (m->due < d->last_due) m->due = d->last_due;
+    d->last_due = m->due;
+
+    if (d->tail) d->tail->next = m;
+    else d->head = m;
+    d->tail = m;
+    l->ps->lines++;
+    if (k == DOWN) observe_down(l, data, len, now);
+}
+
+// Lit ce que from a reçu et met en transit chaque ligne complète; 0 en fin de flux.
+static int dir_read(Link *l, int k, double now) {
+    Dir *d = &l->d[k];
+    ssize_t r = read(d->from, d->rbuf + d->rlen, sizeof(d->rbuf) - (size_t)d->rlen);
+    if (r < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (r == 0) return 0;
+    if (l->mute) return 1;          // Connexion muette: tout se perd
+
+    int scan = d->rlen, start = 0;
+    d->rlen += (int)r;
+    for (int i = scan; i < d->rlen; i++) {
+        if (d->rbuf[i] != '\n') continue;
+        dir_push(l, k, d->rbuf + start, i + 1 - start, now);
+        start = i + 1;
+    }
+    if (start == 0 && d->rlen == (int)sizeof(d->rbuf)) {
+        dir_push(l, k, d->rbuf, d->rlen, now);     // Ligne trop longue: transmise par morceaux
+        start = d->rlen;
+    }
+    memmove(d->rbuf, d->rbuf + start, (size_t)(d->rlen - start));
+    d->rlen -= start;
+    return 1;
+}
+
+// Ligne remise au destinataire: mesures et journal.
+static void delivered(Link *l, int k, const Msg *m, double now) {
+    sample_add(&l->ps->s[S_TRIP], (now - m->read_at) * 1000);
+    if (k == UP) observe_up(l, m->data, m->len, now);
+    if (journal) {
+        char buf[LINE_MAX];
+        int gid, player;
+        line_view(m->data, m->len, buf, sizeof(buf), &gid, &player);
+        fprintf(journal, "%.6f %ld %s %.3f %s\n", m->read_at - t0, l->id, k == UP ? "C>S" : "S>C",
+                (now - m->read_at) * 1000, buf);
+    }
+}
+
+// Écrit les lignes arrivées à échéance; 0 si le destinataire est parti.
+static int dir_flush(Link *l, int k, double now) {
+    Dir *d = &l->d[k];
+    d->blocked = 0;
+    while (d->head && d->head->due <= now) {
+        Msg *m = d->head;
+        ssize_t w = send(d->to, m->data + m->off, (size_t)(m->len - m->off), MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            d->blocked = 1;
+            return 1;
+        }
+        m->off += (int)w;
+        if (m->off < m->len) continue;
+        delivered(l, k, m, now);
+        d->head = m->next;
+        if (!d->head) d->tail = NULL;
+        free(m);
+    }
+    if (d->eof && !d->head && !d->shut) {
+        shutdown(d->to, SHUT_WR);
+        d->shut = 1;
+    }
+    return 1;
+}
+
+static void dir_drop(Dir *d) {
+    while (d->head) {
+        Msg *m = d->head;
+        d->head = m->next;
+        free(m);
+    }
+    d->tail = NULL;
+}
+
+static void journal_event(const Link *l, const char *what, double now) {
+    if (journal) fprintf(journal, "%.6f %ld %s profil %d\n", now - t0, l->id, what, (int)(l->ps - profiles) + 1);
+}
+
+static void link_close(int i, const char *why, double now) {
+    Link *l = links[i];
+    journal_event(l, why, now);
+    close(l->d[UP].from);
+    close(l->d[DOWN].from);
+    dir_drop(&l->d[UP]);
+    dir_drop(&l->d[DOWN]);
+    free(l->seats);
+    free(l);
+    links[i] = links[--nlinks];
+}
+
+// Coupure programmée: fermeture franche, ou connexion muette avec -m.
+static int link_cut(int i, double now) {
+    Link *l = links[i];
+    l->ps->cuts++;
+    l->cut_at = 0;
+    if (!mute_cuts) {
+        link_close(i, "COUPEE", now);
+        return 0;
+    }
+    journal_event(l, "MUETTE", now);
+    l->mute = 1;
+    dir_drop(&l->d[UP]);
+    dir_drop(&l->d[DOWN]);
+    return 1;
+}
+
+static void set_nodelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Nouveau client: connexion au serveur et profil suivant.
+static void link_open(int cfd, const char *host, const char *port, double now) {
+    int sfd = tcp_connect(host, port);
+    if (sfd < 0) {
+        printf("relais: serveur %s:%s injoignable (errno=%d)\n", host, port, errno);
+        fflush(stdout);
+        close(cfd);
+        return;
+    }
+    if (nlinks == links_cap) {
+        int cap = links_cap ? links_cap * 2 : 64;
+        Link **v = realloc(links, (size_t)cap * sizeof(*v));
+        if (!v) die("realloc");
+        links = v;
+        links_cap = cap;
+    }
+    Link *l = calloc(1, sizeof(*l));
+    if (!l) die("calloc");
+    set_nodelay(cfd);              // Pas d'attente de Nagle propre au relais
+    set_nodelay(sfd);
+    l->id = ++links_total;
+    l->ps = &profiles[(l->id - 1) % nprofiles];
+    l->ps->links++;
+    l->d[UP].from = l->d[DOWN].to = cfd;
+    l->d[DOWN].from = l->d[UP].to = sfd;
+    if (l->ps->p.lifetime_s > 0) l->cut_at = now - log(1 - rng_unit()) * l->ps->p.lifetime_s;
+    links[nlinks++] = l;
+    journal_event(l, "OUVERTE", now);
+}
+
+static void report(double now) {
+    static const char *labels[SAMPLES] = { "reponse", "tour", "trajet" };
+    printf("relais: %ld connexions (%d ouvertes), %.1f s\n", links_total, nlinks, now - t0);
+    for (int p = 0; p < nprofiles; p++) {
+        ProfileStats *ps = &profiles[p];
+        printf("profil %d (%s): %ld connexions, %ld coupures, %ld lignes, %ld pertes\n", p + 1, ps->p.spec,
+               ps->links, ps->cuts, ps->lines, ps->losses);
+        printf("  %-8s %8s %9s %9s %9s %9s %9s  (ms)\n", "", "n", "moyenne", "p50", "p90", "p99", "max");
+        for (int k = 0; k < SAMPLES; k++) {
+            Samples *s = &ps->s[k];
+            if (!s->n) {
+                printf("  %-8s %8d\n", labels[k], 0);
+                continue;
+            }
+            double sum = 0;
+            qsort(s->v, (size_t)s->n, sizeof(double), cmp_double);
+            for (long i = 0; i < s->n; i++) sum += s->v[i];
+            printf("  %-8s %8ld %9.2f %9.2f %9.2f %9.2f %9.2f\n", labels[k], s->n, sum / s->n,
+                   quantile(s->v, s->n, 0.5), quantile(s->v, s->n, 0.9), quantile(s->v, s->n, 0.99),
+                   s->v[s->n - 1]);
+        }
+    }
+    fflush(stdout);
+    if (journal) fflush(journal);
+}
+
+int main(int argc, char **argv) {
+    const char *journal_path = NULL;
+    int duration = 0, seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:mo:d:s:")) != -1) {
+        int ok = 1;
+        switch (opt) {
+        case 'r': ok = nprofiles < PROFILES_MAX && parse_profile(optarg, &profiles[nprofiles].p);
+                  nprofiles += ok;
+                  break;
+        case 'm': mute_cuts = 1; break;
+        case 'o': journal_path = optarg; break;
+        case 'd': ok = parse_int(optarg, &duration) && duration > 0; break;
+        case 's': ok = parse_int(optarg, &seed); break;
+        default: ok = 0;
+        }
+        if (!ok) optind = argc;
+    }
+    if (optind != argc - 3) {
+        fprintf(stderr,
+                "Usage: %s [-r profil]... [-m] [-o journal] [-d secondes] [-s graine] <port_local> <hote> <port>\n"
+                "  profil: latence[/gigue[/debit[/perte[/coupure]]]] (defaut " DEFAULT_PROFILE ")\n"
+                "    latence, gigue: ms par sens; debit: Ko/s par sens (0: illimite)\n"
+                "    perte: probabilite par ligne; coupure: duree de vie moyenne en s (0: jamais)\n"
+                "  -r repete: profils attribues a tour de role aux connexions\n"
+                "  -m: une coupure rend la connexion muette au lieu de la fermer\n",
+                argv[0]);
+        return 1;
+    }
+    if (!nprofiles) parse_profile(DEFAULT_PROFILE, &profiles[nprofiles++].p);
+    rng ^= (uint64_t)(unsigned)seed * 1000003ULL;
+    const char *host = argv[optind + 1], *port = argv[optind + 2];
+
+    if (journal_path && !(journal = fopen(journal_path, "w"))) die("journal");
+    int lfd = tcp_listen(argv[optind]);
+    if (lfd < 0) die("listen");
+
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    sigaddset(&sigs, SIGUSR2);
+    sigprocmask(SIG_BLOCK, &sigs, NULL);
+    int sfd = signalfd(-1, &sigs, SFD_CLOEXEC);
+    if (sfd < 0) die("signalfd");
+
+    t0 = mono_now();
+    double deadline = duration ? t0 + duration : 0;
+    printf("relais: port %s -> %s:%s, %d profil(s)\n", argv[optind], host, port, nprofiles);
+    fflush(stdout);
+
+    struct pollfd *pfds = NULL;
+    int pfds_cap = 0;
+    for (;;) {
+        double now = mono_now();
+        if (deadline && now >= deadline) break;
+
+        // Échéance la plus proche: ligne à remettre, coupure ou fin de -d.
+        double next = deadline;
+        for (int i = 0; i < nlinks; i++) {
+            Link *l = links[i];
+            for (int k = 0; k < 2; k++)
+                if (l->d[k].head && !l->d[k].blocked && (!next || l->d[k].head->due < next))
+                    next = l->d[k].head->due;
+            if (l->cut_at && (!next || l->cut_at < next)) next = l->cut_at;
+        }
+
+        if (2 + 2 * nlinks > pfds_cap) {
+            pfds_cap = 2 * (2 + 2 * nlinks);
+            pfds = realloc(pfds, (size_t)pfds_cap * sizeof(*pfds));
+            if (!pfds) die("realloc");
+        }
+        pfds[0] = (struct pollfd){ .fd = lfd, .events = POLLIN };
+        pfds[1] = (struct pollfd){ .fd = sfd, .events = POLLIN };
+        for (int i = 0; i < nlinks; i++) {
+            Link *l = links[i];
+            for (int k = 0; k < 2; k++) {
+                // Lecture sur d[k].from, écriture bloquée de l'autre sens sur le même socket
+                struct pollfd *p = &pfds[2 + 2 * i + k];
+                p->events = (l->d[k].eof ? 0 : POLLIN) | (l->d[!k].blocked ? POLLOUT : 0);
+                p->fd = p->events ? l->d[k].from : -1;   // Sans événement: pas de POLLHUP en boucle
+                p->revents = 0;
+            }
+        }
+
+        struct timespec ts, *tsp = NULL;
+        if (next) {
+            double wait = next > now ? next - now : 0;
+            ts.tv_sec = (time_t)wait;
+            ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+            tsp = &ts;
+        }
+        int npoll = 2 + 2 * nlinks;
+        if (ppoll(pfds, (nfds_t)npoll, tsp, NULL) < 0 && errno != EINTR) die("poll");
+        now = mono_now();
+
+        if (pfds[1].revents & POLLIN) {
+            struct signalfd_siginfo si;
+            if (read(sfd, &si, sizeof(si)) == (ssize_t)sizeof(si)) {
+                if (si.ssi_signo != SIGUSR2) break;
+                report(now);
+            }
+        }
+
+        // Connexions existantes (indices du tableau de poll), de la dernière à la première:
+        // une fermeture déplace la dernière connexion à la place libérée.
+        for (int i = npoll / 2 - 2; i >= 0; i--) {
+            Link *l = links[i];
+            int alive = 1;
+            for (int k = 0; k < 2 && alive; k++) {
+                short ev = pfds[2 + 2 * i + k].revents;
+                if ((ev & (POLLIN | POLLHUP | POLLERR)) && !l->d[k].eof && !dir_read(l, k, now)) {
+                    l->d[k].eof = 1;
+                    if (l->mute) alive = 0;
+                }
+            }
+            if (alive && l->cut_at && now >= l->cut_at) {
+                if (!link_cut(i, now)) continue;
+            }
+            for (int k = 0; k < 2 && alive; k++)
+                if (!dir_flush(l, k, now)) alive = 0;
+            if (!alive) link_close(i, "FERMEE", now);
+            else if (l->d[UP].shut && l->d[DOWN].shut) link_close(i, "FERMEE", now);
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            int cfd = accept(lfd, NULL, NULL);
+            if (cfd >= 0) link_open(cfd, host, port, now);
+        }
+    }
+
+    report(mono_now());
+    if (journal) fclose(journal);
+    return 0;
+}
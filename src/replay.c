@@ -0,0 +1,429 @@
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/game.h"
+#include "headers/proto.h"
+#include "headers/strategy.h"
+#include "headers/archive.h"
+
+#include <dirent.h>
+#include <math.h>
+#include <sys/stat.h>
+
+/*
+ * Évaluation contrefactuelle sur les parties enregistrées: un siège joue
+ * une stratégie candidate, les autres rejouent leurs coups enregistrés.
+ * La donne de chaque manche est reconstituée à partir du journal: rangées
+ * de départ (TOUR 1 TABLE) et main de chaque joueur (ses dix cartes jouées).
+ * Seules les manches complètes sont rejouées, en entier, pour la partie
+ * enregistrée comme pour la partie modifiée: une dernière manche écourtée
+ * par la fin de partie ou une déconnexion n'a pas de donne connue. Un autre
+ * siège qui doit ramasser prend la rangée enregistrée pour ce tour, à
+ * défaut celle de l'heuristique "risque". Le rejeu des coups enregistrés
+ * doit redonner les scores du journal, sinon la partie est écartée.
+ * Sources: l'archive (-a) et les fichiers logs/partie_N.log (-l), réparties
+ * sur tous les coeurs.
+ * Usage: ./rejeu [-a archive] [-l dossier] [-J pseudo] [-j threads]
+ *                [-p poids] [-Q tables] <strategie>
+ */
+
+#define REPLAY_ROUNDS_MAX 64
+#define HIST_MAX 512                  // Têtes d'un siège au-delà: dernière case
+#define Z95 1.959963984540054
+
+// Partie enregistrée, réduite à ce que le rejeu demande.
+typedef struct {
+    int n;
+    int rounds;                       // Manches complètes
+    Rules rules;
+    char names[MAX_PLAYERS][PLAYER_NAME_MAX];
+    Row start[REPLAY_ROUNDS_MAX][ROWS];
+    uint8_t play[REPLAY_ROUNDS_MAX][HAND_SIZE][MAX_PLAYERS];
+    int8_t take[REPLAY_ROUNDS_MAX][HAND_SIZE][MAX_PLAYERS];    // Rangée ramassée + 1, 0 sinon
+    int scores[REPLAY_ROUNDS_MAX][MAX_PLAYERS];                // Fin de manche, -1: absents
+} Replay;
+
+// Somme et somme des carrés d'une mesure (moyenne et intervalle de confiance).
+typedef struct {
+    double sum, sq;
+} Moments;
+
+// Mesures par siège rejoué: têtes, écart à la moyenne des autres, victoire.
+enum { M_BULLS, M_REL, M_WIN, MEASURES };
+
+// Résultats d'un thread, puis du total: partie enregistrée, rejouée, écart apparié.
+typedef struct {
+    long games, skipped, mismatched, seats;
+    Moments base[MEASURES], cand[MEASURES], diff[MEASURES];
+    long hist_base[HIST_MAX + 1];
+    long hist_cand[HIST_MAX + 1];
+} Totals;
+
+static const Strategy *cand;
+static const char *only_name;          // -J: seuls les sièges de ce pseudo
+static const char *archive_dir = ARCHIVE_DIR;
+static const char *logs_dir = "logs";
+static int narchive;                   // Parties 1..narchive de l'archive
+static char **log_paths;               // Puis les journaux séparés
+static int nlogs;
+static int next_job;
+static Totals totals;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void add(Moments *m, double v) {
+    m->sum += v;
+    m->sq += v * v;
+}
+
+// Numéro de tour valide d'une ligne "TOUR t ...", 0 sinon.
+static int line_turn(const char *line, const Replay *r, const char **rest) {
+    char *end;
+    long t = strtol(line + 5, &end, 10);
+    if (t < 1 || t > r->rules.hand_size || *end != ' ') return 0;
+    *rest = end + 1;
+    return (int)t;
+}
+
+// Lit un journal de partie; 0 s'il n'a aucune manche complète.
+static int replay_parse(const char *data, size_t len, Replay *r) {
+    memset(r, 0, sizeof(*r));
+    memset(r->scores, 0xff, sizeof(r->scores));
+    int cur = -1;
+    int have_rules = 0;
+    size_t pos = 0;
+
+    while (pos < len) {
+        char line[LINE_MAX];
+        size_t end = pos;
+        while (end < len && data[end] != '\n') end++;
+        size_t l = end - pos < sizeof(line) - 1 ? end - pos : sizeof(line) - 1;
+        memcpy(line, data + pos, l);
+        line[l] = 0;
+        pos = end + 1;
+
+        const char *rest;
+        int t, p, v, row;
+        if (str_starts(line, "JOUEURS ")) {
+            char *s = line + 8, *tok, *save;
+            for (tok = strtok_r(s, " ", &save); tok && r->n < MAX_PLAYERS; tok = strtok_r(NULL, " ", &save)) {
+                char *colon = strchr(tok, ':');
+                if (colon) snprintf(r->names[r->n++], PLAYER_NAME_MAX, "%s", colon + 1);
+            }
+        } else if (str_starts(line, "REGLES ")) {
+            char name[32];
+            int deck, row_max, hand, end_score;
+            have_rules = sscanf(line, "REGLES %31s %d %d %d %d", name, &deck, &row_max, &hand, &end_score) == 5 &&
+                         rules_lookup(name, &r->rules) && row_max >= 1 && row_max <= ROW_MAX &&
+                         hand >= 1 && hand <= HAND_SIZE;
+            if (have_rules) {
+                r->rules.row_max = row_max;
+                r->rules.hand_size = hand;
+                r->rules.end_score = end_score;
+            }
+        } else if (!have_rules || !str_starts(line, "TOUR ") || !(t = line_turn(line, r, &rest))) {
+            continue;
+        } else if (str_starts(rest, "TABLE ")) {
+            if (t == 1) {
+                if (cur + 1 >= REPLAY_ROUNDS_MAX) break;
+                parse_table_rows(rest + 6, r->start[++cur]);
+            }
+        } else if (cur < 0) {
+            continue;
+        } else if (sscanf(rest, "PLAY %d %*s %d", &p, &v) == 2) {
+            if (p >= 1 && p <= r->n && v >= 1 && v < DECK_MAX) r->play[cur][t - 1][p - 1] = (uint8_t)v;
+        } else if (sscanf(rest, "TAKE %d %*s ROW %d", &p, &row) == 2) {
+            if (p >= 1 && p <= r->n && row >= 1 && row <= ROWS) r->take[cur][t - 1][p - 1] = (int8_t)row;
+        } else if (str_starts(rest, "SCORES ") && t == r->rules.hand_size) {
+            const char *s = rest + 7;
+            while ((s = strchr(s, 'J')) && sscanf(s, "J%d=%d", &p, &v) == 2) {
+                if (p >= 1 && p <= r->n) r->scores[cur][p - 1] = v;
+                s++;
+            }
+        }
+    }
+
+    // Manches complètes en tête: rangées de départ et toutes les cartes jouées
+    for (r->rounds = 0; r->rounds <= cur; r->rounds++) {
+        int ok = 1;
+        for (int i = 0; ok && i < ROWS; i++) ok = r->start[r->rounds][i].len == 1;
+        for (int i = 0; ok && i < r->rules.hand_size; i++)
+            for (int q = 0; ok && q < r->n; q++) ok = r->play[r->rounds][i][q] != 0;
+        if (!ok) break;
+    }
+    return have_rules && r->n >= MIN_PLAYERS && r->rounds > 0;
+}
+
+// Rejoue les manches complètes; le siège seat (-1: aucun) suit la stratégie
+// candidate. Sans siège remplacé, 0 si les scores diffèrent du journal.
+static int replay_run(const Replay *r, int seat, int scores[MAX_PLAYERS]) {
+    int n = r->n, hs = r->rules.hand_size;
+    Game g;
+    game_init_rules(&g, n, &r->rules);
+
+    for (int m = 0; m < r->rounds; m++) {
+        memcpy(g.rows, r->start[m], sizeof(g.rows));
+        for (int p = 0; p < n; p++) {
+            for (int i = 0; i < hs; i++) g.hands[p][i] = r->play[m][i][p];
+            g.hand_len[p] = hs;
+        }
+
+        for (int t = 0; t < hs; t++) {
+            for (int p = 0; p < n; p++) {
+                int c = p == seat ? cand->choose_card(g.hands[p], g.hand_len[p], g.rows, r->rules.row_max)
+                                  : r->play[m][t][p];
+                if (!game_hand_remove(&g, p, c)) return 0;
+                g.carte_jouee[p] = c;
+            }
+
+            int order[MAX_PLAYERS];
+            for (int i = 0; i < n; i++) order[i] = i;
+            for (int i = 1; i < n; i++)
+                for (int j = i; j > 0 && g.carte_jouee[order[j]] < g.carte_jouee[order[j - 1]]; j--) {
+                    int tmp = order[j];
+                    order[j] = order[j - 1];
+                    order[j - 1] = tmp;
+                }
+
+            for (int k = 0; k < n; k++) {
+                int pid = order[k];
+                int c = g.carte_jouee[pid];
+                int chosen = -1, taken, b;
+                if (card_takes_row(g.rows, c)) {
+                    if (pid == seat) chosen = cand->choose_row(g.rows);
+                    else if (r->take[m][t][pid]) chosen = r->take[m][t][pid] - 1;
+                    else chosen = choose_row_fallback(g.rows);
+                }
+                game_place_card(&g, pid, c, chosen, &taken, &b);
+            }
+        }
+
+        if (seat < 0 && r->scores[m][0] >= 0)
+            for (int p = 0; p < n; p++)
+                if (g.scores[p] != r->scores[m][p]) return 0;
+    }
+    memcpy(scores, g.scores, sizeof(int) * (size_t)n);
+    return 1;
+}
+
+// Écart d'un siège à la moyenne des autres, et victoire (aucun autre plus bas).
+static double seat_rel(const int *scores, int n, int seat, int *win) {
+    double others = 0;
+    *win = 1;
+    for (int p = 0; p < n; p++) {
+        if (p == seat) continue;
+        others += scores[p];
+        if (scores[p] < scores[seat]) *win = 0;
+    }
+    return scores[seat] - others / (n - 1);
+}
+
+// Rejoue une partie pour chacun des sièges retenus.
+static void replay_game(const char *data, size_t len, Replay *r, Totals *t) {
+    int base[MAX_PLAYERS], alt[MAX_PLAYERS];
+    if (!replay_parse(data, len, r)) {
+        t->skipped++;
+        return;
+    }
+    if (!replay_run(r, -1, base)) {
+        t->mismatched++;
+        return;
+    }
+    t->games++;
+
+    for (int s = 0; s < r->n; s++) {
+        if (only_name && strcmp(r->names[s], only_name) != 0) continue;
+        if (!replay_run(r, s, alt)) continue;
+        int wb, wc;
+        double vb[MEASURES], vc[MEASURES];
+        vb[M_REL] = seat_rel(base, r->n, s, &wb);
+        vc[M_REL] = seat_rel(alt, r->n, s, &wc);
+        vb[M_BULLS] = base[s];
+        vc[M_BULLS] = alt[s];
+        vb[M_WIN] = wb;
+        vc[M_WIN] = wc;
+        t->seats++;
+        for (int k = 0; k < MEASURES; k++) {
+            add(&t->base[k], vb[k]);
+            add(&t->cand[k], vc[k]);
+            add(&t->diff[k], vc[k] - vb[k]);
+        }
+        t->hist_base[base[s] < HIST_MAX ? base[s] : HIST_MAX]++;
+        t->hist_cand[alt[s] < HIST_MAX ? alt[s] : HIST_MAX]++;
+    }
+}
+
+// Lit un fichier entier (journal séparé); NULL si illisible.
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    struct stat st;
+    char *buf = fstat(fileno(f), &st) == 0 ? malloc((size_t)st.st_size + 1) : NULL;
+    if (buf) *len = fread(buf, 1, (size_t)st.st_size, f);
+    fclose(f);
+    return buf;
+}
+
+// Thread de rejeu: parties de l'archive (lecteur propre au thread), puis journaux.
+static void *replay_thread(void *arg) {
+    (void)arg;
+    Replay *r = malloc(sizeof(*r));
+    Totals *t = calloc(1, sizeof(*t));
+    ArchiveReader *ar = narchive ? archive_reader_open(archive_dir) : NULL;
+    if (!r || !t) die("malloc");
+
+    for (;;) {
+        pthread_mutex_lock(&job_lock);
+        int job = next_job++;
+        pthread_mutex_unlock(&job_lock);
+        if (job >= narchive + nlogs) break;
+
+        size_t len;
+        if (job < narchive) {
+            const char *data = ar ? archive_read(ar, job + 1, &len) : NULL;
+            if (data) replay_game(data, len, r, t);
+        } else {
+            char *data = read_file(log_paths[job - narchive], &len);
+            if (data) replay_game(data, len, r, t);
+            free(data);
+        }
+    }
+
+    pthread_mutex_lock(&job_lock);
+    totals.games += t->games;
+    totals.skipped += t->skipped;
+    totals.mismatched += t->mismatched;
+    totals.seats += t->seats;
+    for (int k = 0; k < MEASURES; k++) {
+        totals.base[k].sum += t->base[k].sum;
+        totals.base[k].sq += t->base[k].sq;
+        totals.cand[k].sum += t->cand[k].sum;
+        totals.cand[k].sq += t->cand[k].sq;
+        totals.diff[k].sum += t->diff[k].sum;
+        totals.diff[k].sq += t->diff[k].sq;
+    }
+    for (int i = 0; i <= HIST_MAX; i++) {
+        totals.hist_base[i] += t->hist_base[i];
+        totals.hist_cand[i] += t->hist_cand[i];
+    }
+    pthread_mutex_unlock(&job_lock);
+
+    archive_reader_close(ar);
+    free(r);
+    free(t);
+    return NULL;
+}
+
+// Journaux séparés logs/partie_N.log.
+static void list_logs(void) {
+    DIR *d = opendir(logs_dir);
+    if (!d) return;
+    struct dirent *e;
+    int cap = 0;
+    while ((e = readdir(d))) {
+        int id;
+        char tail[8];
+        if (sscanf(e->d_name, "partie_%d.%7s", &id, tail) != 2 || strcmp(tail, "log") != 0) continue;
+        if (nlogs == cap) {
+            cap = cap ? cap * 2 : 256;
+            log_paths = realloc(log_paths, sizeof(char *) * (size_t)cap);
+            if (!log_paths) die("realloc");
+        }
+        size_t l = strlen(logs_dir) + strlen(e->d_name) + 2;
+        if (!(log_paths[nlogs] = malloc(l))) die("malloc");
+        snprintf(log_paths[nlogs++], l, "%s/%s", logs_dir, e->d_name);
+    }
+    closedir(d);
+}
+
+// Ligne "moyenne enregistree, moyenne rejouee, ecart [IC 95%]" (écart apparié).
+static void print_row(const char *label, const Moments *b, const Moments *c, const Moments *d, long n, double k) {
+    double mb = b->sum / n, mc = c->sum / n, md = d->sum / n;
+    double var = n > 1 ? (d->sq - n * md * md) / (n - 1) : 0;
+    double h = Z95 * sqrt(var > 0 ? var / n : 0);
+    printf("  %-20s %10.3f %10.3f %+10.3f  [%+.3f, %+.3f]\n", label, mb * k, mc * k, md * k, (md - h) * k, (md + h) * k);
+}
+
+// Quantile q d'un histogramme de n valeurs.
+static int hist_quantile(const long *h, long n, double q) {
+    long target = (long)ceil(q * n), acc = 0;
+    if (target < 1) target = 1;
+    for (int i = 0; i <= HIST_MAX; i++)
+        if ((acc += h[i]) >= target) return i;
+    return HIST_MAX;
+}
+
+int main(int argc, char **argv) {
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *tables = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:l:J:j:p:Q:")) != -1) {
+        int ok = 1;
+        switch (opt) {
+        case 'a': archive_dir = optarg; break;
+        case 'l': logs_dir = optarg; break;
+        case 'J': only_name = optarg; break;
+        case 'j': ok = parse_int(optarg, &nthreads) && nthreads > 0; break;
+        case 'p': ok = strategy_params_load(optarg, &strategy_params); break;
+        case 'Q': tables = optarg; break;
+        default: ok = 0;
+        }
+        if (!ok) optind = argc;
+    }
+    if (optind != argc - 1 || !(cand = strategy_lookup(argv[optind]))) {
+        fprintf(stderr,
+                "Usage: %s [-a archive] [-l dossier] [-J pseudo] [-j threads] [-p poids] [-Q tables] <strategie>\n"
+                "  strategies: petite, risque, table (avec -Q ou SIXQP_TABLES)\n",
+                argv[0]);
+        return 1;
+    }
+    if (tables && !(strategy_tables = policy_open(tables))) {
+        fprintf(stderr, "Fichier de tables invalide: %s\n", tables);
+        return 1;
+    }
+    if (!tables && !strategy_tables_from_env()) die("tables de strategie");
+
+    ArchiveReader *ar = archive_reader_open(archive_dir);
+    if (ar) {
+        narchive = archive_reader_count(ar);
+        archive_reader_close(ar);
+    }
+    list_logs();
+    if (!narchive && !nlogs) {
+        fprintf(stderr, "Aucune partie: ni archive %s ni %s/partie_N.log\n", archive_dir, logs_dir);
+        return 1;
+    }
+
+    double t0 = mono_now();
+    pthread_t tids[256];
+    int started = 0;
+    for (int i = 0; i < nthreads && i < 256; i++)
+        if (pthread_create(&tids[started], NULL, replay_thread, NULL) == 0) started++;
+    if (!started) replay_thread(NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+    printf("rejeu: strategie %s sur %s, %ld parties rejouees (%ld sans manche complete, "
+           "%ld ecartees: rejeu different du journal), %d threads, %.1f s\n",
+           cand->name, only_name ? only_name : "chaque siege", totals.games, totals.skipped,
+           totals.mismatched, started ? started : 1, mono_now() - t0);
+    long n = totals.seats;
+    if (!n) {
+        printf("Aucun siege rejoue\n");
+        return 2;
+    }
+
+    printf("%ld sieges rejoues\n  %-20s %10s %10s %10s  %s\n", n, "", "enregistre", "rejoue", "ecart",
+           "IC 95% (apparie)");
+    static const char *labels[MEASURES] = { "tetes du siege", "ecart aux autres", "victoires (%)" };
+    for (int k = 0; k < MEASURES; k++)
+        print_row(labels[k], &totals.base[k], &totals.cand[k], &totals.diff[k], n, k == M_WIN ? 100 : 1);
+
+    static const double qs[] = { 0.1, 0.25, 0.5, 0.75, 0.9 };
+    printf("  %-20s   p10  p25  p50  p75  p90\n", "tetes (quantiles)");
+    for (int k = 0; k < 2; k++) {
+        const long *h = k ? totals.hist_cand : totals.hist_base;
+        printf("  %-20s ", k ? "rejoue" : "enregistre");
+        for (int i = 0; i < 5; i++) printf(" %4d", hist_quantile(h, n, qs[i]));
+        printf("\n");
+    }
+    return 0;
+}
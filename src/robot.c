@@ -1,147 +1,212 @@
 #include "headers/common.h"
 #include "headers/net.h"
+#include "headers/transport.h"
 #include "headers/util.h"
 #include "headers/game.h"
+#include "headers/proto.h"
+#include "headers/strategy.h"
+#include "headers/mux.h"
 
-// Extrait les valeurs entières de la main envoyée par le serveur.
-static int parse_hand(const char *line, int *cards, int cap) {
-    int n = 0;
-    const char *p = line;
-
-    while (*p && *p != ' ') p++;
-    while (*p == ' ') p++;
-
-    while (*p && n < cap) {
-        int v = atoi(p);
-        if (v > 0) cards[n++] = v;
-        while (*p && *p != ' ') p++;
-        while (*p == ' ') p++;
+// Retire une carte déjà jouée tout en compactant la main locale.
+static void remove_from_hand(int *hand, int *hn, int c) {
+    for (int i = 0; i < *hn; i++) {
+        if (hand[i] == c) {
+            for (int j = i + 1; j < *hn; j++)
+                hand[j - 1] = hand[j];
+            (*hn)--;
+            return;
+        }
     }
-    return n;
 }
 
-// Reconstruit les quatre rangées décrites dans la ligne R1:/R2:.
-static void parse_table_rows(const char *line, Row rows[ROWS]) {
-    for (int r = 0; r < ROWS; r++) rows[r].len = 0;
-
-    const char *p = line;
-    for (int r = 0; r < ROWS; r++) {
-        while (*p && *p != ':') p++;
-        if (!*p) break;
-        p++;
-        while (*p == ' ') p++;
+// Stratégie du robot: plus petite carte, heuristique "risque" avec les
+// poids de SIXQP_PARAMS (fichier écrit par ./reglage), ou stratégie "table"
+// avec les tables de SIXQP_TABLES (écrites par ./tables).
+static const Strategy *strat;
+
+// État d'un siège, tenu localement en mode delta. Une session multiplexée
+// en tient un par place occupée (gid.player), une connexion simple un seul
+// (gid 0, player annoncé par SIEGE). La main perd une carte à la POSE ou au
+// RAMASSE du siège: un coup joué par le serveur à notre place (limite de
+// débit) la garde juste.
+typedef struct {
+    int gid;
+    int player;            // 0: numéro inconnu, carte retirée dès l'envoi
+    int sent;              // Dernière carte envoyée
+    int hand[HAND_SIZE];
+    int hn;
+    Row rows[ROWS];
+    int row_max;           // Longueur de rangée annoncée par le serveur (REGLES)
+} Seat;
 
-        while (*p && *p != '|') {
-            int v = atoi(p);
-            if (v > 0 && rows[r].len < ROW_MAX)
-                rows[r].cards[rows[r].len++] = v;
+static FILE *out;
 
-            while (*p && *p != ' ' && *p != '|') p++;
-            while (*p == ' ') p++;
-        }
-        while (*p && *p != 'R')
-            p++;
+// Envoie une réponse du siège, préfixée de sa partie en session multiplexée.
+static void seat_send(const Seat *st, const char *cmd) {
+    if (!st->gid) {
+        send_line(out, cmd);
+        return;
     }
+    char line[LINE_MAX];
+    snprintf(line, sizeof(line), "@%d.%d %s", st->gid, st->player, cmd);
+    send_line(out, line);
 }
 
-// Additionne les têtes de bœuf présentes dans une rangée.
-static int row_bulls_local(Row *r) {
-    int s = 0;
-    for (int i = 0; i < r->len; i++)
-        s += bulls(r->cards[i]);
-    return s;
+// Joue la carte de la stratégie et annonce d'avance la rangée à prendre si
+// besoin. Main vide: rien à envoyer, le serveur jouera à notre place.
+static void play_card(Seat *st) {
+    if (st->hn <= 0) return;
+    int c = strat->choose_card(st->hand, st->hn, st->rows, st->row_max);
+    if (c <= 0) return;
+    char cmd[32];
+    if (card_takes_row(st->rows, c))
+        snprintf(cmd, sizeof(cmd), "JOUER %d %d", c, strat->choose_row(st->rows) + 1);
+    else
+        snprintf(cmd, sizeof(cmd), "JOUER %d", c);
+    seat_send(st, cmd);
+    st->sent = c;
+    if (!st->player) remove_from_hand(st->hand, &st->hn, c);
 }
 
-// Choisit la rangée la moins pénalisante lorsqu'on doit ramasser.
-static int choose_row_min_bulls(Row rows[ROWS]) {
-    int best = 0;
-    int bestv = row_bulls_local(&rows[0]);
-    for (int r = 1; r < ROWS; r++) {
-        int v = row_bulls_local(&rows[r]);
-        if (v < bestv) {
-            bestv = v;
-            best = r;
-        }
-    }
-    return best;
+// Carte posée par un joueur: retirée de la main si c'est la nôtre.
+static void seat_event(Seat *st, const char *line) {
+    int player, card, a, b;
+    if (sscanf(line, "POSE %d %d %d", &player, &card, &a) == 3 ||
+        sscanf(line, "RAMASSE %d %d %d %d", &player, &a, &b, &card) == 4)
+        if (player == st->player) remove_from_hand(st->hand, &st->hn, card);
 }
 
-// Renvoie la plus petite carte encore disponible dans la main.
-static int choose_smallest_card(int *hand, int hn) {
-    if (hn <= 0) return -1;
-    int m = hand[0];
-    for (int i = 1; i < hn; i++)
-        if (hand[i] < m)
-            m = hand[i];
-    return m;
+// Traite une ligne adressée au siège.
+static void seat_line(Seat *st, const char *line) {
+    if (strcmp(line, "PING") == 0) {
+        seat_send(st, "PONG");
+    } else if (str_starts(line, "R1:")) {
+        parse_table_rows(line, st->rows);
+    } else if (str_starts(line, "MAIN ")) {
+        st->hn = parse_hand(line, st->hand, HAND_SIZE);
+        play_card(st);
+    } else if (str_starts(line, "TOUR ")) {
+        play_card(st);
+    } else if (str_starts(line, "POSE ") || str_starts(line, "RAMASSE ")) {
+        apply_table_event(line, st->rows);
+        if (st->player) seat_event(st, line);
+    } else if (str_starts(line, "SIEGE ")) {
+        int player;
+        if (sscanf(line, "SIEGE %d", &player) == 1 && player > 0) st->player = player;
+    } else if (str_starts(line, "ERREUR Carte")) {
+        // Carte que le serveur ne nous connaît pas: la main locale la perd aussi
+        remove_from_hand(st->hand, &st->hn, st->sent);
+    } else if (str_starts(line, "REGLES ")) {
+        int deck, row_max;
+        if (sscanf(line, "REGLES %*s %d %d", &deck, &row_max) == 2 &&
+            row_max >= 1 && row_max <= ROW_MAX)
+            st->row_max = row_max;
+    } else if (strcmp(line, "DEMANDE_CARTE") == 0) {
+        // Invite explicite: seulement après un ERREUR en mode pipeline.
+        play_card(st);
+    } else if (strcmp(line, "CHOISIR_RANGEES") == 0) {
+        char cmd[16];
+        snprintf(cmd, sizeof(cmd), "%d", strat->choose_row(st->rows) + 1);
+        seat_send(st, cmd);
+    }
 }
 
-// Retire une carte déjà jouée tout en compactant la main locale.
-static void remove_from_hand(int *hand, int *hn, int c) {
-    for (int i = 0; i < *hn; i++) {
-        if (hand[i] == c) {
-            for (int j = i + 1; j < *hn; j++)
-                hand[j - 1] = hand[j];
-            (*hn)--;
-            return;
-        }
+// Siège d'une place, créé à sa première ligne; NULL si tous sont pris.
+static Seat *seat_find(Seat *seats, int nseats, int gid, int player) {
+    Seat *free_seat = NULL;
+    for (int i = 0; i < nseats; i++) {
+        if (seats[i].gid == gid && seats[i].player == player) return &seats[i];
+        if (!seats[i].gid && !free_seat) free_seat = &seats[i];
     }
+    if (free_seat) {
+        memset(free_seat, 0, sizeof(*free_seat));
+        free_seat->gid = gid;
+        free_seat->player = player;
+        free_seat->row_max = ROW_MAX;
+    }
+    return free_seat;
 }
 
-// Client automatique minimaliste qui suit le protocole texte.
+// Client automatique minimaliste qui suit le protocole texte. Avec un
+// nombre de sièges, une seule connexion (+MUX) joue autant de parties à la fois.
 int main(int argc, char **argv) {
     if (argc < 4) {
-        fprintf(stderr, "Usage: %s <host> <port> <pseudo>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <host|unix:/chemin|shm:/chemin> <port> <pseudo> [sieges]\n", argv[0]);
         return 1;
     }
+    int nseats = 0;
+    if (argc > 4 && (!parse_int(argv[4], &nseats) || nseats < 1 || nseats > MUX_SEATS_MAX)) die("sieges");
+
+    if (!strategy_params_from_env()) die("parametres de strategie");
+    if (!strategy_tables_from_env()) die("tables de strategie");
+    strat = strategy_lookup(strategy_tables ? "table" : getenv(STRATEGY_PARAMS_ENV) ? "risque" : "petite");
+
+    // Adresse: hote port, unix:/chemin - ou shm:/chemin - (serveur lancé avec -U)
+    FILE *in;
+    if (!net_open(argv[1], argv[2], &in, &out)) die("connect");
+
+    // Mode delta: le serveur n'envoie que les cartes posées et rangées ramassées.
+    // Mode pipeline: la carte part dès que la main (ou TOUR n) est connue.
+    // +PING: le serveur vérifie par PING/PONG qu'un client silencieux est encore là.
+    char hello[LINE_MAX];
+    snprintf(hello, sizeof(hello), "%s +DELTA +PIPELINE +PING%s", argv[3], nseats ? " +MUX" : "");
+    send_line(out, hello);
+    if (nseats) {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "JOINDRE %d", nseats);
+        send_line(out, cmd);
+    }
 
-    int fd = tcp_connect(argv[1], argv[2]);
-    if (fd < 0) die("connect");
-
-    FILE *in = fdopen_r(fd);
-    FILE *out = fdopen_w(fd);
-    if (!in || !out) die("fdopen");
-
-    send_line(out, argv[3]);
-
-    int hand[HAND_SIZE];
-    int hn = 0;
-    Row rows[ROWS];
-    memset(rows, 0, sizeof(rows));
+    Seat single = { .row_max = ROW_MAX };
+    Seat *seats = nseats ? calloc((size_t)nseats, sizeof(Seat)) : NULL;
+    if (nseats && !seats) die("calloc");
+    int finished = 0;
+    int expected = nseats;     // Sièges acceptés par le serveur (ERREUR n sieges sur m)
 
     char line[LINE_MAX];
     while (recv_line(in, line, sizeof(line))) {
-        if (str_starts(line, "R1:")) {
-            parse_table_rows(line, rows);
+        if (!nseats) {
+            // Grappe: le nœud plein ou sans partenaire en indique un autre
+            int redir = net_follow_redirect(line, hello, &in, &out);
+            if (redir < 0) die("redirection");
+            if (redir) continue;
+            seat_line(&single, line);
             continue;
         }
 
-        if (str_starts(line, "MAIN ")) {
-            hn = parse_hand(line, hand, HAND_SIZE);
+        // Session: "@<partie>.<joueur> ligne" pour un siège, sinon ligne de
+        // session. Des sièges refusés ne finiront jamais: on n'attend que les
+        // autres, et une session refusée s'arrête là.
+        if (line[0] != '@') {
+            if (!str_starts(line, "ERREUR")) continue;
+            fprintf(stderr, "%s\n", line);
+            int placed;
+            if (sscanf(line, "ERREUR %d sieges sur", &placed) == 1) expected = placed;
+            else if (!str_starts(line, "ERREUR Commande") && !str_starts(line, "ERREUR Prefixe")) expected = 0;
+            if (finished >= expected) break;
             continue;
         }
-
-        if (strcmp(line, "DEMANDE_CARTE") == 0) {
-            int c = choose_smallest_card(hand, hn);
-            if (c < 0) c = 0;
-            char cmd[32];
-            snprintf(cmd, sizeof(cmd), "JOUER %d", c);
-            send_line(out, cmd);
-            remove_from_hand(hand, &hn, c);
-            continue;
-        }
-
-        if (strcmp(line, "CHOISIR_RANGEES") == 0) {
-            int r = choose_row_min_bulls(rows) + 1;
-            char cmd[16];
-            snprintf(cmd, sizeof(cmd), "%d", r);
-            send_line(out, cmd);
+        char *rest;
+        int gid = (int)strtol(line + 1, &rest, 10);
+        int player = *rest == '.' ? (int)strtol(rest + 1, &rest, 10) : 0;
+        if (gid <= 0 || player <= 0) continue;
+        if (*rest == ' ') rest++;
+        Seat *st = seat_find(seats, nseats, gid, player);
+        if (!st) continue;
+        if (strcmp(rest, "FIN") == 0) {
+            st->gid = 0;
+            if (++finished >= expected) break;
             continue;
         }
+        seat_line(st, rest);
     }
 
+    // Connexion fermée par le serveur avant la fin de toutes les parties
+    int lost = nseats && finished < expected;
+    if (lost) fprintf(stderr, "Session fermee: %d parties finies sur %d\n", finished, expected);
+
+    free(seats);
     fclose(in);
     fclose(out);
-    close(fd);
-    return 0;
+    return lost;
 }
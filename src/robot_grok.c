@@ -1,28 +1,59 @@
 #include "headers/common.h"
 #include "headers/net.h"
+#include "headers/transport.h"
 #include "headers/util.h"
 #include "headers/game.h"
+#include "headers/proto.h"
+#include "headers/strategy.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+
+#define GROK_DELAI_MS 2000           // Attente maximale de la réponse de Grok
+
+// Requête Grok lancée dès que la table et la main du tour sont connues (MAIN,
+// TOUR), dans un thread: elle tourne pendant que le robot lit la suite, et
+// la carte n'est prise qu'à l'invite DEMANDE_CARTE.
+// Un lancement plus récent rend le résultat d'un thread encore en cours
+// caduc (gen); une réponse arrivée après l'échéance est simplement perdue.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    unsigned gen;
+    int armed;                       // Requête lancée, résultat pas encore pris
+    int ready;
+    int card;                        // -1: pas de réponse exploitable
+    struct timespec deadline;        // CLOCK_MONOTONIC
+} Prefetch;
+
+typedef struct {
+    unsigned gen;
+    int hand[HAND_SIZE];
+    int hn;
+    Row rows[ROWS];
+    unsigned char vues[DECK_MAX + 1];
+} PrefetchJob;
 
-// Analyse la ligne MAIN envoyée par le serveur pour reconstruire la main locale.
-static int parse_hand(const char *line, int *cards, int cap) {
-    int n = 0;
-    const char *p = line;
+static Prefetch pf = { .lock = PTHREAD_MUTEX_INITIALIZER };
+static const char *apikey;
+static int delai_ms = GROK_DELAI_MS;
 
-    while (*p && *p != ' ') p++;
-    while (*p == ' ') p++;
+// Longueur de rangée annoncée par le serveur (ligne REGLES).
+static int regle_row_max = ROW_MAX;
 
-    while (*p && n < cap) {
-        int v = atoi(p);
-        if (v > 0) cards[n++] = v;
-        while (*p && *p != ' ') p++;
-        while (*p == ' ') p++;
-    }
-    return n;
+// Cartes déjà vues sur la table pendant la manche en cours.
+static unsigned char vues[DECK_MAX + 1];
+
+// Marque comme vues toutes les cartes présentes sur la table.
+static void mark_rows_seen(Row rows[ROWS]) {
+    for (int r = 0; r < ROWS; r++)
+        for (int i = 0; i < rows[r].len; i++)
+            if (rows[r].cards[i] > 0 && rows[r].cards[i] <= DECK_MAX)
+                vues[rows[r].cards[i]] = 1;
 }
 
 // Garde des rangées valides même si la ligne reçue est vide ou partielle.
@@ -35,102 +66,31 @@ static void ensure_rows_safe(Row rows[ROWS]) {
     }
 }
 
-// Découpe la description textuelle R1:/R2:/R3:/R4: afin d'alimenter les heuristiques.
-static void parse_table_rows(const char *line, Row rows[ROWS]) {
-    for (int r = 0; r < ROWS; r++) rows[r].len = 0;
-
-    const char *p = line;
-    for (int r = 0; r < ROWS; r++) {
-        while (*p && *p != ':') p++;
-        if (!*p) break;
-        p++;
-        while (*p == ' ') p++;
-
-        while (*p && *p != '|') {
-            int v = atoi(p);
-            if (v > 0 && rows[r].len < ROW_MAX)
-                rows[r].cards[rows[r].len++] = v;
-
-            while (*p && *p != ' ' && *p != '|') p++;
-            while (*p == ' ') p++;
-        }
-        while (*p && *p != 'R') p++;
-    }
-
-    ensure_rows_safe(rows);
-}
-
-// Calcule les têtes de boeuf d'une rangée pour comparer les risques.
-static int row_bulls_local(Row *r) {
-    int s = 0;
-    for (int i = 0; i < r->len; i++) s += bulls(r->cards[i]);
-    return s;
-}
-
-// Sélectionne la rangée la moins coûteuse lorsqu'on doit ramasser.
-static int choose_row_min_bulls(Row rows[ROWS]) {
+// Sélectionne la rangée la moins coûteuse lorsqu'on doit ramasser
+// (tables de SIXQP_TABLES si chargées, sinon heuristique "risque").
+static int choose_row_safe(Row rows[ROWS]) {
     ensure_rows_safe(rows);
-    int best = 0;
-    int bestv = row_bulls_local(&rows[0]);
-    for (int r = 1; r < ROWS; r++) {
-        int v = row_bulls_local(&rows[r]);
-        if (v < bestv) { bestv = v; best = r; }
-    }
-    return best;
-}
-
-// Cherche la rangée compatible la plus proche pour une carte donnée.
-static int best_row_for_card(Row rows[ROWS], int c) {
-    ensure_rows_safe(rows);
-
-    int best = -1;
-    int bestdiff = 0x7fffffff;
-
-    for (int r = 0; r < ROWS; r++) {
-        if (rows[r].len <= 0) continue;
-        int last = rows[r].cards[rows[r].len - 1];
-        if (c > last) {
-            int d = c - last;
-            if (d < bestdiff) { bestdiff = d; best = r; }
-        }
-    }
-    return best;
-}
-
-// Applique une heuristique déterministe si Grok ne répond pas.
-static int choose_card_fallback(int *hand, int hn, Row rows[ROWS]) {
-    ensure_rows_safe(rows);
-    if (hn <= 0) return 1;
-
-    int bestc = hand[0];
-    int bestrisk = 0x7fffffff;
-
-    for (int i = 0; i < hn; i++) {
-        int c = hand[i];
-        int r = best_row_for_card(rows, c);
-        int risk = 0;
-
-        if (r < 0) risk = 10000 + bulls(c);
-        else {
-            int len = rows[r].len;
-            if (len == ROW_MAX) risk = 5000 + row_bulls_local(&rows[r]);
-            else risk = (c - rows[r].cards[len - 1]) + (len * 10);
-        }
-
-        if (risk < bestrisk) { bestrisk = risk; bestc = c; }
-    }
-    return bestc;
+    return choose_row_table(rows);
 }
 
 // Prépare le prompt et interroge l'API Grok pour obtenir un numéro de carte.
-static int grok_pick_card(const char *apikey, int *hand, int hn, Row rows[ROWS]) {
+static int grok_pick_card(int *hand, int hn, Row rows[ROWS], const unsigned char *vues) {
     ensure_rows_safe(rows);
     if (hn <= 0) return -1;
 
     char handbuf[512];
     char tablebuf[512];
+    char vuesbuf[512];
     handbuf[0] = 0;
     tablebuf[0] = 0;
+    vuesbuf[0] = 0;
+
+    for (int c = 1; c <= DECK_MAX; c++) {
+        if (!vues[c]) continue;
+        char t[16];
+        snprintf(t, sizeof(t), vuesbuf[0] ? " %d" : "%d", c);
+        strncat(vuesbuf, t, sizeof(vuesbuf) - (int)strlen(vuesbuf) - 1);
+    }
 
     for (int i = 0; i < hn; i++) {
         char t[16];
@@ -153,17 +113,18 @@ static int grok_pick_card(const char *apikey, int *hand, int hn, Row rows[ROWS])
     char prompt[1024];
     snprintf(prompt, sizeof(prompt),
         "Tu joues a 6 qui prend. Reponds UNIQUEMENT par un entier present dans la main.\n"
-        "Main: %.400s\nTable: %.400s\n",
-        handbuf, tablebuf);
+        "Main: %.200s\nTable: %.200s\nDeja jouees: %.300s\n",
+        handbuf, tablebuf, vuesbuf);
 
+    // Borne la durée de vie d'un thread dont le résultat n'est plus attendu
     char cmd[2048];
     snprintf(cmd, sizeof(cmd),
-        "curl -s https://api.x.ai/v1/chat/completions "
+        "curl -s -m %d https://api.x.ai/v1/chat/completions "
         "-H 'Content-Type: application/json' "
         "-H 'Authorization: Bearer %s' "
         "-d '{\"model\":\"grok\",\"messages\":[{\"role\":\"user\",\"content\":\"%s\"}],"
         "\"temperature\":0.2,\"max_tokens\":5}'",
-        apikey, prompt);
+        delai_ms / 1000 + 2, apikey, prompt);
 
     FILE *fp = popen(cmd, "r");
     if (!fp) return -1;
@@ -193,6 +154,76 @@ static int grok_pick_card(const char *apikey, int *hand, int hn, Row rows[ROWS])
     return -1;
 }
 
+// Thread de requête: publie la carte si aucun lancement plus récent n'a eu lieu.
+static void *prefetch_run(void *arg) {
+    PrefetchJob *job = arg;
+    int c = grok_pick_card(job->hand, job->hn, job->rows, job->vues);
+
+    pthread_mutex_lock(&pf.lock);
+    if (job->gen == pf.gen) {
+        pf.card = c;
+        pf.ready = 1;
+        pthread_cond_signal(&pf.done);
+    }
+    pthread_mutex_unlock(&pf.lock);
+    free(job);
+    return NULL;
+}
+
+// Lance la requête sur une copie de la main, de la table et des cartes vues.
+static void prefetch_start(const int *hand, int hn, Row rows[ROWS]) {
+    if (hn <= 0) return;
+    PrefetchJob *job = malloc(sizeof(*job));
+    if (!job) return;
+    memcpy(job->hand, hand, (size_t)hn * sizeof(int));
+    job->hn = hn;
+    memcpy(job->rows, rows, sizeof(job->rows));
+    ensure_rows_safe(job->rows);
+    memcpy(job->vues, vues, sizeof(job->vues));
+
+    pthread_mutex_lock(&pf.lock);
+    job->gen = ++pf.gen;
+    pf.armed = 1;
+    pf.ready = 0;
+    pf.card = -1;
+    clock_gettime(CLOCK_MONOTONIC, &pf.deadline);
+    pf.deadline.tv_sec += delai_ms / 1000;
+    pf.deadline.tv_nsec += (long)(delai_ms % 1000) * 1000000L;
+    if (pf.deadline.tv_nsec >= 1000000000L) {
+        pf.deadline.tv_sec++;
+        pf.deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_unlock(&pf.lock);
+
+    pthread_t t;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&t, &attr, prefetch_run, job) != 0) {
+        pthread_mutex_lock(&pf.lock);
+        pf.ready = 1;              // Pas de thread: l'heuristique jouera
+        pthread_mutex_unlock(&pf.lock);
+        free(job);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Carte proposée par Grok, attendue au plus jusqu'à l'échéance; -1 sinon,
+// tout de suite si aucune requête n'est en cours (invite après un refus).
+static int prefetch_take(const int *hand, int hn) {
+    pthread_mutex_lock(&pf.lock);
+    while (pf.armed && !pf.ready)
+        if (pthread_cond_timedwait(&pf.done, &pf.lock, &pf.deadline) == ETIMEDOUT) break;
+    int c = pf.armed && pf.ready ? pf.card : -1;
+    pf.armed = 0;
+    pf.gen++;                      // Une réponse tardive ne servira pas au tour suivant
+    pthread_mutex_unlock(&pf.lock);
+
+    for (int i = 0; i < hn; i++)
+        if (hand[i] == c) return c;
+    return -1;
+}
+
 // Supprime une carte jouée tout en conservant l'ordre local.
 static void remove_from_hand(int *hand, int *hn, int c) {
     for (int i = 0; i < *hn; i++) {
@@ -205,23 +236,52 @@ static void remove_from_hand(int *hand, int *hn, int c) {
     }
 }
 
+// Choisit une carte (Grok si sa réponse arrive avant l'échéance, sinon
+// l'heuristique) et annonce la rangée à prendre si elle en impose une: pas
+// d'invite CHOISIR_RANGEES à attendre.
+static void play_card(FILE *out, int *hand, int *hn, Row rows[ROWS]) {
+    int c = -1;
+
+    if (*hn > 0) c = prefetch_take(hand, *hn);
+    if (c < 0 && *hn > 0) c = choose_card_table(hand, *hn, rows, regle_row_max);
+    if (c < 0) c = 1;
+
+    char cmd[32];
+    if (card_takes_row(rows, c))
+        snprintf(cmd, sizeof(cmd), "JOUER %d %d", c, choose_row_safe(rows) + 1);
+    else
+        snprintf(cmd, sizeof(cmd), "JOUER %d", c);
+    send_line(out, cmd);
+    remove_from_hand(hand, hn, c);
+}
+
 // Client automatique qui délègue le choix à Grok si possible.
 int main(int argc, char **argv) {
     if (argc < 5) {
-        fprintf(stderr, "Usage: %s <host> <port> <pseudo> <XAI_API_KEY>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <host|unix:/chemin|shm:/chemin> <port> <pseudo> <XAI_API_KEY> [delai_ms]\n", argv[0]);
         return 1;
     }
 
-    const char *apikey = argv[4];
-
-    int fd = tcp_connect(argv[1], argv[2]);
-    if (fd < 0) die("connect");
-
-    FILE *in = fdopen_r(fd);
-    FILE *out = fdopen_w(fd);
-    if (!in || !out) die("fdopen");
-
-    send_line(out, argv[3]);
+    apikey = argv[4];
+    if (argc > 5 && (!parse_int(argv[5], &delai_ms) || delai_ms < 0)) die("delai_ms");
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&pf.done, &ca);
+    pthread_condattr_destroy(&ca);
+    if (!strategy_params_from_env()) die("parametres de strategie");
+    if (!strategy_tables_from_env()) die("tables de strategie");
+
+    // Adresse: hote port, unix:/chemin - ou shm:/chemin - (serveur lancé avec -U)
+    FILE *in, *out;
+    if (!net_open(argv[1], argv[2], &in, &out)) die("connect");
+
+    // Mode delta: état de la table tenu localement à partir des événements.
+    // Pas de +PIPELINE: la carte attend l'invite, le temps que Grok réponde.
+    char hello[LINE_MAX];
+    snprintf(hello, sizeof(hello), "%s +DELTA +PING", argv[3]);
+    send_line(out, hello);
     fflush(out);
 
     int hand[HAND_SIZE];
@@ -233,33 +293,60 @@ int main(int argc, char **argv) {
 
     char line[LINE_MAX];
     while (recv_line(in, line, sizeof(line))) {
+        // Grappe: le nœud plein ou sans partenaire en indique un autre
+        int redir = net_follow_redirect(line, hello, &in, &out);
+        if (redir < 0) die("redirection");
+        if (redir) continue;
+
+        if (strcmp(line, "PING") == 0) {
+            send_line(out, "PONG");
+            continue;
+        }
 
         if (str_starts(line, "R1:")) {
+            // Resynchronisation complète: nouvelle manche
+            memset(vues, 0, sizeof(vues));
             parse_table_rows(line, rows);
+            ensure_rows_safe(rows);
+            mark_rows_seen(rows);
             continue;
         }
 
+        // Table et main complètes: la requête part, la lecture continue
         if (str_starts(line, "MAIN ")) {
             hn = parse_hand(line, hand, HAND_SIZE);
+            prefetch_start(hand, hn, rows);
             continue;
         }
 
-        if (strcmp(line, "DEMANDE_CARTE") == 0) {
-            int c = -1;
+        if (str_starts(line, "TOUR ")) {
+            prefetch_start(hand, hn, rows);
+            continue;
+        }
 
-            if (hn > 0) c = grok_pick_card(apikey, hand, hn, rows);
-            if (c < 0 && hn > 0) c = choose_card_fallback(hand, hn, rows);
-            if (c < 0) c = 1;
+        if (str_starts(line, "POSE ") || str_starts(line, "RAMASSE ")) {
+            int c = apply_table_event(line, rows);
+            if (c > 0 && c <= DECK_MAX) vues[c] = 1;
+            continue;
+        }
 
-            char cmd[32];
-            snprintf(cmd, sizeof(cmd), "JOUER %d", c);
-            send_line(out, cmd);
-            remove_from_hand(hand, &hn, c);
+        if (str_starts(line, "REGLES ")) {
+            int deck, row_max;
+            if (sscanf(line, "REGLES %*s %d %d", &deck, &row_max) == 2 &&
+                row_max >= 1 && row_max <= ROW_MAX)
+                regle_row_max = row_max;
+            continue;
+        }
+
+        if (strcmp(line, "DEMANDE_CARTE") == 0) {
+            // Réponse de Grok si elle arrive avant l'échéance; après un refus,
+            // la requête est consommée et l'heuristique joue sans attendre.
+            play_card(out, hand, &hn, rows);
             continue;
         }
 
         if (strcmp(line, "CHOISIR_RANGEES") == 0) {
-            int r = choose_row_min_bulls(rows) + 1;
+            int r = choose_row_safe(rows) + 1;
             char cmd[32];
             snprintf(cmd, sizeof(cmd), "%d", r);
             send_line(out, cmd);
@@ -269,6 +356,5 @@ int main(int argc, char **argv) {
 
     fclose(in);
     fclose(out);
-    close(fd);
     return 0;
 }
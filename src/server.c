@@ -1,12 +1,27 @@
-#define _POSIX_C_SOURCE 200112L
+#define _POSIX_C_SOURCE 200809L
 
 #include "headers/common.h"
 #include "headers/net.h"
 #include "headers/util.h"
 #include "headers/game.h"
+#include "headers/proto.h"
+#include "headers/strategy.h"
+#include "headers/trace.h"
+#include "headers/archive.h"
+#include "headers/pool.h"
+#include "headers/transport.h"
+#include "headers/tournament.h"
+#include "headers/shard.h"
+#include "headers/cluster.h"
+#include "headers/ratelimit.h"
+#include "headers/live.h"
+#include "headers/stats.h"
+#include "headers/mux.h"
+#include "headers/uring.h"
 
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <signal.h>
 #include <strings.h>
 #include <ctype.h>
@@ -16,130 +31,471 @@
 #include <arpa/inet.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <errno.h>
 
 static int global_game_id = 0;
 static pthread_mutex_t game_id_lock = PTHREAD_MUTEX_INITIALIZER; // Protège l'accès à global_game_id avec un mutex pour que les threads soient sûrs d'obtenir des IDs uniques.
 
-typedef struct {
-    int fd;
-    FILE *in;
-    FILE *out;
-    char name[PLAYER_NAME_MAX];
-} WaitingPlayer;
+static Archive *archive = NULL;   // NULL: un fichier logs/partie_N.log par partie (-L)
+static StatsStore *stats = NULL;  // Statistiques persistantes des joueurs (-J)
+static int log_archived;          // Journal archivé par morceaux (défaut) ou fichier (-L)
 
-typedef struct {
-    int fd;
-    FILE *in;
-    FILE *out;
+// Siège d'un joueur, de la file d'attente à la fin de partie. Alloué dans
+// seat_pool et transmis par pointeur (file d'attente, puis table).
+typedef struct Player {
+    Conn *conn;            // NULL pour un bot interne
     int connected;
     char name[PLAYER_NAME_MAX];
+    int caps;
+    const Strategy *bot;   // Siège tenu par un bot interne (pas de socket)
     int card;
     int chosen_row;
+    double since;          // Arrivée dans la file d'attente (mono_now)
+    struct Player *next;   // Chaînage de la file d'attente
+    Entrant *entrant;      // Inscrit du tournoi tenu par ce siège, NULL sinon
+    uint32_t addr;         // Adresse IPv4 source (0: connexion locale)
+    Bucket limits[2];      // Seaux RATE_LINES et RATE_INVALID (player_limits_reset)
+    int rate_logged;       // Dépassement déjà journalisé pour cette connexion
 } Player;
 
-typedef struct {
+// Partie lancée, allouée dans table_pool et rendue par son thread.
+typedef struct Table {
     int game_id;
     int nplayers;
-    WaitingPlayer wp[MAX_PLAYERS];
-} GameArgs;
-
-static WaitingPlayer waitq[256];
-static int waitq_count = 0;
+    Rules rules;
+    Player *seats[MAX_PLAYERS];
+    Tournament *tourn;     // Partie de tournoi: résultat classé à la fin
+    struct Table *next;    // File des tables à exécuter (tournoi)
+    LiveGame live;         // Vue publiée pour le socket d'administration (-a)
+} Table;
+
+#define GAME_STACK_SIZE (256 * 1024)   // Pile d'un thread de partie
+#define HELLO_TIMEOUT_MS 5000          // Pseudo attendu au plus ce délai après l'accept
+#define HELLO_THREADS_MAX 256          // Accueils (lecture du pseudo) en cours à la fois
+#define HELLO_STACK_SIZE (128 * 1024)  // Pile d'un thread d'accueil
+
+static Pool conn_pool;
+static Pool seat_pool;
+static Pool table_pool;
+
+// File d'attente FIFO chaînée par Player.next, une par variante: une table
+// ne réunit que des joueurs qui ont demandé les mêmes règles.
+typedef struct {
+    Player *head;
+    Player *tail;
+    int count;
+    int open;              // Variante jouable à seats_per_table joueurs
+    Rules rules;           // Règles des tables formées depuis cette file
+} WaitQueue;
+
+static WaitQueue waitqs[VARIANT_COUNT];
+static WaitQueue *default_queue;   // Clients sans variante demandée (-v)
+static int waitq_count = 0;        // Toutes files confondues
+static int waitq_max = 256;
 static pthread_mutex_t waitq_lock = PTHREAD_MUTEX_INITIALIZER;
+static int accept_wake[2] = { -1, -1 };   // Réveille la boucle d'accueil bloquée dans select()
+static atomic_int hellos_live;            // Threads d'accueil en cours (HELLO_THREADS_MAX)
+
+static int seats_per_table;
+
+// Tournoi (-T): tables exécutées par un pool de threads, clients inscrits
+// gardés dans un salon entre deux parties.
+static Tournament tourn;
+static int tourn_active = 0;
+static Player **tourn_lobby;       // Siège libre de chaque inscrit client
+static char *tourn_playing;        // Inscrit client actuellement à une table
+static pthread_mutex_t tourn_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tourn_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int tourn_over;            // Fin du tournoi: la boucle d'accueil arrête le serveur
+static atomic_int games_local;           // Parties de la file normale en cours dans ce processus
+
+static Table *job_head = NULL;
+static Table *job_tail = NULL;
+static int jobs_pending = 0;       // Tables en file ou en cours
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+static int bot_wait = -1;                 // Secondes avant de compléter une table par des bots (-1: jamais)
+static const Strategy *bot_strategy;      // Stratégie des bots internes
+static int slow_grace_ms = 2000;          // Délai accordé à un client lent avant remplacement (-O)
+// Raisons pour lesquelles un bot reprend un siège, comptées séparément.
+typedef enum {
+    HANDOVER_UNREACHABLE,  // Écriture refusée par la connexion
+    HANDOVER_SLOW,         // File de sortie non vidée dans -O
+    HANDOVER_SLOW_END,     // Idem, pour les derniers messages de la partie
+    HANDOVER_DEAD,         // Pair mort (PING sans réponse, keepalive)
+    HANDOVER_RATE,         // Pénalité "deconnexion" des limites de débit
+    HANDOVER_CAUSES
+} Handover;
+
+static const char *handover_why[HANDOVER_CAUSES] = {
+    "injoignable", "trop lent", "trop lent en fin de partie", "ne repond plus", "coupe (debit)"
+};
+static _Atomic long handovers[HANDOVER_CAUSES];   // Sièges repris par un bot, par raison
+static _Atomic long rate_hits[RATE_KINDS];     // Limites de débit dépassées, par type
+static _Atomic long rate_penalties[3];         // Pénalités appliquées (Penalty)
+static Keepalive keepalive = { 10, 5, 3 };     // Sondes TCP des sockets acceptés (-K)
+static int uring_on;                      // Sockets TCP servis par io_uring (-I uring)
+static int ping_ms = 5000;                // Silence avant PING à un client +PING (-H, 0: jamais)
+static int dead_ms = 5000;                // Délai de réponse au PING avant de déclarer le pair mort
+static _Atomic long dead_ping;            // Pairs morts: PING sans réponse
+static _Atomic long dead_tcp;             // Pairs morts: keepalive ou données non acquittées
+static _Atomic long dead_hello;           // Connexions sans pseudo dans HELLO_TIMEOUT_MS
+
+// Processus de parties (-w), vus du frontal. Le thread d'acceptation lit les
+// comptes rendus et relance les processus; les tables partent aussi des
+// sessions multiplexées, et la grappe et USR2 lisent les compteurs: tout
+// accès passe par shard_lock (chan n'est modifié que par le thread d'acceptation).
+typedef struct {
+    pid_t pid;
+    int chan;              // Canal SEQPACKET, -1 si le processus n'a pas pu démarrer
+    int live;              // Parties en cours
+    long done;             // Parties terminées
+    int restarts;
+    double started;        // Dernier démarrage (mono_now)
+} Shard;
+
+static Shard shards[SHARD_MAX];
+static int nshards = 0;
+static pthread_mutex_t shard_lock = PTHREAD_MUTEX_INITIALIZER;
+static char **shard_argv;         // Arguments du frontal, repris à chaque (re)lancement
+static int shard_chan = -1;       // Côté processus de parties: canal vers le frontal
+
+static int admin_on = 0;          // Socket d'administration ouvert (-a)
+static int cluster_on = 0;        // Nœud d'une grappe (-C)
+static _Atomic long cluster_redirects;
+
+// Détermine si une carte doit obligatoirement prendre une rangée.
+static int needs_row(Game *g, int c) {
+    for (int r = 0; r < ROWS; r++)
+        if (c > g->rows[r].cards[g->rows[r].len - 1])
+            return 0;
+    return 1;
+}
+
+// Ferme le socket d'un joueur et rend sa connexion au pool.
+static void close_player(Player *p) {
+    if (p->conn) {
+        conn_close(p->conn);
+        pool_put(&conn_pool, p->conn);
+    }
+    p->conn = NULL;
+    p->connected = 0;
+}
 
-// Formate et envoie une ligne sur un flux client.
-static void sendf(FILE *out, const char *fmt, ...) {
+// Ferme la connexion d'un client lent ou injoignable et confie son siège à un
+// bot: la partie continue pour les autres joueurs.
+static void hand_to_bot(Player *p, Handover why) {
+    printf("[SORTIE] Joueur %s %s: siege repris par un bot\n", p->name, handover_why[why]);
+    close_player(p);
+    p->bot = bot_strategy;
+    handovers[why]++;
+}
+
+// Envoie une ligne à un joueur connecté sans jamais bloquer la table.
+static void player_send(Player *p, const char *line) {
+    if (!p->connected) return;
+    if (!conn_send_line(p->conn, line)) hand_to_bot(p, HANDOVER_UNREACHABLE);
+    else if (conn_slow_for(p->conn) * 1000.0 > slow_grace_ms) hand_to_bot(p, HANDOVER_SLOW);
+}
+
+// Formate et envoie une ligne à un joueur connecté (rien pour un bot).
+static void psendf(Player *p, const char *fmt, ...) {
+    if (!p->connected) return;
     char buf[LINE_MAX];
     va_list ap;
     va_start(ap, fmt);
     vsnprintf(buf, sizeof(buf), fmt, ap);
     va_end(ap);
-    send_line(out, buf);
+    player_send(p, buf);
 }
 
-// Propagation atomique d'un message à tous les joueurs connectés.
-static void broadcast(Player *p, int n, const char *msg) {
+// Propagation d'un message à tous les joueurs connectés.
+static void broadcast(Player **p, int n, const char *msg) {
+    for (int i = 0; i < n; i++) player_send(p[i], msg);
+}
+
+// Envoie un message aux seuls joueurs ayant annoncé une capacité.
+static void broadcast_caps(Player **p, int n, int caps, const char *msg) {
     for (int i = 0; i < n; i++)
-        if (p[i].connected)
-            send_line(p[i].out, msg);
+        if (p[i]->caps & caps) player_send(p[i], msg);
 }
 
-// Analyse  d'une commande JOUER envoyée par un client.
-static int parse_play(const char *line, int *out) {
-    while (*line && isspace((unsigned char)*line)) line++;
-    if (strncasecmp(line, "JOUER", 5) == 0) {
-        line += 5;
-        while (*line && isspace((unsigned char)*line)) line++;
+// Avant d'attendre une réponse, la question doit être partie: vide la file
+// de sortie en au plus slow_grace_ms. 0 si le siège est (ou vient d'être) repris par un bot.
+static int player_flush(Player *p) {
+    if (!p->connected) return 0;
+    if (conn_flush(p->conn, slow_grace_ms)) return 1;
+    hand_to_bot(p, HANDOVER_SLOW);
+    return 0;
+}
+
+// Vide les files de plusieurs joueurs avec une seule échéance pour tous:
+// les clients lents ne s'attendent pas les uns les autres. Les sièges dont
+// la file n'est pas vide à l'échéance passent au bot.
+static void players_flush(Player **p, int n, int timeout_ms, Handover why) {
+    Conn *cs[MAX_PLAYERS];
+    int ok[MAX_PLAYERS];
+    for (int i = 0; i < n; i++) cs[i] = p[i]->connected ? p[i]->conn : NULL;
+    if (conn_flush_all(cs, n, timeout_ms, ok) == 0) return;
+    for (int i = 0; i < n; i++)
+        if (!ok[i]) hand_to_bot(p[i], why);
+}
+
+// Attente passive (pénalité "delai").
+static void sleep_s(double s) {
+    struct timespec ts = { (time_t)s, (long)((s - (double)(time_t)s) * 1e9) };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {}
+}
+
+// Remet à neuf les limites de débit d'un siège qui reçoit une connexion:
+// seaux pleins à l'instant de l'arrivée.
+static void player_limits_reset(Player *p, uint32_t addr) {
+    double now = mono_now();
+    p->addr = addr;
+    p->rate_logged = 0;
+    bucket_init(&p->limits[RATE_LINES], &rate_config.limits[RATE_LINES], now);
+    bucket_init(&p->limits[RATE_INVALID], &rate_config.limits[RATE_INVALID], now);
+}
+
+// Contrôle de débit d'une ligne reçue pendant la partie (RATE_LINES pour
+// toute ligne, RATE_INVALID en plus pour une commande refusée), par
+// connexion puis par adresse. Renvoie 1 si la ligne suit son cours, 0 si ce
+// coup revient au bot (pénalité "bot", ou joueur déconnecté).
+static int player_admit(Player *p, RateKind kind) {
+    const RateLimit *l = &rate_config.limits[kind];
+    double now = mono_now();
+    int conn_ok = bucket_take(&p->limits[kind], l, now);
+    int addr_ok = rate_addr_take(p->addr, kind, now);
+    if (conn_ok && addr_ok) return 1;
+
+    Penalty pen = rate_config.penalty;
+    rate_hits[kind]++;
+    rate_penalties[pen]++;
+    // Une trace par connexion: un client qui inonde ne doit pas inonder le
+    // journal. Les dépassements suivants ne sont que comptés (rapport USR2).
+    if (!p->rate_logged) {
+        p->rate_logged = 1;
+        printf("[DEBIT] Joueur %s: limite %s depassee%s (%s), suivants comptes sans trace\n",
+               p->name, rate_kind_name(kind), conn_ok ? " pour son adresse" : "", penalty_name(pen));
     }
-    if (!parse_int(line, out)) return 0;
-    if (*out <= 0) return 0;
-    return 1;
+
+    if (pen == PENALTY_DELAY) {
+        double w = conn_ok ? 0 : bucket_wait(&p->limits[kind], l, now);
+        double wa = addr_ok ? 0 : rate_addr_wait(p->addr, kind, now);
+        sleep_s(w > wa ? w : wa);
+        now = mono_now();
+        if (!conn_ok) bucket_take(&p->limits[kind], l, now);
+        if (!addr_ok) rate_addr_take(p->addr, kind, now);
+        return 1;
+    }
+    if (pen == PENALTY_BOT) {
+        player_send(p, "INFO Trop de commandes: ce coup est joue par le bot.");
+        return 0;
+    }
+    hand_to_bot(p, HANDOVER_RATE);
+    return 0;
 }
 
-// Détermine si une carte doit obligatoirement prendre une rangée.
-static int needs_row(Game *g, int c) {
-    for (int r = 0; r < ROWS; r++)
-        if (c > g->rows[r].cards[g->rows[r].len - 1])
-            return 0;
-    return 1;
+// Attend la réponse d'un joueur. Un client +PING silencieux depuis ping_ms
+// reçoit PING; sans aucune ligne dead_ms plus tard il est déclaré mort. Tout
+// PONG est consommé ici, même arrivé après le coup qu'il suivait sur un lien
+// lent: ce n'est jamais une commande (ni ERREUR ni jeton de débit).
+// 1: ligne lue, 0: connexion fermée, -1: pair mort (siège à reprendre).
+static int player_recv(Player *p, char *line, int cap) {
+    int ping = (p->caps & CAP_PING) && ping_ms > 0 ? ping_ms : -1;
+    int pinged = 0;
+    for (;;) {
+        int r = conn_recv_line_timed(p->conn, line, cap, pinged ? dead_ms : ping);
+        if (r == 0 && errno == ETIMEDOUT) {
+            dead_tcp++;
+            return -1;
+        }
+        if (r == 0) return 0;
+        if (r < 0 && pinged) {
+            dead_ping++;
+            return -1;
+        }
+        if (r < 0) {
+            if (!conn_send_line(p->conn, "PING")) return 0;
+            pinged = 1;
+            continue;
+        }
+        if (strcmp(line, "PONG") == 0) {
+            pinged = 0;
+            continue;
+        }
+        return 1;
+    }
 }
 
-// Libère toutes les ressources associées à un joueur.
-static void close_player(Player *p) {
-    if (!p->connected) return;
-    if (p->in) fclose(p->in);
-    if (p->out) fclose(p->out);
-    if (p->fd >= 0) close(p->fd);
-    p->in = NULL;
-    p->out = NULL;
-    p->fd = -1;
-    p->connected = 0;
+// Libère un siège et sa connexion éventuelle.
+static void release_player(Player *p) {
+    close_player(p);
+    pool_put(&seat_pool, p);
+}
+
+// Ajoute un joueur en queue de file. Appelée avec waitq_lock tenu.
+static void waitq_push(WaitQueue *q, Player *p) {
+    p->next = NULL;
+    if (q->tail) q->tail->next = p;
+    else q->head = p;
+    q->tail = p;
+    q->count++;
+    waitq_count++;
+}
+
+// Retire le joueur en tête de file. Appelée avec waitq_lock tenu.
+static Player *waitq_pop(WaitQueue *q) {
+    Player *p = q->head;
+    if (!p) return NULL;
+    q->head = p->next;
+    if (!q->head) q->tail = NULL;
+    p->next = NULL;
+    q->count--;
+    waitq_count--;
+    return p;
+}
+
+// Réveille la boucle d'accueil: file remplie hors de son thread (thread
+// d'accueil, session multiplexée: délai des bots à recalculer) ou fin du tournoi. Pipe plein: un réveil est déjà en route.
+static void accept_wakeup(void) {
+    if (write(accept_wake[1], "", 1) < 0 && errno != EAGAIN) perror("write");
+}
+
+// File des règles demandées au hello (-1: celles du serveur), NULL si la
+// variante est inconnue ou injouable à seats_per_table joueurs.
+static WaitQueue *waitq_for(int variant) {
+    if (variant < 0) return default_queue;
+    if (variant >= VARIANT_COUNT || !waitqs[variant].open) return NULL;
+    return &waitqs[variant];
+}
+
+// Remplit un siège pour une connexion et le met en file q. Appelée avec waitq_lock tenu.
+static void seat_enqueue(WaitQueue *q, Player *p, Conn *conn, const char *name, int caps, uint32_t addr) {
+    p->conn = conn;
+    p->connected = 1;
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->caps = caps;
+    p->card = -1;
+    p->chosen_row = -1;
+    p->since = mono_now();
+    player_limits_reset(p, addr);
+    waitq_push(q, p);
+}
+
+// Journal d'une partie. Avec l'archive, seul le morceau en cours est en
+// mémoire (ARCHIVE_CHUNK_MAX): plein, il part vers l'archive, ou vers le
+// frontal depuis un processus de parties; le dernier part en fin de partie.
+// Avec -L, fichier par partie.
+typedef struct {
+    FILE *file;               // -L
+    ArchiveStream *stream;    // Archive tenue par ce processus
+    int game_id;
+    int failed;               // Un morceau est perdu: la partie ne sera pas archivée
+    size_t len;
+    char buf[ARCHIVE_CHUNK_MAX];
+} GameLog;
+
+// Envoie le morceau en cours.
+static void log_flush(GameLog *lf) {
+    if (!lf || lf->file || lf->len == 0) return;
+    int ok = lf->stream ? archive_stream_append(lf->stream, lf->buf, lf->len)
+                        : shard_send_log(shard_chan, lf->game_id, lf->buf, lf->len);
+    if (!ok && !lf->failed)
+        printf("[PARTIE %d] Echec d'ecriture du journal (errno=%d)\n", lf->game_id, errno);
+    lf->failed |= !ok;
+    lf->len = 0;
 }
 
 // Ajoute une ligne au journal de partie si disponible.
-static void logf_line(FILE *lf, const char *fmt, ...) {
+static void logf_line(GameLog *lf, const char *fmt, ...) {
     if (!lf) return;
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(lf, fmt, ap);
+    if (lf->file) {
+        vfprintf(lf->file, fmt, ap);
+        fflush(lf->file);
+        va_end(ap);
+        return;
+    }
+    va_list again;
+    va_copy(again, ap);
+    size_t room = sizeof(lf->buf) - lf->len;
+    int k = vsnprintf(lf->buf + lf->len, room, fmt, ap);
+    if (k >= 0 && (size_t)k >= room && lf->len > 0) {
+        // Ne tient plus: le morceau part, la ligne ouvre le suivant
+        log_flush(lf);
+        room = sizeof(lf->buf);
+        k = vsnprintf(lf->buf, room, fmt, again);
+    }
+    if (k > 0) lf->len += (size_t)k < room ? (size_t)k : room - 1;
+    va_end(again);
     va_end(ap);
-    fflush(lf);
+}
+
+// Vue de la table en début de tour (cartes du tour précédent encore connues).
+static void table_view(const Table *t, const Game *g, const int *was_human, GameView *v) {
+    v->game_id = t->game_id;
+    snprintf(v->variant, sizeof(v->variant), "%s", t->rules.name);
+    v->nplayers = t->nplayers;
+    v->manche = g->manche;
+    v->tour = g->tour;
+    memcpy(v->rows, g->rows, sizeof(v->rows));
+    for (int i = 0; i < t->nplayers; i++) {
+        const Player *p = t->seats[i];
+        LiveSeat *s = &v->seats[i];
+        snprintf(s->name, sizeof(s->name), "%s", p->name);
+        s->state = !was_human[i] ? SEAT_BOT : p->connected ? SEAT_HUMAN : SEAT_TAKEN_OVER;
+        s->score = g->scores[i];
+        s->hand_len = g->hand_len[i];
+        s->card = p->card;
+    }
 }
 
 // Boucle principale gérant une partie complète dans un thread dédié.
 static void *game_thread(void *arg) {
-    GameArgs *ga = arg;
-    int gid = ga->game_id;
-    int n = ga->nplayers;
-
+    Table *t = arg;
+    int gid = t->game_id;
+    int n = t->nplayers;
+    Rules rules = t->rules;
+    Player **players = t->seats;
+    int aborted = 0;
+
+    // Avec l'archive, le journal part par morceaux au fil des tours.
     char logfile[128];
-    snprintf(logfile, sizeof(logfile), "logs/partie_%d.log", gid);
-    FILE *lf = fopen(logfile, "w");
-
-    Player players[MAX_PLAYERS];
-    memset(players, 0, sizeof(players));
-
-    for (int i = 0; i < n; i++) {
-        players[i].fd = ga->wp[i].fd;
-        players[i].in = ga->wp[i].in;
-        players[i].out = ga->wp[i].out;
-        players[i].connected = 1;
-        strncpy(players[i].name, ga->wp[i].name, PLAYER_NAME_MAX - 1);
-        players[i].name[PLAYER_NAME_MAX - 1] = 0;
-        players[i].card = -1;
-        players[i].chosen_row = -1;
+    time_t started = time(NULL);
+    GameLog glog = { .game_id = gid };
+    GameLog *lf = &glog;
+    if (log_archived) {
+        snprintf(logfile, sizeof(logfile), "%s", ARCHIVE_DIR);
+        if (shard_chan < 0 && !(glog.stream = archive_stream_open(archive, gid))) lf = NULL;
+    } else {
+        snprintf(logfile, sizeof(logfile), "logs/partie_%d.log", gid);
+        if (!(glog.file = fopen(logfile, "w"))) lf = NULL;
     }
 
-    free(ga);
+    trace_thread_name("partie %d", gid);
 
-    printf("[PARTIE %d] Demarrage (%d joueurs)\n", gid, n);
+    // Table entièrement tenue par des bots: mode turbo, sans sortie par tour.
+    int turbo = 1;
     for (int i = 0; i < n; i++)
-        printf("[PARTIE %d] Joueur %d = %s\n", gid, i + 1, players[i].name);
+        if (!players[i]->bot) turbo = 0;
+
+    if (turbo) {
+        printf("[PARTIE %d] Demarrage (%d bots, turbo)\n", gid, n);
+    } else {
+        printf("[PARTIE %d] Demarrage (%d joueurs)\n", gid, n);
+        for (int i = 0; i < n; i++)
+            printf("[PARTIE %d] Joueur %d = %s%s\n", gid, i + 1, players[i]->name,
+                   players[i]->bot ? " (bot)" : "");
+    }
 
     logf_line(lf, "PARTIE %d DEBUT\n", gid);
     logf_line(lf, "JOUEURS ");
-    for (int i = 0; i < n; i++) logf_line(lf, "%d:%s ", i + 1, players[i].name);
+    for (int i = 0; i < n; i++) logf_line(lf, "%d:%s ", i + 1, players[i]->name);
     logf_line(lf, "\n");
 
     if (!lf) {
@@ -148,62 +504,148 @@ static void *game_thread(void *arg) {
     }
 
     Game game;
-    game_init(&game, n);
+    game_init_rules(&game, n, &rules);
     game_setup_rows(&game);
     game_deal(&game);
 
-    sendf(players[0].out, "INFO Partie %d demarree.", gid);
-    for (int i = 1; i < n; i++) sendf(players[i].out, "INFO Partie %d demarree.", gid);
+    logf_line(lf, "REGLES %s %d %d %d %d\n", rules.name, game.deck_len,
+              rules.row_max, rules.hand_size, rules.end_score);
+
+    // Socket d'administration: la table publie son état à chaque tour.
+    int was_human[MAX_PLAYERS];
+    double resp_sum[MAX_PLAYERS] = { 0 };   // Attente des réponses, pour les statistiques
+    int resp_count[MAX_PLAYERS] = { 0 };
+    GameView view;
+    for (int i = 0; i < n; i++) was_human[i] = players[i]->connected;
+    if (admin_on) {
+        table_view(t, &game, was_human, &view);
+        view.started = (int64_t)started;
+        live_add(&t->live, &view);
+    }
 
-    while (!game_over(&game, 66)) {
-        char table[LINE_MAX];
-        game_table_string(&game, table, sizeof(table));
-        broadcast(players, n, table);
+    for (int i = 0; i < n; i++)
+        if (players[i]->conn) mux_bind(players[i]->conn, gid, i + 1);   // Préfixe des sièges multiplexés
+    for (int i = 0; i < n; i++) psendf(players[i], "INFO Partie %d demarree.", gid);
+    for (int i = 0; i < n; i++) psendf(players[i], "SIEGE %d", i + 1);   // Numéro des POSE/RAMASSE
+    for (int i = 0; i < n; i++)
+        psendf(players[i], "REGLES %s %d %d %d %d", rules.name, game.deck_len,
+               rules.row_max, rules.hand_size, rules.end_score);
 
-        printf("[PARTIE %d] TOUR %d TABLE: %s\n", gid, game.tour, table);
-        logf_line(lf, "TOUR %d TABLE %s\n", game.tour, table);
+    while (!game_over(&game, rules.end_score)) {
+        if (admin_on) {
+            table_view(t, &game, was_human, &view);
+            live_publish(&t->live, &view);
+        }
+
+        char table[LINE_MAX];
+        TRACE_BEGIN(tr_render, "rendu_table", gid, 0);
+        if (!turbo) game_table_string(&game, table, sizeof(table));
+        TRACE_END(tr_render);
 
+        // Mode delta: table et main complètes seulement en début de manche.
+        TRACE_BEGIN(tr_bcast, "diffusion_table", gid, 0);
+        int resync = game.tour == 1;
         for (int i = 0; i < n; i++) {
-            char hand[LINE_MAX];
-            game_hand_string(&game, i, hand, sizeof(hand));
-            sendf(players[i].out, "MAIN %s", hand);
-            players[i].chosen_row = -1;
-            players[i].card = -1;
+            players[i]->chosen_row = -1;
+            players[i]->card = -1;
+            if (!players[i]->connected) continue;
+
+            if (resync || !(players[i]->caps & CAP_DELTA)) {
+                char hand[LINE_MAX];
+                player_send(players[i], table);
+                game_hand_string(&game, i, hand, sizeof(hand));
+                psendf(players[i], "MAIN %s", hand);
+            } else {
+                psendf(players[i], "TOUR %d", game.tour);
+            }
+            // Client +PIPELINE: sa carte est peut-être déjà en route, pas
+            // d'invite avant la première lecture (seulement après une erreur).
+            if (!(players[i]->caps & CAP_PIPELINE)) player_send(players[i], "DEMANDE_CARTE");
+        }
+        // Tour et invites partent avec une échéance commune, avant d'attendre
+        // la première carte.
+        players_flush(players, n, slow_grace_ms, HANDOVER_SLOW);
+        double prompted = mono_now();   // Temps de réponse compté depuis l'invite commune
+        TRACE_END(tr_bcast);
+
+        if (!turbo) {
+            printf("[PARTIE %d] TOUR %d TABLE: %s\n", gid, game.tour, table);
+            logf_line(lf, "TOUR %d TABLE %s\n", game.tour, table);
         }
 
         for (int i = 0; i < n; i++) {
             char line[LINE_MAX];
             int c;
 
-            for (;;) {
-                send_line(players[i].out, "DEMANDE_CARTE");
-                if (!recv_line(players[i].in, line, sizeof(line))) {
+            // Invite déjà envoyée avec le tour; seulement renvoyée après une erreur.
+            int prompt = 0;
+            const Strategy *autoplay = NULL;   // Limite de débit: ce coup revient au bot
+            while (!players[i]->bot) {
+                if (prompt) {
+                    player_send(players[i], "DEMANDE_CARTE");
+                    if (!player_flush(players[i])) break;
+                }
+                TRACE_BEGIN(tr_wait, "attente_carte", gid, i + 1);
+                double asked = prompt ? mono_now() : prompted;
+                prompt = 1;
+                int got = player_recv(players[i], line, sizeof(line));
+                resp_sum[i] += mono_now() - asked;
+                resp_count[i]++;
+                TRACE_END(tr_wait);
+                if (got < 0) {
+                    hand_to_bot(players[i], HANDOVER_DEAD);
+                    break;
+                }
+                if (!got) {
                     printf("[PARTIE %d] Joueur %d (%s) deconnecte pendant DEMANDE_CARTE\n",
-                           gid, i + 1, players[i].name);
-                    logf_line(lf, "DECO JOUEUR %d %s\n", i + 1, players[i].name);
+                           gid, i + 1, players[i]->name);
+                    logf_line(lf, "DECO JOUEUR %d %s\n", i + 1, players[i]->name);
+                    close_player(players[i]);
+                    aborted = 1;
                     goto end;
                 }
 
-                if (!parse_play(line, &c) || !game_hand_has(&game, i, c)) {
-                    send_line(players[i].out, "ERREUR Carte invalide");
+                if (!player_admit(players[i], RATE_LINES)) {
+                    autoplay = bot_strategy;
+                    break;
+                }
+
+                int row;
+                if (!parse_play(line, &c, &row) || !game_hand_has(&game, i, c) ||
+                    !game_hand_remove(&game, i, c)) {
+                    if (!player_admit(players[i], RATE_INVALID)) {
+                        autoplay = bot_strategy;
+                        break;
+                    }
+                    player_send(players[i], "ERREUR Carte invalide");
                     continue;
                 }
 
+                players[i]->chosen_row = row - 1;   // -1: pas de rangée annoncée
+                break;
+            }
+
+            if (players[i]->bot || autoplay) {
+                // Appel direct de la stratégie, sans aller-retour réseau
+                const Strategy *bot = players[i]->bot ? players[i]->bot : autoplay;
+                c = bot->choose_card(game.hands[i], game.hand_len[i], game.rows, rules.row_max);
                 if (!game_hand_remove(&game, i, c)) {
-                    send_line(players[i].out, "ERREUR Carte invalide");
-                    continue;
+                    c = game.hands[i][0];
+                    game_hand_remove(&game, i, c);
                 }
+            }
 
-                game.carte_jouee[i] = c;
-                players[i].card = c;
+            game.carte_jouee[i] = c;
+            players[i]->card = c;
 
+            if (!turbo) {
                 printf("[PARTIE %d] TOUR %d Joueur %d (%s) joue %d\n",
-                       gid, game.tour, i + 1, players[i].name, c);
-                logf_line(lf, "TOUR %d PLAY %d %s %d\n", game.tour, i + 1, players[i].name, c);
-                break;
+                       gid, game.tour, i + 1, players[i]->name, c);
+                logf_line(lf, "TOUR %d PLAY %d %s %d\n", game.tour, i + 1, players[i]->name, c);
             }
         }
 
+        TRACE_BEGIN(tr_sort, "tri", gid, 0);
         int order[MAX_PLAYERS];
         for (int i = 0; i < n; i++) order[i] = i;
 
@@ -215,6 +657,8 @@ static void *game_thread(void *arg) {
                     order[j] = t;
                 }
 
+        TRACE_END(tr_sort);
+
         int taken[MAX_PLAYERS];
         int bulls[MAX_PLAYERS];
         for (int i = 0; i < n; i++) { taken[i] = -1; bulls[i] = 0; }
@@ -223,184 +667,1627 @@ static void *game_thread(void *arg) {
             int pid = order[k];
             int c = game.carte_jouee[pid];
 
-            if (needs_row(&game, c)) {
+            TRACE_BEGIN(tr_row, "choix_rangee", gid, pid + 1);
+            if (needs_row(&game, c) && players[pid]->chosen_row >= 0) {
+                // Rangée annoncée avec la carte (JOUER c r): pas d'aller-retour
+                printf("[PARTIE %d] TOUR %d Joueur %d (%s) choisit rangee %d (annoncee)\n",
+                       gid, game.tour, pid + 1, players[pid]->name, players[pid]->chosen_row + 1);
+                logf_line(lf, "TOUR %d CHOOSE_ROW %d %s %d\n", game.tour, pid + 1, players[pid]->name,
+                          players[pid]->chosen_row + 1);
+            } else if (needs_row(&game, c) && !players[pid]->bot) {
                 char line[LINE_MAX];
                 printf("[PARTIE %d] TOUR %d Joueur %d (%s) doit choisir une rangee\n",
-                       gid, game.tour, pid + 1, players[pid].name);
-                logf_line(lf, "TOUR %d NEED_ROW %d %s\n", game.tour, pid + 1, players[pid].name);
+                       gid, game.tour, pid + 1, players[pid]->name);
+                logf_line(lf, "TOUR %d NEED_ROW %d %s\n", game.tour, pid + 1, players[pid]->name);
 
                 for (;;) {
-                    send_line(players[pid].out, "CHOISIR_RANGEES");
-                    if (!recv_line(players[pid].in, line, sizeof(line))) {
+                    player_send(players[pid], "CHOISIR_RANGEES");
+                    if (!player_flush(players[pid])) break;
+                    double asked = mono_now();
+                    int got = player_recv(players[pid], line, sizeof(line));
+                    resp_sum[pid] += mono_now() - asked;
+                    resp_count[pid]++;
+                    if (got < 0) {
+                        hand_to_bot(players[pid], HANDOVER_DEAD);
+                        break;
+                    }
+                    if (!got) {
                         printf("[PARTIE %d] Joueur %d (%s) deconnecte pendant CHOISIR_RANGEES\n",
-                               gid, pid + 1, players[pid].name);
-                        logf_line(lf, "DECO JOUEUR %d %s\n", pid + 1, players[pid].name);
+                               gid, pid + 1, players[pid]->name);
+                        logf_line(lf, "DECO JOUEUR %d %s\n", pid + 1, players[pid]->name);
+                        close_player(players[pid]);
+                        aborted = 1;
                         goto end;
                     }
+                    if (!player_admit(players[pid], RATE_LINES)) break;
                     int r;
                     if (parse_int(line, &r) && r >= 1 && r <= ROWS) {
-                        players[pid].chosen_row = r - 1;
+                        players[pid]->chosen_row = r - 1;
                         printf("[PARTIE %d] TOUR %d Joueur %d (%s) choisit rangee %d\n",
-                               gid, game.tour, pid + 1, players[pid].name, r);
-                        logf_line(lf, "TOUR %d CHOOSE_ROW %d %s %d\n", game.tour, pid + 1, players[pid].name, r);
+                               gid, game.tour, pid + 1, players[pid]->name, r);
+                        logf_line(lf, "TOUR %d CHOOSE_ROW %d %s %d\n", game.tour, pid + 1, players[pid]->name, r);
                         break;
                     }
-                    send_line(players[pid].out, "ERREUR Choix de rangee invalide");
+                    if (!player_admit(players[pid], RATE_INVALID)) break;
+                    player_send(players[pid], "ERREUR Choix de rangee invalide");
                 }
             }
-
-            game_place_card(&game, pid, c, players[pid].chosen_row, &taken[pid], &bulls[pid]);
-
-            if (taken[pid] >= 0) {
+            // Bot interne, siège repris par un bot pendant la question ou limite de débit
+            if (needs_row(&game, c) && players[pid]->chosen_row < 0)
+                players[pid]->chosen_row =
+                    (players[pid]->bot ? players[pid]->bot : bot_strategy)->choose_row(game.rows);
+
+            TRACE_END(tr_row);
+
+            TRACE_BEGIN(tr_place, "placement", gid, pid + 1);
+            int dest = game_best_row(&game, c, NULL);
+            game_place_card(&game, pid, c, players[pid]->chosen_row, &taken[pid], &bulls[pid]);
+            TRACE_END(tr_place);
+
+            char ev[64];
+            if (taken[pid] >= 0)
+                snprintf(ev, sizeof(ev), "RAMASSE %d %d %d %d", pid + 1, taken[pid] + 1, bulls[pid], c);
+            else
+                snprintf(ev, sizeof(ev), "POSE %d %d %d", pid + 1, c, dest + 1);
+            broadcast_caps(players, n, CAP_DELTA, ev);
+
+            if (taken[pid] >= 0 && !turbo) {
                 printf("[PARTIE %d] TOUR %d Joueur %d (%s) ramasse rangee %d (+%d)\n",
-                       gid, game.tour, pid + 1, players[pid].name, taken[pid] + 1, bulls[pid]);
+                       gid, game.tour, pid + 1, players[pid]->name, taken[pid] + 1, bulls[pid]);
                 logf_line(lf, "TOUR %d TAKE %d %s ROW %d BULLS %d\n",
-                          game.tour, pid + 1, players[pid].name, taken[pid] + 1, bulls[pid]);
+                          game.tour, pid + 1, players[pid]->name, taken[pid] + 1, bulls[pid]);
             }
         }
 
+        if (!turbo) {
+            char score[LINE_MAX];
+            TRACE_BEGIN(tr_score, "diffusion_scores", gid, 0);
+            game_score_string(&game, score, sizeof(score));
+            broadcast(players, n, score);
+            TRACE_END(tr_score);
+
+            printf("[PARTIE %d] TOUR %d SCORES: %s\n", gid, game.tour, score);
+            logf_line(lf, "TOUR %d SCORES %s\n", game.tour, score);
+        }
+
+        game.tour++;
+        if (game.tour > rules.hand_size)
+            game_next_manche(&game);
+    }
+
+end:
+    {
         char score[LINE_MAX];
         game_score_string(&game, score, sizeof(score));
-        broadcast(players, n, score);
+        printf("[PARTIE %d] Fin de la partie (%s)\n", gid, score);
+        logf_line(lf, "SCORES_FINAUX %s\n", score);
+    }
+    logf_line(lf, "PARTIE %d FIN\n", gid);
+    log_flush(lf);
+    if (glog.file) fclose(glog.file);
+    if (admin_on) live_remove(&t->live);
+    if (shard_chan >= 0) {
+        // Processus de parties: le frontal publie le journal et décompte la partie
+        if (!shard_send_done(shard_chan, gid, aborted, (int64_t)started, (int64_t)time(NULL)))
+            printf("[PARTIE %d] Compte rendu non transmis au frontal (errno=%d)\n", gid, errno);
+    } else if (glog.stream) {
+        if (!archive_stream_commit(glog.stream, started, time(NULL)))
+            printf("[PARTIE %d] Echec d'ecriture dans l'archive (errno=%d)\n", gid, errno);
+    }
 
-        printf("[PARTIE %d] TOUR %d SCORES: %s\n", gid, game.tour, score);
-        logf_line(lf, "TOUR %d SCORES %s\n", game.tour, score);
+    // Derniers messages en file: un délai de grâce, puis la connexion est fermée.
+    players_flush(players, n, slow_grace_ms, HANDOVER_SLOW_END);
 
-        game.tour++;
-        if (game.tour > HAND_SIZE) {
-            game.manche++;
-            game.tour = 1;
-            if (game.top + ROWS + game.nplayers * HAND_SIZE > DECK_SIZE) {
-                game.fin = 1;
-            } else {
-                game_setup_rows(&game);
-                game_deal(&game);
+    // Statistiques des joueurs (sièges humains au départ), sauf abandon.
+    if (stats && !aborted) {
+        StatsResult res[MAX_PLAYERS];
+        for (int i = 0; i < n; i++) {
+            res[i].name = players[i]->name;
+            res[i].score = game.scores[i];
+            res[i].rated = was_human[i];
+            res[i].resp_sum = resp_sum[i];
+            res[i].resp_count = resp_count[i];
+        }
+        stats_record_game(stats, res, n);
+    }
+
+    // Tournoi: partie classée (sauf abandon), clients renvoyés au salon.
+    if (t->tourn && !aborted) {
+        int ids[MAX_PLAYERS];
+        for (int i = 0; i < n; i++)
+            ids[i] = players[i]->entrant ? (int)(players[i]->entrant - t->tourn->entrants) : -1;
+        tournament_record(t->tourn, ids, game.scores, n);
+    }
+
+    for (int i = 0; i < n; i++) {
+        Entrant *e = players[i]->entrant;
+        if (!e || e->bot) {
+            release_player(players[i]);
+            continue;
+        }
+        int id = (int)(e - tourn.entrants);
+        pthread_mutex_lock(&tourn_lock);
+        tourn_playing[id] = 0;
+        if (players[i]->connected) tourn_lobby[id] = players[i];
+        pthread_cond_broadcast(&tourn_cond);
+        pthread_mutex_unlock(&tourn_lock);
+        if (!players[i]->connected) release_player(players[i]);
+    }
+    int queued = !t->tourn;
+    pool_put(&table_pool, t);
+    if (queued) atomic_fetch_sub(&games_local, 1);
+
+    return NULL;
+}
+
+static void start_game(Table *t);
+
+// (Re)lance le processus de parties i.
+static void shard_start(int i) {
+    int chan = -1;
+    pid_t pid = shard_spawn(shard_argv, &chan);
+    pthread_mutex_lock(&shard_lock);
+    shards[i].started = mono_now();
+    shards[i].live = 0;
+    shards[i].pid = pid;
+    shards[i].chan = pid < 0 ? -1 : chan;
+    pthread_mutex_unlock(&shard_lock);
+    if (pid < 0)
+        printf("[SHARD %d] Lancement impossible (errno=%d)\n", i, errno);
+    else
+        printf("[SHARD %d] Processus %d demarre\n", i, (int)pid);
+    fflush(stdout);
+}
+
+// Processus de parties le moins chargé (parties en cours), -1 si aucun.
+// Appelée avec shard_lock tenu.
+static int shard_pick(void) {
+    int best = -1;
+    for (int i = 0; i < nshards; i++)
+        if (shards[i].chan >= 0 && (best < 0 || shards[i].live < shards[best].live))
+            best = i;
+    return best;
+}
+
+// Confie une table formée au processus de parties le moins chargé: ses
+// sockets partent par SCM_RIGHTS, le frontal n'en garde rien. Renvoie 0 si
+// aucun processus ne l'a prise (la table tourne alors dans le frontal).
+// Appelée sans waitq_lock: la vidange des files de sortie peut attendre.
+static int shard_dispatch(Table *t) {
+    ShardTable m;
+    int fds[2 * MAX_PLAYERS];
+    int nfds = 0;
+    memset(&m, 0, sizeof(m));
+    m.game_id = t->game_id;
+    m.nplayers = t->nplayers;
+    m.variant = (int)t->rules.id;
+    m.end_score = t->rules.end_score;
+
+    // Un siège multiplexé partage son socket avec d'autres tables: la table reste ici
+    for (int i = 0; i < t->nplayers; i++)
+        if (t->seats[i]->conn && conn_is_mux(t->seats[i]->conn)) return 0;
+
+    // La file de sortie ne suit pas la connexion: elle doit être vide ici.
+    players_flush(t->seats, t->nplayers, 100, HANDOVER_SLOW);
+    for (int i = 0; i < t->nplayers; i++) {
+        Player *p = t->seats[i];
+        ShardSeat *ss = &m.seats[i];
+        snprintf(ss->name, sizeof(ss->name), "%s", p->name);
+        ss->caps = p->caps;
+        ss->addr = p->addr;
+        if (!p->connected) continue;
+
+        Conn *c = p->conn;
+        ss->human = 1;
+        fds[nfds++] = c->fd;
+        if (conn_is_shm(c)) {
+            ss->shm = 1;
+            fds[nfds++] = c->passed_fd;
+        }
+        ss->rlen = c->rlen - c->rpos;
+        memcpy(ss->rbuf, c->rbuf + c->rpos, (size_t)ss->rlen);
+    }
+
+    pthread_mutex_lock(&shard_lock);
+    int s = shard_pick();
+    int ok = s >= 0 && shard_send_table(shards[s].chan, &m, fds, nfds);
+    if (ok) shards[s].live++;
+    pthread_mutex_unlock(&shard_lock);
+    if (!ok) return 0;
+
+    for (int i = 0; i < t->nplayers; i++) {
+        Player *p = t->seats[i];
+        if (p->conn) {
+            conn_detach(p->conn);
+            pool_put(&conn_pool, p->conn);
+        }
+        pool_put(&seat_pool, p);
+    }
+    pool_put(&table_pool, t);
+    return 1;
+}
+
+// Journaux des parties en cours dans les processus de parties, ouverts au
+// premier morceau reçu. Tenus par le seul thread d'acceptation (shard_service).
+typedef struct ShardJournal {
+    int game_id;
+    int shard;
+    int failed;
+    ArchiveStream *stream;
+    struct ShardJournal *next;
+} ShardJournal;
+
+#define JOURNAL_BUCKETS 1024
+static ShardJournal *journals[JOURNAL_BUCKETS];
+
+// Lien vers le journal d'une partie (*lien NULL s'il n'est pas ouvert).
+static ShardJournal **journal_find(int gid) {
+    ShardJournal **link = &journals[(unsigned)gid % JOURNAL_BUCKETS];
+    while (*link && (*link)->game_id != gid) link = &(*link)->next;
+    return link;
+}
+
+// Nouveau journal (à chaîner par l'appelant); NULL sans archive ou sans
+// mémoire. Sans flux, il reste marqué en échec: les morceaux suivants ne
+// rouvrent pas un journal troué.
+static ShardJournal *journal_open(int gid, int shard) {
+    if (!archive) return NULL;
+    ShardJournal *j = calloc(1, sizeof(*j));
+    if (!j) return NULL;
+    j->game_id = gid;
+    j->shard = shard;
+    j->stream = archive_stream_open(archive, gid);
+    j->failed = !j->stream;
+    return j;
+}
+
+// Traite un message du processus de parties i: morceau de journal, fin de
+// partie à archiver, ou fermeture du canal (processus mort avec ses parties),
+// suivie d'une relance.
+static void shard_service(int i) {
+    ShardReport d;
+    int r = shard_recv_report(shards[i].chan, &d);
+    if (r < 0) return;
+    if (r > 0 && d.kind == SHARD_LOG) {
+        ShardJournal **link = journal_find(d.game_id);
+        if (!*link) *link = journal_open(d.game_id, i);
+        ShardJournal *j = *link;
+        if (j && j->stream && !archive_stream_append(j->stream, d.log, d.log_len) && !j->failed) {
+            j->failed = 1;
+            printf("[PARTIE %d] Echec d'ecriture du journal (errno=%d)\n", d.game_id, errno);
+        }
+        return;
+    }
+    if (r > 0) {
+        pthread_mutex_lock(&shard_lock);
+        shards[i].live--;
+        shards[i].done++;
+        pthread_mutex_unlock(&shard_lock);
+        ShardJournal **link = journal_find(d.game_id);
+        ShardJournal *j = *link;
+        if (j) {
+            *link = j->next;
+            if (!j->stream || !archive_stream_commit(j->stream, (time_t)d.started, (time_t)d.ended))
+                printf("[PARTIE %d] Echec d'ecriture dans l'archive (errno=%d)\n", d.game_id, errno);
+            free(j);
+        }
+        return;
+    }
+
+    // Journaux des parties perdues: jamais indexés
+    for (int b = 0; b < JOURNAL_BUCKETS; b++)
+        for (ShardJournal **link = &journals[b]; *link;) {
+            ShardJournal *j = *link;
+            if (j->shard != i) {
+                link = &j->next;
+                continue;
             }
+            *link = j->next;
+            if (j->stream) archive_stream_abort(j->stream);
+            free(j);
         }
+
+    int status = 0;
+    pthread_mutex_lock(&shard_lock);
+    close(shards[i].chan);
+    shards[i].chan = -1;
+    shards[i].restarts++;
+    pid_t pid = shards[i].pid;
+    int lost = shards[i].live;
+    double started = shards[i].started;
+    pthread_mutex_unlock(&shard_lock);
+    waitpid(pid, &status, 0);
+    printf("[SHARD %d] Processus %d arrete (%s %d), %d parties perdues: relance\n", i,
+           (int)pid, WIFSIGNALED(status) ? "signal" : "code",
+           WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status), lost);
+    // Pas de relance en boucle serrée si le processus meurt dès son démarrage
+    if (mono_now() - started < 1.0) sleep(1);
+    shard_start(i);
+}
+
+// Ajoute à rs les canaux des processus de parties; renvoie le plus grand fd.
+static int shard_fdset(fd_set *rs, int maxfd) {
+    for (int i = 0; i < nshards; i++) {
+        if (shards[i].chan < 0) continue;
+        FD_SET(shards[i].chan, rs);
+        if (shards[i].chan > maxfd) maxfd = shards[i].chan;
+    }
+    return maxfd;
+}
+
+// Traite les canaux prêts après select().
+static void shard_serve(fd_set *rs) {
+    for (int i = 0; i < nshards; i++)
+        if (shards[i].chan >= 0 && FD_ISSET(shards[i].chan, rs)) shard_service(i);
+}
+
+// Reconstruit, dans un processus de parties, une table reçue du frontal.
+static Table *shard_table(const ShardTable *m, const int *fds, int nfds) {
+    int need = 0;
+    for (int i = 0; i < m->nplayers && i < MAX_PLAYERS; i++)
+        need += m->seats[i].human ? 1 + m->seats[i].shm : 0;
+
+    Table *t = NULL;
+    if (m->nplayers < MIN_PLAYERS || m->nplayers > MAX_PLAYERS || need != nfds ||
+        m->variant < 0 || m->variant >= VARIANT_COUNT || !(t = pool_get(&table_pool))) {
+        for (int i = 0; i < nfds; i++) close(fds[i]);
+        return NULL;
     }
 
-end:
-    printf("[PARTIE %d] Fin de la partie\n", gid);
-    logf_line(lf, "PARTIE %d FIN\n", gid);
-    if (lf) fclose(lf);
+    t->game_id = m->game_id;
+    t->nplayers = m->nplayers;
+    t->rules = *rules_get((Variant)m->variant);
+    t->rules.end_score = m->end_score;
+
+    int k = 0;
+    for (int i = 0; i < m->nplayers; i++) {
+        const ShardSeat *ss = &m->seats[i];
+        Player *p = pool_get(&seat_pool);
+        Conn *c = ss->human ? pool_get(&conn_pool) : NULL;
+        if (!p || (ss->human && !c)) die("pool");
+
+        snprintf(p->name, sizeof(p->name), "%s", ss->name);
+        p->caps = ss->caps;
+        p->card = -1;
+        p->chosen_row = -1;
+        p->bot = bot_strategy;
+        t->seats[i] = p;
+        if (!ss->human) continue;
+
+        conn_init(c, fds[k++]);
+        if (ss->shm) {
+            c->passed_fd = fds[k++];
+            if (!conn_attach_shm(c)) {
+                conn_close(c);
+                pool_put(&conn_pool, c);
+                continue;
+            }
+        }
+        player_limits_reset(p, ss->addr);
+        c->rlen = ss->rlen > 0 && ss->rlen <= CONN_RBUF ? ss->rlen : 0;
+        memcpy(c->rbuf, ss->rbuf, (size_t)c->rlen);
+        p->conn = c;
+        p->connected = 1;
+        p->bot = NULL;
+    }
+    return t;
+}
 
-    for (int i = 0; i < n; i++)
-        close_player(&players[i]);
+// Boucle d'un processus de parties: reçoit les tables du frontal et lance
+// leurs threads. S'arrête quand le frontal ferme le canal.
+static int shard_worker(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("[SHARD] Processus %d pret\n", (int)getpid());
+    fflush(stdout);
+    for (;;) {
+        ShardTable m;
+        int fds[2 * MAX_PLAYERS];
+        int nfds = 0;
+        int r = shard_recv_table(shard_chan, &m, fds, &nfds);
+        if (r == 0) return 0;
+        if (r < 0) continue;
+        Table *t = shard_table(&m, fds, nfds);
+        if (t) start_game(t);
+    }
+}
+
+// Forme une table: les humains en tête de file, complétés par des bots.
+// Les sièges passent de la file à la table par pointeur, sans copie.
+// Appelée avec waitq_lock tenu: la table rejoint *ready, lancée par
+// run_tables une fois le verrou rendu. Renvoie 0 si la mémoire manque.
+static int launch_table(WaitQueue *q, int from_queue, int nplayers, Table **ready) {
+    Table *t = pool_get(&table_pool);
+    if (!t) return 0;
+
+    for (int i = from_queue; i < nplayers; i++) {
+        Player *p = pool_get(&seat_pool);
+        if (!p) {
+            for (int j = from_queue; j < i; j++) pool_put(&seat_pool, t->seats[j]);
+            pool_put(&table_pool, t);
+            return 0;
+        }
+        p->bot = bot_strategy;
+        p->card = -1;
+        p->chosen_row = -1;
+        snprintf(p->name, sizeof(p->name), "bot-%s-%d", bot_strategy->name, i + 1);
+        t->seats[i] = p;
+    }
+
+    pthread_mutex_lock(&game_id_lock);
+    int gid = ++global_game_id;
+    pthread_mutex_unlock(&game_id_lock);
+
+    t->game_id = gid;
+    t->nplayers = nplayers;
+    t->rules = q->rules;
+
+    for (int i = 0; i < from_queue; i++)
+        t->seats[i] = waitq_pop(q);
+
+    if (from_queue > 0)
+        printf("[PARTIE %d] Creation (%d joueurs, %d bots, %s). Reste en attente=%d\n",
+               gid, from_queue, nplayers - from_queue, q->rules.name, q->count);
+
+    t->next = *ready;
+    *ready = t;
+    return 1;
+}
+
+// Lance les tables formées par launch_table, sans waitq_lock: l'envoi à un
+// processus de parties attend que les files de sortie des joueurs se vident.
+static void run_tables(Table *ready) {
+    while (ready) {
+        Table *t = ready;
+        ready = t->next;
+        t->next = NULL;
+        if (nshards > 0 && shard_dispatch(t)) continue;
+        start_game(t);
+    }
+}
+
+// Lance le thread d'une table; en cas d'échec les sièges sont rendus.
+static void start_game(Table *t) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, GAME_STACK_SIZE);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    pthread_t tid;
+    atomic_fetch_add(&games_local, 1);
+    int ok = pthread_create(&tid, &attr, game_thread, t) == 0;
+    pthread_attr_destroy(&attr);
+    if (!ok) {
+        atomic_fetch_sub(&games_local, 1);
+        for (int i = 0; i < t->nplayers; i++) release_player(t->seats[i]);
+        pool_put(&table_pool, t);
+    }
+}
+
+// Thread du pool de tournoi: exécute les tables de la file une à une.
+static void *tourn_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&job_lock);
+        while (!job_head) pthread_cond_wait(&job_ready, &job_lock);
+        Table *t = job_head;
+        job_head = t->next;
+        if (!job_head) job_tail = NULL;
+        pthread_mutex_unlock(&job_lock);
+
+        game_thread(t);
+
+        pthread_mutex_lock(&job_lock);
+        jobs_pending--;
+        pthread_cond_broadcast(&job_done);
+        pthread_mutex_unlock(&job_lock);
+    }
+    return NULL;
+}
+
+// Attend que toutes les tables lancées soient terminées.
+static void tourn_wait_jobs(void) {
+    pthread_mutex_lock(&job_lock);
+    while (jobs_pending > 0) pthread_cond_wait(&job_done, &job_lock);
+    pthread_mutex_unlock(&job_lock);
+}
+
+// Monte une table de tournoi (ids: inscrits, -1 = bot maison non classé) et la met en file.
+static int tourn_launch(const int *ids, const Rules *rules) {
+    int n = tourn.table_size;
+    Table *t = pool_get(&table_pool);
+    if (!t) return 0;
+
+    for (int i = 0; i < n; i++) {
+        int id = ids[i];
+        Entrant *e = id >= 0 ? &tourn.entrants[id] : NULL;
+        Player *p = NULL;
+
+        if (e && !e->bot) {
+            pthread_mutex_lock(&tourn_lock);
+            p = tourn_lobby[id];
+            tourn_lobby[id] = NULL;
+            if (p) tourn_playing[id] = 1;
+            pthread_mutex_unlock(&tourn_lock);
+            if (!p) printf("[TOURNOI] %s absent: remplace par un bot %s\n", e->name, bot_strategy->name);
+        }
+
+        if (!p) {
+            p = pool_get(&seat_pool);
+            if (!p) {
+                for (int j = 0; j < i; j++) release_player(t->seats[j]);
+                pool_put(&table_pool, t);
+                return 0;
+            }
+            p->bot = e && e->bot ? e->bot : bot_strategy;
+            p->card = -1;
+            p->chosen_row = -1;
+            if (e) snprintf(p->name, sizeof(p->name), "%s", e->name);
+            else snprintf(p->name, sizeof(p->name), "maison-%d", i + 1);
+        }
+        p->entrant = e;
+        t->seats[i] = p;
+    }
+
+    pthread_mutex_lock(&game_id_lock);
+    t->game_id = ++global_game_id;
+    pthread_mutex_unlock(&game_id_lock);
+    t->nplayers = n;
+    t->rules = *rules;
+    t->tourn = &tourn;
+
+    pthread_mutex_lock(&job_lock);
+    t->next = NULL;
+    if (job_tail) job_tail->next = t;
+    else job_head = t;
+    job_tail = t;
+    jobs_pending++;
+    pthread_cond_signal(&job_ready);
+    pthread_mutex_unlock(&job_lock);
+    return 1;
+}
+
+// Écrit le classement dans logs/classement.txt.
+static void tourn_save_leaderboard(void) {
+    FILE *f = fopen("logs/classement.txt", "w");
+    if (!f) return;
+    tournament_leaderboard(&tourn, f);
+    fclose(f);
+}
+
+// Salon: un client inscrit déconnecté entre deux parties libère sa place
+// (il peut revenir sous le même pseudo, sinon un bot joue pour lui). Ce
+// qu'il envoie hors partie est ignoré. Renvoie le nombre de clients au salon.
+static int tourn_poll_lobby(void) {
+    int present = 0;
+    for (int id = 0; id < tourn.count; id++) {
+        pthread_mutex_lock(&tourn_lock);
+        Player *p = tourn_lobby[id];
+        if (p) {
+            tourn_lobby[id] = NULL;
+            tourn_playing[id] = 1;
+        }
+        pthread_mutex_unlock(&tourn_lock);
+        if (!p) continue;
+
+        char line[LINE_MAX];
+        int r;
+        while ((r = conn_recv_line_timed(p->conn, line, sizeof(line), 0)) > 0) {}
+
+        pthread_mutex_lock(&tourn_lock);
+        tourn_playing[id] = 0;
+        if (r < 0) tourn_lobby[id] = p;
+        pthread_mutex_unlock(&tourn_lock);
+        if (r < 0) {
+            present++;
+            continue;
+        }
+        printf("[TOURNOI] %s deconnecte du salon\n", p->name);
+        fflush(stdout);
+        release_player(p);
+    }
+    return present;
+}
 
+// Déroule le tournoi: attend les clients inscrits, lance les rondes, puis
+// affiche le classement final et prévient la boucle d'accueil, qui arrête
+// le serveur. Entre deux rondes on attend la fin des tables si les
+// appariements en dépendent (suisse) ou si des clients, qui ne jouent
+// qu'une table à la fois, sont inscrits; le salon est alors relevé.
+static void *tourn_thread(void *arg) {
+    const Rules *rules = arg;
+    int n = tourn.table_size;
+
+    for (int shown = -1;;) {
+        int present = tourn_poll_lobby();
+        if (present == tourn.clients) break;
+        if (present != shown) {
+            printf("[TOURNOI] En attente des clients inscrits (%d/%d)\n", present, tourn.clients);
+            fflush(stdout);
+            shown = present;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+        pthread_mutex_lock(&tourn_lock);
+        pthread_cond_timedwait(&tourn_cond, &tourn_lock, &ts);
+        pthread_mutex_unlock(&tourn_lock);
+    }
+
+    int barrier = tourn.mode == TOURNOI_SUISSE || tourn.clients > 0;
+    int ntables_max = (tourn.count + n - 1) / n;
+    int *seats = malloc(sizeof(int) * (size_t)(ntables_max * n));
+    if (!seats) die("malloc");
+
+    tourn.started = mono_now();
+    printf("[TOURNOI] Debut: %d inscrits, %d rondes, tables de %d\n", tourn.count, tourn.rounds, n);
+
+    for (int round = 1; round <= tourn.rounds; round++) {
+        pthread_mutex_lock(&tourn.lock);
+        tourn.round = round;
+        pthread_mutex_unlock(&tourn.lock);
+
+        if (barrier && tourn.clients > 0) tourn_poll_lobby();
+        int ntables = tournament_pairings(&tourn, round, seats);
+        for (int tb = 0; tb < ntables; tb++) {
+            if (!tourn_launch(&seats[tb * n], rules)) {
+                fprintf(stderr, "[TOURNOI] Memoire insuffisante, ronde %d interrompue\n", round);
+                break;
+            }
+        }
+        if (barrier) {
+            tourn_wait_jobs();
+            tourn_save_leaderboard();
+        }
+    }
+    tourn_wait_jobs();
+    free(seats);
+
+    tournament_leaderboard(&tourn, stdout);
+    tourn_save_leaderboard();
+    printf("[TOURNOI] Termine (classement dans logs/classement.txt)\n");
+    fflush(stdout);
+    tourn_over = 1;
+    accept_wakeup();
     return NULL;
 }
 
+// Arrêt en fin de tournoi: les clients du salon et de la file d'attente
+// sont prévenus et libérés, les parties de la file normale vont à leur
+// terme (comptes rendus des processus de parties compris).
+static void tourn_shutdown(void) {
+    while (atomic_load(&hellos_live) > 0) sleep_s(0.01);   // Accueils en cours (HELLO_TIMEOUT_MS au plus)
+
+    for (int id = 0; id < tourn.count; id++) {
+        pthread_mutex_lock(&tourn_lock);
+        Player *p = tourn_lobby[id];
+        tourn_lobby[id] = NULL;
+        pthread_mutex_unlock(&tourn_lock);
+        if (!p) continue;
+        conn_send_line(p->conn, "INFO Tournoi termine.");
+        conn_flush(p->conn, 100);
+        release_player(p);
+    }
+
+    pthread_mutex_lock(&waitq_lock);
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        Player *p;
+        while ((p = waitq_pop(&waitqs[v]))) {
+            conn_send_line(p->conn, "INFO Serveur arrete.");
+            conn_flush(p->conn, 100);
+            release_player(p);
+        }
+    }
+    pthread_mutex_unlock(&waitq_lock);
+
+    for (int shown = -1;;) {
+        int live = atomic_load(&games_local);
+        pthread_mutex_lock(&shard_lock);
+        for (int i = 0; i < nshards; i++)
+            if (shards[i].chan >= 0) live += shards[i].live;
+        pthread_mutex_unlock(&shard_lock);
+        if (!live) break;
+        if (live != shown) {
+            printf("[TOURNOI] Arret: %d partie(s) de la file normale en cours\n", live);
+            fflush(stdout);
+            shown = live;
+        }
+        fd_set rs;
+        FD_ZERO(&rs);
+        int maxfd = shard_fdset(&rs, -1);
+        struct timeval tv = { 0, 100000 };
+        if (select(maxfd + 1, &rs, NULL, NULL, &tv) > 0) shard_serve(&rs);
+    }
+}
+
+// Place un client inscrit au tournoi dans le salon. Renvoie 0 si le pseudo
+// n'est pas un inscrit client (il rejoint alors la file normale).
+static int tourn_admit(Conn *conn, const char *name, int caps, uint32_t addr) {
+    int id = tournament_find_client(&tourn, name);
+    if (id < 0) return 0;
+
+    pthread_mutex_lock(&tourn_lock);
+    if (tourn_lobby[id] || tourn_playing[id]) {
+        pthread_mutex_unlock(&tourn_lock);
+        conn_send_line(conn, "INFO Pseudo deja present dans le tournoi.");
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        return 1;
+    }
+
+    Player *p = pool_get(&seat_pool);
+    if (!p) {
+        pthread_mutex_unlock(&tourn_lock);
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        return 1;
+    }
+    p->conn = conn;
+    p->connected = 1;
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->caps = caps;
+    p->card = -1;
+    p->chosen_row = -1;
+    p->entrant = &tourn.entrants[id];
+    player_limits_reset(p, addr);
+    tourn_lobby[id] = p;
+    pthread_cond_broadcast(&tourn_cond);
+    pthread_mutex_unlock(&tourn_lock);
+
+    conn_send_line(conn, "INFO Inscrit au tournoi.");
+    printf("[TOURNOI] %s connecte\n", name);
+    return 1;
+}
+
+// Siège ouvert par une session multiplexée (JOINDRE): même file d'attente
+// que les connexions directes. 0 si le serveur est complet.
+static int mux_join(MuxSession *s, const char *name, int caps, int variant, uint32_t addr) {
+    WaitQueue *q = waitq_for(variant);
+    if (!q) return 0;
+    Conn *conn = pool_get(&conn_pool);
+    if (!conn) return 0;
+    if (!mux_chan_init(conn, s)) {
+        pool_put(&conn_pool, conn);
+        return 0;
+    }
+
+    Player *p = pool_get(&seat_pool);
+    pthread_mutex_lock(&waitq_lock);
+    if (!p || waitq_count >= waitq_max) {
+        pthread_mutex_unlock(&waitq_lock);
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        if (p) pool_put(&seat_pool, p);
+        return 0;
+    }
+    seat_enqueue(q, p, conn, name, caps, addr);
+    printf("Connexion: (%s) siege multiplexe (%s, en attente=%d)\n", name, q->rules.name, q->count);
+    Table *ready = NULL;
+    while (q->count >= seats_per_table)
+        if (!launch_table(q, seats_per_table, seats_per_table, &ready)) break;
+    int waiting = q->count;
+    pthread_mutex_unlock(&waitq_lock);
+    run_tables(ready);
+    if (waiting && bot_wait >= 0) accept_wakeup();
+    return 1;
+}
+
+// Connexion de session rendue au pool une fois ses sièges fermés.
+static void mux_release(Conn *sock) {
+    conn_close(sock);
+    pool_put(&conn_pool, sock);
+}
+
+static const MuxHooks mux_hooks = { mux_join, mux_release };
+
+// Attend une connexion entrante sur l'un des sockets d'écoute; complète la
+// table par des bots si le plus ancien joueur en attente, toutes files
+// confondues, a dépassé bot_wait secondes et traite au passage les comptes
+// rendus des processus de parties. Renvoie le socket prêt pour accept(), -1 sinon.
+static int wait_accept(const int *listen_fds, int nlisten, int nplayers) {
+    struct timeval tv, *tvp = NULL;
+    pthread_mutex_lock(&waitq_lock);
+    WaitQueue *q = NULL;
+    for (int v = 0; v < VARIANT_COUNT; v++)
+        if (waitqs[v].head && (!q || waitqs[v].head->since < q->head->since)) q = &waitqs[v];
+    if (bot_wait >= 0 && q) {
+        double left = q->head->since + bot_wait - mono_now();
+        if (left <= 0) {
+            Table *ready = NULL;
+            if (launch_table(q, q->count, nplayers, &ready)) {
+                pthread_mutex_unlock(&waitq_lock);
+                run_tables(ready);
+                return -1;
+            }
+            left = 1;   // Mémoire insuffisante: nouvel essai plus tard
+        }
+        tv.tv_sec = (time_t)left;
+        tv.tv_usec = (suseconds_t)((left - (double)tv.tv_sec) * 1e6);
+        tvp = &tv;
+    }
+    pthread_mutex_unlock(&waitq_lock);
+
+    fd_set rs;
+    int maxfd = -1;
+    FD_ZERO(&rs);
+    for (int i = 0; i < nlisten; i++) {
+        FD_SET(listen_fds[i], &rs);
+        if (listen_fds[i] > maxfd) maxfd = listen_fds[i];
+    }
+    maxfd = shard_fdset(&rs, maxfd);
+    if (select(maxfd + 1, &rs, NULL, NULL, tvp) <= 0) return -1;
+    shard_serve(&rs);
+    for (int i = 0; i < nlisten; i++)
+        if (FD_ISSET(listen_fds[i], &rs)) return listen_fds[i];
+    return -1;
+}
+
+// État publié au coordinateur de grappe chaque seconde.
+static void cluster_state(ClusterState *st) {
+    pthread_mutex_lock(&waitq_lock);
+    st->waiting = waitq_count;
+    st->free_places = waitq_max - waitq_count;
+    pthread_mutex_unlock(&waitq_lock);
+    st->games = (int)table_pool.in_use;
+    pthread_mutex_lock(&shard_lock);
+    for (int i = 0; i < nshards; i++) st->games += shards[i].live;
+    pthread_mutex_unlock(&shard_lock);
+}
+
+// Rapport de capacité: occupation des pools et coût mémoire d'une connexion
+// en attente et d'une partie, pour dimensionner un hôte.
+static void capacity_report(void) {
+    char line[256];
+    Pool *pools[] = { &conn_pool, &seat_pool, &table_pool };
+
+    pthread_mutex_lock(&waitq_lock);
+    int waiting = waitq_count;
+    pthread_mutex_unlock(&waitq_lock);
+
+    printf("Capacite: %d en attente (max %d)\n", waiting, waitq_max);
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        pool_report(pools[i], line, sizeof(line));
+        printf("  %s\n", line);
+    }
+    printf("  par connexion en attente: %zu o (connexion %zu + siege %zu), hors tampons noyau\n",
+           conn_pool.obj_size + seat_pool.obj_size, conn_pool.obj_size, seat_pool.obj_size);
+    printf("  par partie de %d joueurs: %zu o (table + sieges + connexions) + pile %d Ko\n",
+           seats_per_table,
+           table_pool.obj_size + (size_t)seats_per_table * (seat_pool.obj_size + conn_pool.obj_size),
+           GAME_STACK_SIZE / 1024);
+
+    ConnOutStats os;
+    conn_out_stats(&os);
+    printf("  files de sortie: %ld o en attente, %ld clients lents (%ld retablis), %ld debordements\n",
+           os.queued, os.slow, os.recovered, os.overflows);
+    printf("  sieges repris par un bot:");
+    for (int i = 0; i < HANDOVER_CAUSES; i++)
+        printf("%s %ld %s", i ? "," : "", (long)handovers[i], handover_why[i]);
+    printf("\n");
+    printf("  pairs morts: %ld sans reponse au PING, %ld detectes par TCP (%ld expirations), "
+           "%ld connexions sans pseudo\n",
+           (long)dead_ping, (long)dead_tcp, os.timeouts, (long)dead_hello);
+    printf("  limites de debit (%s): %ld lignes, %ld invalides, %ld connexions refusees; "
+           "%ld delais, %ld coups joues par le bot, %ld deconnexions\n",
+           penalty_name(rate_config.penalty), (long)rate_hits[RATE_LINES], (long)rate_hits[RATE_INVALID],
+           (long)rate_hits[RATE_CONNECTS], (long)rate_penalties[PENALTY_DELAY],
+           (long)rate_penalties[PENALTY_BOT], (long)rate_penalties[PENALTY_DISCONNECT]);
+    if (stats) {
+        uint64_t count, cap, full;
+        stats_usage(stats, &count, &cap, &full);
+        printf("  statistiques: %llu joueurs pour %llu places, %llu refus (table pleine)\n",
+               (unsigned long long)count, (unsigned long long)cap, (unsigned long long)full);
+    }
+    MuxStats ms;
+    mux_stats(&ms);
+    if (ms.sessions || ms.dropped)
+        printf("  sessions multiplexees: %ld, %ld sieges ouverts, %ld reponses perdues\n",
+               ms.sessions, ms.seats, ms.dropped);
+    if (uring_on) {
+        UringStats us;
+        uring_stats(&us);
+        printf("  io_uring: %ld appels systeme pour %ld completions (%ld accept, %ld receptions, "
+               "%ld envois), %ld reveils\n",
+               us.enters, us.accepts + us.recvs + us.sends + us.wakeups, us.accepts, us.recvs,
+               us.sends, us.wakeups);
+    }
+    if (cluster_on) printf("  grappe: %ld joueurs rediriges\n", cluster_redirects);
+    pthread_mutex_lock(&shard_lock);
+    for (int i = 0; i < nshards; i++)
+        printf("  processus de parties %d: pid %d, %d parties en cours, %ld terminees, %d relances\n",
+               i, (int)shards[i].pid, shards[i].live, shards[i].done, shards[i].restarts);
+    pthread_mutex_unlock(&shard_lock);
+    fflush(stdout);
+}
+
+// Thread dédié aux signaux de contrôle (bloqués dans tous les autres threads).
+// SIGUSR1: écrit la trace courante dans logs/trace_<n>.json.
+// SIGUSR2: affiche le rapport de capacité.
+static void *signal_thread(void *arg) {
+    sigset_t *sigs = arg;
+    int dumps = 0;
+
+    for (;;) {
+        int sig;
+        if (sigwait(sigs, &sig) != 0) continue;
+        if (sig == SIGUSR1) {
+            char path[64];
+            snprintf(path, sizeof(path), "logs/trace_%d.json", ++dumps);
+            int nev = trace_dump(path);
+            printf("Trace: %d evenements ecrits dans %s%s\n", nev, path,
+                   trace_enabled ? "" : " (trace desactivee, relancer avec -t)");
+            fflush(stdout);
+        } else if (sig == SIGUSR2) {
+            capacity_report();
+            if (tourn_active) tournament_leaderboard(&tourn, stdout);
+            fflush(stdout);
+        }
+    }
+    return NULL;
+}
+
+// Les signaux de contrôle sont traités par un seul thread (sigwait).
+static void start_signal_thread(void) {
+    static sigset_t ctl_sigs;
+    sigemptyset(&ctl_sigs);
+    sigaddset(&ctl_sigs, SIGUSR1);
+    sigaddset(&ctl_sigs, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &ctl_sigs, NULL);
+    pthread_t sig_tid;
+    if (pthread_create(&sig_tid, NULL, signal_thread, &ctl_sigs) == 0)
+        pthread_detach(sig_tid);
+}
+
+// Affiche la syntaxe de la ligne de commande du serveur.
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-v variante] [-s score_fin] [-b secondes] [-B strategie] [-p poids] [-Q tables]\n"
+            "          [-r tables] [-t] [-L] [-z] [-S Mo] [-P connexions] [-W attente_max]\n"
+            "          [-U socket_local] [-a socket_admin] [-J statistiques] [-O ms] [-R limites] [-F penalite]\n"
+            "          [-K inactivite/intervalle/sondes] [-H ping/delai] [-I posix|uring]\n"
+            "          [-w processus] [-C coordinateur:port [-A hote]]\n"
+            "          [-T inscrits [-M rondes|suisse] [-n rondes] [-j threads]]\n"
+            "          <port> <joueurs_par_partie>\n"
+            "  variantes: classique (defaut), pro, etendu, courtes; -v vaut pour les clients\n"
+            "     qui n'en demandent pas (+VARIANTE=<nom> apres le pseudo), une file par variante\n"
+            "  -b: complete la table par des bots apres ce delai d'attente\n"
+            "  -B: strategie des bots internes: petite, risque (defaut), table (avec -Q)\n"
+            "  -p: poids de la strategie risque (fichier ecrit par ./reglage)\n"
+            "  -Q: tables de la strategie table (fichier ecrit par ./tables, projete en memoire)\n"
+            "  -r: lance ce nombre de tables 100%% bots au demarrage (mode turbo)\n"
+            "  -t: active la trace des phases (kill -USR1 pour l'ecrire en JSON)\n"
+            "  -L: un fichier logs/partie_N.log par partie au lieu de l'archive\n"
+            "  -z: compresse les journaux archives (zlib)\n"
+            "  -S: taille maximale d'un segment d'archive en Mo (defaut 64)\n"
+            "  -P: connexions preallouees au demarrage (defaut 64; kill -USR2: rapport)\n"
+            "  -W: nombre maximal de joueurs en attente (defaut 256)\n"
+            "  -U: ecoute aussi sur ce socket local (clients unix:/chemin ou shm:/chemin)\n"
+            "  -a: socket d'administration (PARTIES, PARTIE <id>, JOUEUR <pseudo>, CLASSEMENT [n])\n"
+            "  -J: fichier des statistiques persistantes des joueurs (cree au besoin)\n"
+            "  -O: delai accorde a un client qui ne lit plus avant qu'un bot prenne son siege (defaut 2000)\n"
+            "  -R: debit/rafale par seconde: lignes et invalides par connexion (x%d par adresse),\n"
+            "      connexions par adresse; defaut lignes=100/200,invalides=2/5,connexions=5/20 (0: sans limite)\n"
+            "  -F: penalite au-dela: delai, bot (defaut: le bot joue le coup), deconnexion\n"
+            "  -K: keepalive TCP en secondes (defaut 10/5/3, 0: desactive)\n"
+            "  -H: PING aux clients +PING silencieux depuis ping s, mort sans reponse apres delai s\n"
+            "      (defaut 5/5, 0: jamais); le siege d'un pair mort est repris par un bot\n"
+            "  -I: moteur d'entrees-sorties TCP: posix (defaut) ou uring (io_uring, Linux >= 6.0)\n"
+            "  -w: processus de parties; le processus lance accepte et forme les tables\n"
+            "  -C: rejoint la grappe de ce coordinateur (redirige les joueurs si plein)\n"
+            "  -A: adresse annoncee aux joueurs rediriges vers ce serveur (defaut 127.0.0.1)\n"
+            "  -T: tournoi, une ligne bot:<strategie> [nom] ou client:<pseudo> par inscrit\n"
+            "  -M: appariements du tournoi: rondes (defaut) ou suisse\n"
+            "  -n: nombre de rondes (defaut: toutes les rencontres en rondes, 5 en suisse)\n"
+            "  -j: threads executant les tables du tournoi (defaut: nombre de coeurs)\n",
+            prog, RATE_ADDR_FACTOR);
+}
+
+// Connexion acceptée dont le pseudo est attendu par un thread d'accueil.
+typedef struct {
+    Conn *conn;
+    uint32_t addr;
+    int local;
+    char ip[INET_ADDRSTRLEN];
+} Hello;
+
+// Lit le pseudo dans HELLO_TIMEOUT_MS (toute la ligne), puis place la
+// connexion: session multiplexée, salon du tournoi, redirection de grappe
+// ou file d'attente de sa variante.
+static void hello_admit(Conn *conn, uint32_t addr, int local, const char *ip) {
+    TRACE_BEGIN(tr_hello, "accueil", 0, 0);
+    char hello[LINE_MAX];
+    char name[PLAYER_NAME_MAX];
+    int caps = 0, variant = -1;
+    int ok = conn_recv_line_timed(conn, hello, sizeof(hello), HELLO_TIMEOUT_MS);
+    // "SHM" + memfd: la suite (pseudo compris) passe par la mémoire partagée.
+    if (ok > 0 && local && strcmp(hello, SHM_HELLO) == 0)
+        ok = conn_attach_shm(conn) ? conn_recv_line_timed(conn, hello, sizeof(hello), HELLO_TIMEOUT_MS) : 0;
+    if (ok < 0) dead_hello++;
+    ok = ok > 0 && parse_hello(hello, name, sizeof(name), &caps, &variant);
+    TRACE_END(tr_hello);
+    if (!ok) {
+        printf("Connexion abandonnee avant envoi du pseudo (%s)\n", ip);
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        return;
+    }
+
+    // Règles demandées: une file par variante jouable à ce nombre de joueurs
+    WaitQueue *q = waitq_for(variant);
+    if (!q) {
+        printf("Connexion refusee: (%s) variante indisponible\n", name);
+        conn_send_line(conn, "ERREUR Variante indisponible sur ce serveur");
+        conn_flush(conn, 100);
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        return;
+    }
+
+    // Session multiplexée: les sièges arrivent ensuite par JOINDRE
+    if (caps & CAP_MUX) {
+        int ok_mux = !tourn_active && mux_session_start(conn, name, caps, variant, addr, &mux_hooks);
+        if (ok_mux) {
+            printf("Session multiplexee: (%s) depuis %s\n", name, ip);
+            fflush(stdout);
+            return;
+        }
+        conn_send_line(conn, tourn_active ? "ERREUR Sessions multiplexees indisponibles en tournoi"
+                                          : "ERREUR Session impossible");
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        return;
+    }
+
+    if (tourn_active && tourn_admit(conn, name, caps, addr)) return;
+
+    Player *p = pool_get(&seat_pool);
+    pthread_mutex_lock(&waitq_lock);
+
+    // Grappe: un nœud plein renvoie vers le nœud conseillé par le
+    // coordinateur; un joueur qui attendrait seul ici va compléter une
+    // table déjà entamée ailleurs.
+    int full = !p || waitq_count >= waitq_max;
+    ClusterTarget ct;
+    if (cluster_on && (full || waitq_count == 0) && cluster_target(&ct) && (full || ct.waiting > 0)) {
+        cluster_redirects++;
+        pthread_mutex_unlock(&waitq_lock);
+        char line[LINE_MAX];
+        snprintf(line, sizeof(line), REDIRECT_PREFIX "%s %s", ct.host, ct.port);
+        conn_send_line(conn, line);
+        printf("Redirection: (%s) vers %s:%s (%s)\n", name, ct.host, ct.port,
+               full ? "serveur complet" : "table en attente");
+        fflush(stdout);
+        conn_flush(conn, 100);
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        pool_put(&seat_pool, p);
+        return;
+    }
+
+    if (full) {
+        pthread_mutex_unlock(&waitq_lock);
+        conn_send_line(conn, "INFO Serveur complet. Reessayez plus tard.");
+        conn_close(conn);
+        pool_put(&conn_pool, conn);
+        pool_put(&seat_pool, p);
+        return;
+    }
+
+    seat_enqueue(q, p, conn, name, caps, addr);
+
+    PlayerStats ps;
+    if (stats && stats_lookup(stats, name, &ps))
+        printf("Connexion: (%s) depuis %s (%s, en attente=%d, elo %.0f en %llu parties)\n", name, ip,
+               q->rules.name, q->count, ps.rating, (unsigned long long)ps.games);
+    else
+        printf("Connexion: (%s) depuis %s (%s, en attente=%d)\n", name, ip, q->rules.name, q->count);
+
+    Table *ready = NULL;
+    while (q->count >= seats_per_table)
+        if (!launch_table(q, seats_per_table, seats_per_table, &ready)) break;
+    int waiting = q->count;
+
+    pthread_mutex_unlock(&waitq_lock);
+    run_tables(ready);
+    if (waiting && bot_wait >= 0) accept_wakeup();
+}
+
+static void *hello_thread(void *arg) {
+    Hello *h = arg;
+    trace_thread_name("accueil");
+    hello_admit(h->conn, h->addr, h->local, h->ip);
+    free(h);
+    atomic_fetch_sub(&hellos_live, 1);
+    return NULL;
+}
+
+// Confie une connexion acceptée à un thread d'accueil détaché; au-delà de
+// HELLO_THREADS_MAX accueils en cours, elle est refusée.
+static void hello_start(Conn *conn, uint32_t addr, int local, const char *ip) {
+    Hello *h = NULL;
+    if (atomic_fetch_add(&hellos_live, 1) < HELLO_THREADS_MAX) h = malloc(sizeof(*h));
+    if (h) {
+        h->conn = conn;
+        h->addr = addr;
+        h->local = local;
+        snprintf(h->ip, sizeof(h->ip), "%s", ip);
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, HELLO_STACK_SIZE);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t tid;
+        int ok = pthread_create(&tid, &attr, hello_thread, h) == 0;
+        pthread_attr_destroy(&attr);
+        if (ok) return;
+        free(h);
+    }
+    atomic_fetch_sub(&hellos_live, 1);
+    printf("Connexion refusee (%s): trop d'accueils en cours\n", ip);
+    conn_send_line(conn, "INFO Serveur complet. Reessayez plus tard.");
+    conn_close(conn);
+    pool_put(&conn_pool, conn);
+}
+
 // Point d'entrée du serveur: accepte les connexions et lance les parties.
 int main(int argc, char **argv) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <port> <joueurs_par_partie>\n", argv[0]);
+    Rules rules = *rules_get(VARIANT_CLASSIQUE);
+    int end_score = 0;
+    int bot_tables = 0;
+    int legacy_logs = 0;
+    int compress = 0;
+    int segment_mb = (int)(ARCHIVE_SEGMENT_MAX >> 20);
+    int prealloc = 64;
+    const char *unix_path = NULL;
+    const char *roster = NULL;
+    const char *coord = NULL;
+    const char *announce = "127.0.0.1";
+    const char *admin_path = NULL;
+    const char *stats_path = NULL;
+    TournamentMode tourn_mode = TOURNOI_RONDES;
+    int tourn_rounds = 0;
+    int tourn_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    bot_strategy = strategy_lookup("risque");
+
+    while ((opt = getopt(argc, argv, "v:s:b:B:p:Q:r:tLzS:P:W:U:a:J:O:R:F:K:H:I:w:C:A:T:M:n:j:")) != -1) {
+        switch (opt) {
+        case 'v':
+            if (!rules_lookup(optarg, &rules)) {
+                fprintf(stderr, "Variante inconnue: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            if (!parse_int(optarg, &end_score) || end_score <= 0) {
+                fprintf(stderr, "Score de fin invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'b':
+            if (!parse_int(optarg, &bot_wait) || bot_wait < 0) {
+                fprintf(stderr, "Delai d'attente invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'B':
+            if (!(bot_strategy = strategy_lookup(optarg))) {
+                fprintf(stderr, "Strategie inconnue: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'p':
+            if (!strategy_params_load(optarg, &strategy_params)) {
+                fprintf(stderr, "Fichier de poids invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'Q':
+            if (!(strategy_tables = policy_open(optarg))) {
+                fprintf(stderr, "Fichier de tables invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            trace_enabled = 1;
+            break;
+        case 'r':
+            if (!parse_int(optarg, &bot_tables) || bot_tables < 0) {
+                fprintf(stderr, "Nombre de tables invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'L':
+            legacy_logs = 1;
+            break;
+        case 'z':
+            compress = 1;
+            break;
+        case 'S':
+            if (!parse_int(optarg, &segment_mb) || segment_mb <= 0) {
+                fprintf(stderr, "Taille de segment invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'P':
+            if (!parse_int(optarg, &prealloc) || prealloc < 0) {
+                fprintf(stderr, "Nombre de connexions invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'U':
+            unix_path = optarg;
+            break;
+        case 'a':
+            admin_path = optarg;
+            break;
+        case 'J':
+            stats_path = optarg;
+            break;
+        case 'O':
+            if (!parse_int(optarg, &slow_grace_ms) || slow_grace_ms <= 0) {
+                fprintf(stderr, "Delai invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'R':
+            if (!rate_parse(optarg, &rate_config)) {
+                fprintf(stderr, "Limites invalides: %s (ex. lignes=10/20,invalides=2/5,connexions=5/20)\n",
+                        optarg);
+                return 1;
+            }
+            break;
+        case 'F':
+            if (!penalty_lookup(optarg, &rate_config.penalty)) {
+                fprintf(stderr, "Penalite inconnue: %s (delai, bot, deconnexion)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'K':
+            if (strcmp(optarg, "0") == 0) {
+                keepalive.idle_s = 0;
+            } else if (sscanf(optarg, "%d/%d/%d", &keepalive.idle_s, &keepalive.interval_s,
+                              &keepalive.count) != 3 ||
+                       keepalive.idle_s <= 0 || keepalive.interval_s <= 0 || keepalive.count <= 0) {
+                fprintf(stderr, "Keepalive invalide: %s (ex. 10/5/3)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'H': {
+            int ps = 0, ds = 0;
+            if (strcmp(optarg, "0") != 0 &&
+                (sscanf(optarg, "%d/%d", &ps, &ds) != 2 || ps <= 0 || ds <= 0)) {
+                fprintf(stderr, "Battements invalides: %s (ex. 5/5)\n", optarg);
+                return 1;
+            }
+            ping_ms = ps * 1000;
+            dead_ms = ds * 1000;
+            break;
+        }
+        case 'I':
+            if (strcmp(optarg, "uring") == 0) uring_on = 1;
+            else if (strcmp(optarg, "posix") != 0) {
+                fprintf(stderr, "Moteur d'entrees-sorties inconnu: %s (posix, uring)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            if (!parse_int(optarg, &nshards) || nshards < 0 || nshards > SHARD_MAX) {
+                fprintf(stderr, "Nombre de processus invalide: %s (max %d)\n", optarg, SHARD_MAX);
+                return 1;
+            }
+            break;
+        case 'C':
+            coord = optarg;
+            break;
+        case 'A':
+            announce = optarg;
+            break;
+        case 'T':
+            roster = optarg;
+            break;
+        case 'M':
+            if (strcmp(optarg, "rondes") == 0) tourn_mode = TOURNOI_RONDES;
+            else if (strcmp(optarg, "suisse") == 0) tourn_mode = TOURNOI_SUISSE;
+            else {
+                fprintf(stderr, "Appariement inconnu: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            if (!parse_int(optarg, &tourn_rounds) || tourn_rounds <= 0) {
+                fprintf(stderr, "Nombre de rondes invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'j':
+            if (!parse_int(optarg, &tourn_workers) || tourn_workers <= 0) {
+                fprintf(stderr, "Nombre de threads invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'W':
+            if (!parse_int(optarg, &waitq_max) || waitq_max <= 0) {
+                fprintf(stderr, "Taille de file d'attente invalide: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
         return 1;
     }
+    const char *port = argv[optind];
 
     signal(SIGPIPE, SIG_IGN);
 
-    int joueurs_par_partie = atoi(argv[2]);
-    if (joueurs_par_partie < 2 || joueurs_par_partie > MAX_PLAYERS)
-        die("Nombre de joueurs par partie invalide");
-
-    int listen_fd = tcp_listen(argv[1]);
-    if (listen_fd < 0) die("listen");
+    int joueurs_par_partie = atoi(argv[optind + 1]);
+    if (end_score) rules.end_score = end_score;
+    if (!rules_check(&rules, joueurs_par_partie)) {
+        fprintf(stderr, "Nombre de joueurs par partie invalide pour la variante %s (max %d)\n",
+                rules.name, rules.max_players);
+        return 1;
+    }
 
-    if (mkdir("logs", 0755) < 0 && errno != EEXIST) {
-        fprintf(stderr, "Erreur mkdir logs: %d\n", errno);
+    // Stratégie "table" sans tables: les bots joueraient "risque" sous le nom table
+    if (strcmp(bot_strategy->name, "table") == 0 && !strategy_tables) {
+        fprintf(stderr, "-B table demande un fichier de tables (-Q)\n");
         return 1;
     }
 
-    printf("Serveur: ecoute sur le port %s, joueurs_par_partie=%d\n",
-           argv[1], joueurs_par_partie);
+    // Tables calculées pour une autre configuration: utilisables, mais moins justes
+    if (strategy_tables && strcmp(bot_strategy->name, "table") == 0) {
+        const PolicyShape *ps = policy_shape(strategy_tables);
+        if (ps->row_max != rules.row_max)
+            fprintf(stderr, "Tables pour des rangees de %d cartes: strategie table remplacee par risque\n",
+                    ps->row_max);
+        else if (ps->nplayers != joueurs_par_partie || strcmp(ps->variant, rules.name) != 0)
+            fprintf(stderr, "Tables calculees pour %d joueurs (%s), parties a %d (%s)\n",
+                    ps->nplayers, ps->variant, joueurs_par_partie, rules.name);
+    }
 
-    while (1) {
-        struct sockaddr_in cli;
-        socklen_t len = sizeof(cli);
+    // Pools préalloués selon la configuration, puis agrandis par blocs.
+    seats_per_table = joueurs_par_partie;
 
-        int fd = accept(listen_fd, (struct sockaddr *)&cli, &len);
-        if (fd < 0) continue;
+    // Une file par variante; celles injouables à ce nombre de joueurs restent fermées.
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        waitqs[v].rules = *rules_get((Variant)v);
+        if (end_score) waitqs[v].rules.end_score = end_score;
+        waitqs[v].open = rules_check(&waitqs[v].rules, joueurs_par_partie);
+    }
+    default_queue = &waitqs[rules.id];
+    pool_init(&conn_pool, "connexions", sizeof(Conn), 256);
+    pool_init(&seat_pool, "sieges", sizeof(Player), 256);
+    pool_init(&table_pool, "parties", sizeof(Table), 16);
+    if (!pool_reserve(&conn_pool, (size_t)prealloc) ||
+        !pool_reserve(&seat_pool, (size_t)prealloc + (size_t)bot_tables * (size_t)joueurs_par_partie) ||
+        !pool_reserve(&table_pool, (size_t)(prealloc / joueurs_par_partie + bot_tables + 1))) {
+        fprintf(stderr, "Preallocation impossible (%d connexions)\n", prealloc);
+        return 1;
+    }
 
-        char ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
-        printf("Connexion TCP entrante depuis %s\n", ip);
-        fflush(stdout);
+    log_archived = !legacy_logs;
 
-        FILE *in = fdopen_r(fd);
-        FILE *out = fdopen_w(fd);
-        if (!in || !out) {
-            if (in) fclose(in);
-            if (out) fclose(out);
-            close(fd);
-            continue;
+    // Projeté en mémoire, partagé avec les processus de parties: rien à charger.
+    if (stats_path && !(stats = stats_open(stats_path, STATS_SLOTS_DEFAULT))) {
+        fprintf(stderr, "Statistiques inutilisables: %s (errno=%d)\n", stats_path, errno);
+        return 1;
+    }
+
+    // Processus de parties relancé par le frontal: pas d'écoute ni d'archive,
+    // mais son propre socket d'administration (<chemin>.<pid>).
+    if (getenv(SHARD_ENV)) {
+        shard_chan = SHARD_CHAN_FD;
+        start_signal_thread();
+        if (admin_path) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s.%d", admin_path, (int)getpid());
+            admin_on = live_admin_start(path, stats);
         }
+        return shard_worker();
+    }
 
-        char name[PLAYER_NAME_MAX];
-        if (!recv_line(in, name, sizeof(name))) {
-            printf("Connexion abandonnee avant envoi du pseudo (%s)\n", ip);
-            fclose(in);
-            fclose(out);
-            close(fd);
-            continue;
+    if (uring_on && nshards > 0) {
+        fprintf(stderr, "Les sockets io_uring ne passent pas aux processus de parties: -I uring sans -w\n");
+        return 1;
+    }
+
+    if (roster && nshards > 0) {
+        fprintf(stderr, "Le tournoi (-T) s'execute dans un seul processus: -w non disponible\n");
+        return 1;
+    }
+
+    if (roster) {
+        if (!tournament_load(&tourn, roster, joueurs_par_partie)) {
+            fprintf(stderr, "Liste d'inscrits invalide: %s\n", roster);
+            return 1;
         }
+        tourn.mode = tourn_mode;
+        tourn.rounds = tourn_rounds;
+        if (!tourn.rounds) {
+            int total = (tourn.count + joueurs_par_partie - 1) / joueurs_par_partie * joueurs_par_partie;
+            tourn.rounds = tourn_mode == TOURNOI_SUISSE ? 5 : total - 1;
+        }
+        tourn_lobby = calloc((size_t)tourn.count, sizeof(Player *));
+        tourn_playing = calloc((size_t)tourn.count, 1);
+        if (!tourn_lobby || !tourn_playing) die("calloc");
+        tourn_active = 1;
+    }
 
-        pthread_mutex_lock(&waitq_lock);
+    int listen_fds[3];
+    int nlisten = 0;
+    int listen_fd = tcp_listen(port);
+    if (listen_fd < 0) die("listen");
+    listen_fds[nlisten++] = listen_fd;
+
+    if (pipe(accept_wake) < 0) die("pipe");
+    for (int i = 0; i < 2; i++) fcntl(accept_wake[i], F_SETFL, fcntl(accept_wake[i], F_GETFL) | O_NONBLOCK);
+    listen_fds[nlisten++] = accept_wake[0];
+
+    // Socket local: mêmes lignes, sans pile TCP; sert aussi à passer la zone partagée.
+    int unix_fd = -1;
+    if (unix_path) {
+        unix_fd = unix_listen(unix_path);
+        if (unix_fd < 0) die("listen unix");
+        listen_fds[nlisten++] = unix_fd;
+    }
 
-        if (waitq_count >= (int)(sizeof(waitq) / sizeof(waitq[0]))) {
-            pthread_mutex_unlock(&waitq_lock);
-            send_line(out, "INFO Serveur complet. Reessayez plus tard.");
-            fclose(in);
-            fclose(out);
-            close(fd);
-            continue;
+    if (admin_path) {
+        if (!live_admin_start(admin_path, stats)) die("listen admin");
+        admin_on = 1;
+    }
+
+    if (mkdir("logs", 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Erreur mkdir logs: %d\n", errno);
+        return 1;
+    }
+
+    // Les ids reprennent après la dernière partie archivée: rien n'est écrasé.
+    if (!legacy_logs) {
+        archive = archive_open(ARCHIVE_DIR, (uint64_t)segment_mb << 20, compress);
+        if (!archive) {
+            fprintf(stderr, "Impossible d'ouvrir l'archive %s: %d\n", ARCHIVE_DIR, errno);
+            return 1;
         }
+        global_game_id = archive_last_id(archive);
+    }
 
-        waitq[waitq_count].fd = fd;
-        waitq[waitq_count].in = in;
-        waitq[waitq_count].out = out;
-        strncpy(waitq[waitq_count].name, name, PLAYER_NAME_MAX - 1);
-        waitq[waitq_count].name[PLAYER_NAME_MAX - 1] = 0;
-        waitq_count++;
+    printf("Serveur: ecoute sur le port %s, joueurs_par_partie=%d, variante=%s, score_fin=%d\n",
+           port, joueurs_par_partie, rules.name, rules.end_score);
+    printf("Serveur: variantes ouvertes:");
+    for (int v = 0; v < VARIANT_COUNT; v++)
+        if (waitqs[v].open) printf(" %s", waitqs[v].rules.name);
+    printf("\n");
+    if (unix_path) printf("Serveur: ecoute locale sur %s\n", unix_path);
+    if (admin_path)
+        printf("Serveur: administration sur %s%s\n", admin_path,
+               nshards ? " (et <chemin>.<pid> par processus de parties)" : "");
+
+    start_signal_thread();
+
+    // io_uring accepte lui-même (thread lancé après le masquage des signaux):
+    // la boucle d'accueil surveille sa file de connexions acceptées.
+    if (uring_on) {
+        if (uring_start(listen_fd)) {
+            listen_fds[0] = uring_accept_fd();
+            printf("Serveur: sockets TCP servis par io_uring\n");
+        } else {
+            fprintf(stderr, "io_uring indisponible (%s): moteur posix\n", strerror(errno));
+            uring_on = 0;
+        }
+    }
 
-        printf("Connexion: (%s) depuis %s (en attente=%d)\n", name, ip, waitq_count);
+    trace_thread_name("accept");
 
-        while (waitq_count >= joueurs_par_partie) {
-            pthread_mutex_lock(&game_id_lock);
-            int gid = ++global_game_id;
-            pthread_mutex_unlock(&game_id_lock);
+    if (tourn_active) {
+        static Rules tourn_rules;
+        tourn_rules = rules;
 
-            GameArgs *ga = malloc(sizeof(GameArgs));
-            if (!ga) break;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, GAME_STACK_SIZE);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t tid;
+        for (int i = 0; i < tourn_workers; i++)
+            if (pthread_create(&tid, &attr, tourn_worker, NULL) != 0) die("pthread_create");
+        pthread_attr_destroy(&attr);
 
-            ga->game_id = gid;
-            ga->nplayers = joueurs_par_partie;
+        if (pthread_create(&tid, NULL, tourn_thread, &tourn_rules) != 0) die("pthread_create");
+        pthread_detach(tid);
+    }
 
-            for (int i = 0; i < joueurs_par_partie; i++)
-                ga->wp[i] = waitq[i];
+    shard_argv = argv;
+    for (int i = 0; i < nshards; i++) shard_start(i);
 
-            for (int i = joueurs_par_partie; i < waitq_count; i++)
-                waitq[i - joueurs_par_partie] = waitq[i];
+    if (coord) {
+        if (!cluster_start(coord, announce, port, joueurs_par_partie, rules.name, rules.end_score, cluster_state)) {
+            fprintf(stderr, "Coordinateur invalide: %s (attendu hote:port)\n", coord);
+            return 1;
+        }
+        cluster_on = 1;
+    }
 
-            waitq_count -= joueurs_par_partie;
+    Table *ready = NULL;
+    pthread_mutex_lock(&waitq_lock);
+    for (int i = 0; i < bot_tables; i++)
+        launch_table(default_queue, 0, joueurs_par_partie, &ready);
+    pthread_mutex_unlock(&waitq_lock);
+    run_tables(ready);
 
-            printf("[PARTIE %d] Creation (%d joueurs). Reste en attente=%d\n",
-                   gid, joueurs_par_partie, waitq_count);
+    while (1) {
+        int lfd = wait_accept(listen_fds, nlisten, joueurs_par_partie);
+        if (lfd < 0) continue;
+        if (lfd == accept_wake[0]) {
+            char drain[64];
+            while (read(accept_wake[0], drain, sizeof(drain)) > 0) {}
+            if (tourn_over) break;
+            continue;
+        }
 
-            pthread_t tid;
-            if (pthread_create(&tid, NULL, game_thread, ga) == 0) {
-                pthread_detach(tid);
-            } else {
-                for (int i = 0; i < joueurs_par_partie; i++) {
-                    fclose(ga->wp[i].in);
-                    fclose(ga->wp[i].out);
-                    close(ga->wp[i].fd);
-                }
-                free(ga);
-            }
+        struct sockaddr_in cli;
+        socklen_t len = sizeof(cli);
+        int local = lfd == unix_fd;
+
+        TRACE_BEGIN(tr_accept, "accept", 0, 0);
+        int fd;
+        if (local) fd = accept(lfd, NULL, NULL);
+        else if (uring_on) fd = uring_accept_pop(&cli);
+        else fd = accept(lfd, (struct sockaddr *)&cli, &len);
+        TRACE_END(tr_accept);
+        if (fd < 0) continue;
+
+        // Tentatives de connexion par adresse: au-delà, refus immédiat et sans trace.
+        uint32_t addr = local ? 0 : ntohl(cli.sin_addr.s_addr);
+        if (!rate_addr_take(addr, RATE_CONNECTS, mono_now())) {
+            rate_hits[RATE_CONNECTS]++;
+            close(fd);
+            continue;
         }
 
-        pthread_mutex_unlock(&waitq_lock);
+        char ip[INET_ADDRSTRLEN];
+        if (local) {
+            snprintf(ip, sizeof(ip), "local");
+            printf("Connexion locale entrante\n");
+        } else {
+            inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
+            printf("Connexion TCP entrante depuis %s\n", ip);
+        }
+        fflush(stdout);
+
+        Conn *conn = pool_get(&conn_pool);
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        if (local) {
+            conn_init_unix(conn, fd);
+        } else if (uring_on && !uring_conn_init(conn, fd)) {
+            close(fd);
+            pool_put(&conn_pool, conn);
+            continue;
+        } else {
+            if (!uring_on) conn_init(conn, fd);
+            tcp_keepalive(fd, &keepalive);
+        }
+
+        // Pseudo attendu hors de la boucle d'accueil: un client lent ou muet
+        // ne retarde pas les suivants.
+        hello_start(conn, addr, local, ip);
     }
 
+    // Fin de tournoi: plus d'accueil, puis arrêt ordonné.
+    close(listen_fd);
+    if (unix_fd >= 0) {
+        close(unix_fd);
+        unlink(unix_path);
+    }
+    tourn_shutdown();
+    if (archive) archive_close(archive);
+    printf("Serveur: arret\n");
     return 0;
 }
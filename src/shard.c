@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+
+#include "headers/shard.h"
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#define SHARD_FDS_MAX (2 * MAX_PLAYERS)
+
+extern char **environ;
+
+// Envoie un message avec des descripteurs joints.
+static int send_msg(int chan, const void *buf, size_t len, const int *fds, int nfds) {
+    union {
+        struct cmsghdr h;
+        char b[CMSG_SPACE(sizeof(int) * SHARD_FDS_MAX)];
+    } ctl;
+    memset(&ctl, 0, sizeof(ctl));
+
+    struct iovec iov = { (void *)buf, len };
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    if (nfds > 0) {
+        m.msg_control = ctl.b;
+        m.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)nfds);
+        struct cmsghdr *h = CMSG_FIRSTHDR(&m);
+        h->cmsg_level = SOL_SOCKET;
+        h->cmsg_type = SCM_RIGHTS;
+        h->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)nfds);
+        memcpy(CMSG_DATA(h), fds, sizeof(int) * (size_t)nfds);
+    }
+
+    ssize_t w;
+    while ((w = sendmsg(chan, &m, MSG_NOSIGNAL)) < 0 && errno == EINTR) {}
+    return w == (ssize_t)len;
+}
+
+// Reçoit un message de min à len octets et ses descripteurs; renvoie sa
+// taille, 0 à la fermeture du canal, -1 pour un message invalide
+// (descripteurs alors refermés).
+static int recv_msg(int chan, void *buf, size_t min, size_t len, int *fds, int *nfds) {
+    union {
+        struct cmsghdr h;
+        char b[CMSG_SPACE(sizeof(int) * SHARD_FDS_MAX)];
+    } ctl;
+    struct iovec iov = { buf, len };
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    m.msg_control = ctl.b;
+    m.msg_controllen = sizeof(ctl.b);
+
+    ssize_t r;
+    while ((r = recvmsg(chan, &m, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {}
+    if (r == 0) return 0;
+
+    *nfds = 0;
+    for (struct cmsghdr *h = CMSG_FIRSTHDR(&m); r > 0 && h; h = CMSG_NXTHDR(&m, h)) {
+        if (h->cmsg_level != SOL_SOCKET || h->cmsg_type != SCM_RIGHTS) continue;
+        int n = (int)((h->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < n; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(h) + (size_t)i * sizeof(int), sizeof(fd));
+            if (*nfds < SHARD_FDS_MAX) fds[(*nfds)++] = fd;
+            else close(fd);
+        }
+    }
+
+    if (r < (ssize_t)min || (m.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        for (int i = 0; i < *nfds; i++) close(fds[i]);
+        *nfds = 0;
+        return -1;
+    }
+    return (int)r;
+}
+
+// Lance un processus de parties: le serveur est ré-exécuté avec les mêmes
+// arguments, le canal en SHARD_CHAN_FD et tous les autres descripteurs fermés
+// (sockets d'écoute et de clients restent au frontal).
+pid_t shard_spawn(char **argv, int *chan) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) return -1;
+
+    // L'environnement est préparé avant fork: seuls des appels sûrs suivent.
+    size_t n = 0;
+    while (environ[n]) n++;
+    char **envp = malloc((n + 2) * sizeof(char *));
+    char var[32];
+    if (!envp) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    snprintf(var, sizeof(var), "%s=%d", SHARD_ENV, SHARD_CHAN_FD);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+        if (strncmp(environ[i], SHARD_ENV "=", sizeof(SHARD_ENV)) != 0) envp[k++] = environ[i];
+    envp[k++] = var;
+    envp[k] = NULL;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // dup2 sur lui-même (sv[1] déjà en SHARD_CHAN_FD) garde FD_CLOEXEC: retiré ici
+        if (dup2(sv[1], SHARD_CHAN_FD) < 0 || fcntl(SHARD_CHAN_FD, F_SETFD, 0) < 0) _exit(127);
+        close_range(SHARD_CHAN_FD + 1, ~0U, 0);
+        execve("/proc/self/exe", argv, envp);
+        _exit(127);
+    }
+
+    free(envp);
+    close(sv[1]);
+    if (pid < 0) {
+        close(sv[0]);
+        return -1;
+    }
+    *chan = sv[0];
+    return pid;
+}
+
+// Frontal -> processus de parties: une table et les descripteurs de ses joueurs.
+int shard_send_table(int chan, const ShardTable *t, const int *fds, int nfds) {
+    return send_msg(chan, t, sizeof(*t), fds, nfds);
+}
+
+// Reçoit une table; 0 quand le frontal a fermé le canal.
+int shard_recv_table(int chan, ShardTable *t, int *fds, int *nfds) {
+    int r = recv_msg(chan, t, sizeof(*t), sizeof(*t), fds, nfds);
+    return r > 0 ? 1 : r;
+}
+
+// Processus de parties -> frontal: un morceau du journal d'une partie.
+int shard_send_log(int chan, int game_id, const char *log, size_t len) {
+    ShardReport d;
+    if (len > sizeof(d.log)) return 0;
+    d.kind = SHARD_LOG;
+    d.game_id = game_id;
+    d.aborted = 0;
+    d.started = d.ended = 0;
+    d.log_len = (uint32_t)len;
+    memcpy(d.log, log, len);
+    return send_msg(chan, &d, offsetof(ShardReport, log) + len, NULL, 0);
+}
+
+// Processus de parties -> frontal: fin de partie, après le dernier morceau.
+int shard_send_done(int chan, int game_id, int aborted, int64_t started, int64_t ended) {
+    ShardReport d;
+    d.kind = SHARD_DONE;
+    d.game_id = game_id;
+    d.aborted = aborted;
+    d.started = started;
+    d.ended = ended;
+    d.log_len = 0;
+    return send_msg(chan, &d, offsetof(ShardReport, log), NULL, 0);
+}
+
+// Reçoit un compte rendu (morceau de journal ou fin de partie); 0 quand le
+// processus de parties a disparu, -1 pour un message invalide.
+int shard_recv_report(int chan, ShardReport *d) {
+    int fds[SHARD_FDS_MAX];
+    int nfds;
+    int r = recv_msg(chan, d, offsetof(ShardReport, log), sizeof(*d), fds, &nfds);
+    if (r <= 0) return r;
+    for (int i = 0; i < nfds; i++) close(fds[i]);
+    if ((d->kind != SHARD_LOG && d->kind != SHARD_DONE) || d->log_len > sizeof(d->log) ||
+        (size_t)r != offsetof(ShardReport, log) + d->log_len)
+        return -1;
+    return 1;
+}
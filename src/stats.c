@@ -0,0 +1,277 @@
+#include "headers/stats.h"
+#include "headers/util.h"
+
+#include <math.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STATS_HEADER_SIZE 4096
+#define STATS_VERSION 1
+#define STATS_BUSY UINT64_MAX       // Entrée en cours de réservation
+#define STATS_DEAD (UINT64_MAX - 1) // Réservation abandonnée (processus mort): jamais réutilisée
+#define STATS_PROBE_MAX 4096        // Au-delà, la table est considérée pleine
+#define STATS_SPIN 1000             // Attente active, puis sched_yield
+#define STATS_BUSY_WAIT 1.0         // Secondes: une réservation vivante dure quelques ns
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t capacity;             // Puissance de deux
+    _Atomic uint64_t count;
+    _Atomic uint64_t full;         // Joueurs non enregistrés faute de place
+} StatsHeader;
+
+// Une entrée: empreinte et pseudo sur la première ligne de cache.
+typedef struct {
+    _Atomic uint64_t key;          // 0: libre
+    char name[PLAYER_NAME_MAX];
+    _Atomic uint64_t games;
+    _Atomic uint64_t wins;
+    _Atomic uint64_t bulls;
+    _Atomic int64_t rating_milli;  // Écart à STATS_ELO_START, en millièmes
+    _Atomic uint64_t resp_us;
+    _Atomic uint64_t resp_count;
+    _Atomic int64_t last_seen;
+    char pad[128 - 8 - PLAYER_NAME_MAX - 7 * 8];
+} StatsSlot;
+
+_Static_assert(sizeof(StatsSlot) == 128, "StatsSlot: deux lignes de cache");
+_Static_assert(sizeof(StatsHeader) <= STATS_HEADER_SIZE, "StatsHeader");
+
+struct StatsStore {
+    StatsHeader *hdr;
+    StatsSlot *slots;
+    uint64_t mask;
+    size_t map_size;
+};
+
+// Empreinte FNV-1a du pseudo, jamais 0, STATS_BUSY ni STATS_DEAD.
+static uint64_t name_key(const char *name) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    if (h == 0) h = 1;
+    if (h >= STATS_DEAD) h = STATS_DEAD - 1;
+    return h;
+}
+
+// En-tête d'un fichier neuf, écrit dans un fichier temporaire renommé ensuite:
+// un arrêt pendant la création ne laisse jamais un fichier sans en-tête.
+// Renvoie le descripteur du fichier en place, -1 en cas d'échec.
+static int stats_create(const char *path, uint64_t cap) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    StatsHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, STATS_MAGIC, 8);
+    h.version = STATS_VERSION;
+    h.slot_size = sizeof(StatsSlot);
+    h.capacity = cap;
+    if (ftruncate(fd, (off_t)(STATS_HEADER_SIZE + cap * sizeof(StatsSlot))) < 0 ||
+        pwrite(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || rename(tmp, path) < 0) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    return fd;
+}
+
+// Ouvre le fichier de statistiques, ou le crée avec slots entrées (arrondi
+// à une puissance de deux). Un fichier existant garde sa capacité.
+StatsStore *stats_open(const char *path, uint64_t slots) {
+    uint64_t cap = 1024;
+    while (cap < slots) cap <<= 1;
+
+    // Fichier vide: laissé par une version qui le créait en place, on le refait
+    int fd = open(path, O_RDWR);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size == 0) {
+        close(fd);
+        fd = -1;
+        errno = ENOENT;
+    }
+    if (fd < 0 && errno == ENOENT) fd = stats_create(path, cap);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) < 0) goto fail;
+
+    StatsHeader h;
+    if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        memcmp(h.magic, STATS_MAGIC, 8) != 0 || h.version != STATS_VERSION ||
+        h.slot_size != sizeof(StatsSlot) || !h.capacity || (h.capacity & (h.capacity - 1)) ||
+        (uint64_t)st.st_size != STATS_HEADER_SIZE + h.capacity * sizeof(StatsSlot)) {
+        errno = EINVAL;
+        goto fail;
+    }
+    cap = h.capacity;
+
+    size_t size = STATS_HEADER_SIZE + cap * sizeof(StatsSlot);
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) goto fail;
+    close(fd);
+
+    StatsStore *s = calloc(1, sizeof(*s));
+    if (!s) {
+        munmap(base, size);
+        return NULL;
+    }
+    s->hdr = base;
+    s->slots = (StatsSlot *)((char *)base + STATS_HEADER_SIZE);
+    s->mask = cap - 1;
+    s->map_size = size;
+    return s;
+
+fail:
+    close(fd);
+    return NULL;
+}
+
+// Détache la projection (les pages modifiées restent au noyau).
+void stats_close(StatsStore *s) {
+    if (!s) return;
+    msync(s->hdr, s->map_size, MS_ASYNC);
+    munmap(s->hdr, s->map_size);
+    free(s);
+}
+
+// Attend la fin d'une réservation concurrente (le pseudo est écrit dans
+// l'instant): passer outre pourrait inscrire le même pseudo plus loin. Une
+// réservation encore en cours après STATS_BUSY_WAIT vient d'un processus
+// mort avant d'inscrire son pseudo: l'entrée est marquée STATS_DEAD, et
+// l'ignorer ne crée pas de doublon.
+static uint64_t wait_reserved(StatsSlot *e) {
+    uint64_t k = atomic_load_explicit(&e->key, memory_order_acquire);
+    for (int spin = 0; k == STATS_BUSY && spin < STATS_SPIN; spin++)
+        k = atomic_load_explicit(&e->key, memory_order_acquire);
+    double limit = k == STATS_BUSY ? mono_now() + STATS_BUSY_WAIT : 0;
+    while (k == STATS_BUSY) {
+        if (mono_now() > limit) {
+            uint64_t busy = STATS_BUSY;
+            if (atomic_compare_exchange_strong(&e->key, &busy, STATS_DEAD)) return STATS_DEAD;
+            k = busy;
+            break;
+        }
+        sched_yield();
+        k = atomic_load_explicit(&e->key, memory_order_acquire);
+    }
+    return k;
+}
+
+// Entrée d'un pseudo, réservée au besoin si create. NULL si absent ou table pleine.
+static StatsSlot *find_slot(StatsStore *s, const char *name, int create) {
+    uint64_t key = name_key(name);
+    for (uint64_t i = 0; i <= s->mask && i < STATS_PROBE_MAX; i++) {
+        StatsSlot *e = &s->slots[(key + i) & s->mask];
+        uint64_t k = atomic_load_explicit(&e->key, memory_order_acquire);
+        if (k == 0) {
+            if (!create) return NULL;
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong(&e->key, &expected, STATS_BUSY)) {
+                snprintf(e->name, sizeof(e->name), "%s", name);
+                atomic_store_explicit(&e->key, key, memory_order_release);
+                atomic_fetch_add(&s->hdr->count, 1);
+                return e;
+            }
+            k = expected;
+        }
+        if (k == STATS_BUSY) k = wait_reserved(e);
+        if (k == key && strncmp(e->name, name, sizeof(e->name)) == 0) return e;
+    }
+    if (create) atomic_fetch_add(&s->hdr->full, 1);
+    return NULL;
+}
+
+// Cote Elo courante d'une entrée.
+static double slot_rating(StatsSlot *e) {
+    return STATS_ELO_START + (double)atomic_load(&e->rating_milli) / 1000.0;
+}
+
+// Recopie une entrée avec ses moyennes.
+static void slot_view(StatsSlot *e, PlayerStats *out) {
+    snprintf(out->name, sizeof(out->name), "%s", e->name);
+    out->games = atomic_load(&e->games);
+    out->wins = atomic_load(&e->wins);
+    out->bulls = atomic_load(&e->bulls);
+    out->avg_score = out->games ? (double)out->bulls / (double)out->games : 0;
+    out->rating = slot_rating(e);
+    uint64_t rc = atomic_load(&e->resp_count);
+    out->avg_resp_ms = rc ? (double)atomic_load(&e->resp_us) / 1000.0 / (double)rc : 0;
+    out->last_seen = atomic_load(&e->last_seen);
+}
+
+// Statistiques d'un pseudo; 0 s'il n'a jamais fini de partie.
+int stats_lookup(StatsStore *s, const char *name, PlayerStats *out) {
+    StatsSlot *e = find_slot(s, name, 0);
+    if (!e) return 0;
+    slot_view(e, out);
+    return 1;
+}
+
+// Enregistre une partie terminée: compteurs et Elo par paires des sièges
+// cotés (calculé sur les cotes d'avant la partie, les bots valent STATS_ELO_START).
+void stats_record_game(StatsStore *s, const StatsResult *r, int n) {
+    StatsSlot *e[MAX_PLAYERS];
+    double rating[MAX_PLAYERS];
+    for (int i = 0; i < n; i++) {
+        e[i] = r[i].rated ? find_slot(s, r[i].name, 1) : NULL;
+        rating[i] = e[i] ? slot_rating(e[i]) : STATS_ELO_START;
+    }
+
+    int64_t now = (int64_t)time(NULL);
+    for (int i = 0; i < n; i++) {
+        if (!e[i]) continue;
+        double delta = 0;
+        int better = 0;
+        for (int j = 0; j < n; j++) {
+            if (j == i) continue;
+            if (r[j].score < r[i].score) better++;
+            double sc = r[i].score < r[j].score ? 1.0 : r[i].score == r[j].score ? 0.5 : 0.0;
+            double ex = 1.0 / (1.0 + pow(10.0, (rating[j] - rating[i]) / 400.0));
+            delta += sc - ex;
+        }
+        if (n > 1) delta *= STATS_ELO_K / (n - 1);
+
+        atomic_fetch_add(&e[i]->games, 1);
+        if (better == 0) atomic_fetch_add(&e[i]->wins, 1);
+        atomic_fetch_add(&e[i]->bulls, (uint64_t)r[i].score);
+        atomic_fetch_add(&e[i]->rating_milli, (int64_t)(delta * 1000.0 + (delta >= 0 ? 0.5 : -0.5)));
+        atomic_fetch_add(&e[i]->resp_us, (uint64_t)(r[i].resp_sum * 1e6));
+        atomic_fetch_add(&e[i]->resp_count, (uint64_t)r[i].resp_count);
+        atomic_store(&e[i]->last_seen, now);
+    }
+}
+
+// Les n meilleurs Elo (parcours complet, pour le classement); renvoie leur nombre.
+int stats_top(StatsStore *s, PlayerStats *out, int n) {
+    if (n > STATS_TOP_MAX) n = STATS_TOP_MAX;
+    int count = 0;
+    for (uint64_t i = 0; i <= s->mask; i++) {
+        StatsSlot *e = &s->slots[i];
+        uint64_t k = atomic_load_explicit(&e->key, memory_order_acquire);
+        if (k == 0 || k >= STATS_DEAD || !atomic_load(&e->games)) continue;
+        double rt = slot_rating(e);
+        if (count == n && rt <= out[n - 1].rating) continue;
+
+        int pos = count < n ? count++ : n - 1;
+        while (pos > 0 && out[pos - 1].rating < rt) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        slot_view(e, &out[pos]);
+    }
+    return count;
+}
+
+// Occupation de la table, pour le rapport de capacité.
+void stats_usage(StatsStore *s, uint64_t *count, uint64_t *capacity, uint64_t *full) {
+    *count = atomic_load(&s->hdr->count);
+    *capacity = s->mask + 1;
+    *full = atomic_load(&s->hdr->full);
+}
@@ -0,0 +1,259 @@
+#include "headers/strategy.h"
+#include "headers/util.h"
+
+#include <stddef.h>
+
+const StrategyParams strategy_params_default = { 10000, 1, 5000, 1, 1, 10, 0 };
+StrategyParams strategy_params = { 10000, 1, 5000, 1, 1, 10, 0 };
+PolicyTables *strategy_tables;
+
+static const struct { const char *name; size_t off; } param_fields[STRATEGY_PARAMS_COUNT] = {
+    { "force", offsetof(StrategyParams, forced) },
+    { "force_boeufs", offsetof(StrategyParams, forced_bulls) },
+    { "pleine", offsetof(StrategyParams, full) },
+    { "pleine_boeufs", offsetof(StrategyParams, full_bulls) },
+    { "ecart", offsetof(StrategyParams, gap) },
+    { "longueur", offsetof(StrategyParams, len) },
+    { "ramasse_longueur", offsetof(StrategyParams, take_len) },
+};
+
+// Additionne les têtes de bœuf présentes dans une rangée.
+int row_bulls_local(const Row *r) {
+    int s = 0;
+    for (int i = 0; i < r->len; i++)
+        s += bulls(r->cards[i]);
+    return s;
+}
+
+// Renvoie la plus petite carte encore disponible dans la main.
+int choose_smallest_card(const int *hand, int hn) {
+    if (hn <= 0) return -1;
+    int m = hand[0];
+    for (int i = 1; i < hn; i++)
+        if (hand[i] < m)
+            m = hand[i];
+    return m;
+}
+
+// Cherche la rangée compatible la plus proche pour une carte donnée.
+static int best_row_for_card(Row rows[ROWS], int c) {
+    int best = -1;
+    int bestdiff = 0x7fffffff;
+
+    for (int r = 0; r < ROWS; r++) {
+        if (rows[r].len <= 0) continue;
+        int last = rows[r].cards[rows[r].len - 1];
+        if (c > last) {
+            int d = c - last;
+            if (d < bestdiff) { bestdiff = d; best = r; }
+        }
+    }
+    return best;
+}
+
+// Vrai si la carte est plus petite que toutes les fins de rangée (ramassage imposé).
+int card_takes_row(Row rows[ROWS], int c) {
+    return best_row_for_card(rows, c) < 0;
+}
+
+// Heuristique déterministe: carte au plus faible risque de ramassage.
+int choose_card_params(const StrategyParams *p, int *hand, int hn, Row rows[ROWS], int row_max) {
+    if (hn <= 0) return 1;
+
+    int bestc = hand[0];
+    double bestrisk = 0;
+
+    for (int i = 0; i < hn; i++) {
+        int c = hand[i];
+        int r = best_row_for_card(rows, c);
+        double risk;
+
+        if (r < 0) risk = p->forced + p->forced_bulls * bulls(c);
+        else {
+            int len = rows[r].len;
+            if (len == row_max) risk = p->full + p->full_bulls * row_bulls_local(&rows[r]);
+            else risk = p->gap * (c - rows[r].cards[len - 1]) + p->len * len;
+        }
+
+        if (i == 0 || risk < bestrisk) { bestrisk = risk; bestc = c; }
+    }
+    return bestc;
+}
+
+// Heuristique "risque" avec les poids courants (par défaut ou chargés).
+int choose_card_fallback(int *hand, int hn, Row rows[ROWS], int row_max) {
+    return choose_card_params(&strategy_params, hand, hn, rows, row_max);
+}
+
+// Rangée à ramasser: têtes de bœuf, moins un bonus pour vider une rangée
+// longue qui menacerait au tour suivant.
+int choose_row_params(const StrategyParams *p, Row rows[ROWS]) {
+    int best = 0;
+    double bestv = 0;
+    for (int r = 0; r < ROWS; r++) {
+        double v = row_bulls_local(&rows[r]) - p->take_len * rows[r].len;
+        if (r == 0 || v < bestv) {
+            bestv = v;
+            best = r;
+        }
+    }
+    return best;
+}
+
+int choose_row_fallback(Row rows[ROWS]) {
+    return choose_row_params(&strategy_params, rows);
+}
+
+// Rangée à ramasser d'après les tables (-1 si une rangée en sort) et sa valeur.
+static int table_pick(const PolicyTables *t, Row rows[ROWS], double *value) {
+    int best = -1;
+    for (int r = 0; r < ROWS; r++) {
+        double v = policy_pick(t, rows[r].len, row_bulls_local(&rows[r]));
+        if (v < 0) return -1;
+        if (best < 0 || v < *value) {
+            *value = v;
+            best = r;
+        }
+    }
+    return best;
+}
+
+// Stratégie "table": chaque carte coûte l'espérance tabulée de sa pose, ou
+// la meilleure rangée à ramasser si elle en impose une. Sans tables, ou
+// hors de leurs dimensions (autre variante), heuristique "risque".
+int choose_card_table(int *hand, int hn, Row rows[ROWS], int row_max) {
+    const PolicyTables *t = strategy_tables;
+    if (hn <= 0) return 1;
+    if (!t || policy_shape(t)->row_max != row_max) return choose_card_fallback(hand, hn, rows, row_max);
+
+    int bestc = hand[0];
+    double bestcost = 0;
+    for (int i = 0; i < hn; i++) {
+        int c = hand[i];
+        int r = best_row_for_card(rows, c);
+        double cost;
+        if (r < 0) {
+            if (table_pick(t, rows, &cost) < 0) cost = -1;
+        } else {
+            const Row *row = &rows[r];
+            cost = policy_place(t, hn, row->len, c - row->cards[row->len - 1], row_bulls_local(row));
+        }
+        if (cost < 0) return choose_card_fallback(hand, hn, rows, row_max);
+        if (i == 0 || cost < bestcost) {
+            bestcost = cost;
+            bestc = c;
+        }
+    }
+    return bestc;
+}
+
+int choose_row_table(Row rows[ROWS]) {
+    double v;
+    int r = strategy_tables ? table_pick(strategy_tables, rows, &v) : -1;
+    return r < 0 ? choose_row_fallback(rows) : r;
+}
+
+// Choisit la rangée la moins pénalisante lorsqu'on doit ramasser.
+int choose_row_min_bulls(Row rows[ROWS]) {
+    int best = 0;
+    int bestv = row_bulls_local(&rows[0]);
+    for (int r = 1; r < ROWS; r++) {
+        int v = row_bulls_local(&rows[r]);
+        if (v < bestv) {
+            bestv = v;
+            best = r;
+        }
+    }
+    return best;
+}
+
+// Stratégie de robot.c: toujours la plus petite carte.
+static int card_smallest(int *hand, int hn, Row rows[ROWS], int row_max) {
+    (void)rows;
+    (void)row_max;
+    return choose_smallest_card(hand, hn);
+}
+
+static const Strategy strategies[] = {
+    { "petite", card_smallest, choose_row_min_bulls },
+    { "risque", choose_card_fallback, choose_row_fallback },
+    { "table", choose_card_table, choose_row_table },
+};
+
+// Recherche une stratégie par son nom (NULL si inconnue).
+const Strategy *strategy_lookup(const char *name) {
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++)
+        if (strcmp(strategies[i].name, name) == 0)
+            return &strategies[i];
+    return NULL;
+}
+
+// Accès au i-ème poids et à son nom dans le fichier (NULL au-delà).
+double *strategy_param(StrategyParams *p, int i, const char **name) {
+    if (i < 0 || i >= STRATEGY_PARAMS_COUNT) return NULL;
+    if (name) *name = param_fields[i].name;
+    return (double *)((char *)p + param_fields[i].off);
+}
+
+// Lit un fichier "cle valeur" (# commente); les clés absentes gardent leur valeur.
+int strategy_params_load(const char *path, StrategyParams *p) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    StrategyParams tmp = *p;
+    char line[256];
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), f)) {
+        trim_crlf(line);
+        char key[64];
+        double v;
+        if (line[0] == '#' || line[0] == 0) continue;
+        ok = sscanf(line, "%63s %lf", key, &v) == 2;
+        int found = 0;
+        for (int i = 0; ok && i < STRATEGY_PARAMS_COUNT; i++) {
+            const char *name;
+            double *d = strategy_param(&tmp, i, &name);
+            if (strcmp(name, key) == 0) {
+                *d = v;
+                found = 1;
+            }
+        }
+        ok = ok && found;
+    }
+    fclose(f);
+    if (ok) *p = tmp;
+    return ok;
+}
+
+// Écrit les poids au format relu par strategy_params_load.
+int strategy_params_save(const char *path, const StrategyParams *p, const char *comment) {
+    FILE *f = fopen(path, "w");
+    if (!f) return 0;
+    if (comment) fprintf(f, "# %s\n", comment);
+    StrategyParams tmp = *p;
+    for (int i = 0; i < STRATEGY_PARAMS_COUNT; i++) {
+        const char *name;
+        double *d = strategy_param(&tmp, i, &name);
+        fprintf(f, "%s %.6g\n", name, *d);
+    }
+    return fclose(f) == 0;
+}
+
+// Charge les poids désignés par SIXQP_PARAMS, s'il est défini; 0 si le fichier est illisible.
+int strategy_params_from_env(void) {
+    const char *path = getenv(STRATEGY_PARAMS_ENV);
+    if (!path || !*path) return 1;
+    if (!strategy_params_load(path, &strategy_params)) return 0;
+    fprintf(stderr, "Poids de strategie charges depuis %s\n", path);
+    return 1;
+}
+
+// Projette les tables désignées par SIXQP_TABLES, s'il est défini; 0 si le fichier est invalide.
+int strategy_tables_from_env(void) {
+    const char *path = getenv(STRATEGY_TABLES_ENV);
+    if (!path || !*path) return 1;
+    if (!(strategy_tables = policy_open(path))) return 0;
+    const PolicyShape *s = policy_shape(strategy_tables);
+    fprintf(stderr, "Tables de strategie chargees depuis %s (%s, %d joueurs)\n", path, s->variant, s->nplayers);
+    return 1;
+}
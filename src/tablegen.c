@@ -0,0 +1,343 @@
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/game.h"
+#include "headers/strategy.h"
+#include "headers/policy.h"
+
+/*
+ * Génération des tables de la stratégie "table" (policy.h). Chaque joueur
+ * des parties simulées suit l'heuristique "risque" aux poids par défaut,
+ * mais joue une carte ou prend une rangée au hasard avec la probabilité
+ * -e, pour que toutes les situations soient vues. Chaque pose et chaque
+ * rangée ramassée alimente sa case. Une case peu vue est tirée vers une
+ * estimation plus grossière: la probabilité de ramasser de la même pose,
+ * toutes têtes confondues, multipliée par les têtes de la rangée.
+ * Les parties sont réparties sur tous les coeurs.
+ * Usage: ./tables [-n parties] [-j threads] [-J joueurs] [-v variante]
+ *                 [-e exploration] [-s graine] [-o fichier]
+ */
+
+#define BLOCK_GAMES 1000
+#define SHRINK 20.0                // Poids de l'estimation grossière, en observations
+
+// Observations d'une case de pose.
+typedef struct {
+    double sum;                    // Têtes ramassées
+    double rowb_taken;             // Têtes de la rangée visée, quand elle a été ramassée
+    uint64_t count;
+    uint64_t takes;
+} PlaceAcc;
+
+typedef struct {
+    double sum;
+    uint64_t count;
+} PickAcc;
+
+static Rules rules;
+static PolicyShape shape;
+static int nplayers = 4;
+static double explore = 0.2;
+static uint64_t seed0;
+static long ngames;
+static long next_block;
+static size_t nplace, npick;
+static PlaceAcc *place_acc;        // Totaux fusionnés des threads
+static PickAcc *pick_acc;
+static pthread_mutex_t acc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+static int rng_chance(uint64_t *s, double p) {
+    return (double)(rng_next(s) >> 11) / 9007199254740992.0 < p;
+}
+
+// Rangée où irait c (-1: ramassage imposé).
+static int target_row(const Row rows[ROWS], int c) {
+    int best = -1;
+    for (int r = 0; r < ROWS; r++) {
+        int last = rows[r].cards[rows[r].len - 1];
+        if (c > last && (best < 0 || last > rows[best].cards[rows[best].len - 1])) best = r;
+    }
+    return best;
+}
+
+// Joue une partie et comptabilise ses poses et ses ramassages.
+static void play_game(PlaceAcc *pa, PickAcc *ka, uint64_t seed) {
+    const StrategyParams *p = &strategy_params_default;
+    int n = nplayers;
+    uint64_t rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+    Game g;
+    game_init_rules(&g, n, &rules);
+    game_reseed(&g, seed);
+    game_setup_rows(&g);
+    game_deal(&g);
+
+    long pending[MAX_PLAYERS];     // Rangée prise au tour précédent: case et têtes
+    int pending_bulls[MAX_PLAYERS];
+    for (int i = 0; i < n; i++) pending[i] = -1;
+
+    while (!game_over(&g, rules.end_score)) {
+        long cell[MAX_PLAYERS];
+        int rowb[MAX_PLAYERS];
+        for (int i = 0; i < n; i++) {
+            int hn = g.hand_len[i];
+            int c = rng_chance(&rng, explore) ? g.hands[i][rng_next(&rng) % (uint64_t)hn]
+                                              : choose_card_params(p, g.hands[i], hn, g.rows, rules.row_max);
+            int r = target_row(g.rows, c);
+            cell[i] = -1;
+            if (r >= 0) {
+                const Row *row = &g.rows[r];
+                rowb[i] = row_bulls_local(row);
+                cell[i] = (long)policy_place_index(&shape, hn, row->len, c - row->cards[row->len - 1], rowb[i]);
+            }
+            game_hand_remove(&g, i, c);
+            g.carte_jouee[i] = c;
+        }
+
+        int order[MAX_PLAYERS];
+        for (int i = 0; i < n; i++) order[i] = i;
+        for (int i = 1; i < n; i++)
+            for (int j = i; j > 0 && g.carte_jouee[order[j]] < g.carte_jouee[order[j - 1]]; j--) {
+                int t = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = t;
+            }
+
+        int turn_bulls[MAX_PLAYERS] = { 0 };
+        long picked[MAX_PLAYERS];
+        int picked_bulls[MAX_PLAYERS];
+        for (int k = 0; k < n; k++) {
+            int pid = order[k];
+            int c = g.carte_jouee[pid];
+            int chosen = -1, taken, b;
+            picked[pid] = -1;
+            if (card_takes_row(g.rows, c)) {
+                chosen = rng_chance(&rng, explore) ? (int)(rng_next(&rng) % ROWS) : choose_row_params(p, g.rows);
+                const Row *row = &g.rows[chosen];
+                picked[pid] = (long)policy_pick_index(&shape, row->len, row_bulls_local(row));
+            }
+            game_place_card(&g, pid, c, chosen, &taken, &b);
+            turn_bulls[pid] += b;
+            if (picked[pid] >= 0) {
+                picked_bulls[pid] = b;
+            } else if (cell[pid] >= 0) {
+                PlaceAcc *a = &pa[cell[pid]];
+                a->count++;
+                a->sum += b;
+                if (b > 0) {
+                    a->takes++;
+                    a->rowb_taken += rowb[pid];
+                }
+            }
+        }
+
+        // Valeur d'une rangée prise: ses têtes plus celles du tour suivant
+        for (int i = 0; i < n; i++) {
+            if (pending[i] >= 0) {
+                ka[pending[i]].count++;
+                ka[pending[i]].sum += pending_bulls[i] + turn_bulls[i];
+            }
+            pending[i] = picked[i];
+            pending_bulls[i] = picked[i] >= 0 ? picked_bulls[i] : 0;
+        }
+
+        g.tour++;
+        if (g.tour > rules.hand_size) {
+            for (int i = 0; i < n; i++) {
+                if (pending[i] >= 0) {
+                    ka[pending[i]].count++;
+                    ka[pending[i]].sum += pending_bulls[i];
+                }
+                pending[i] = -1;
+            }
+            game_next_manche(&g);
+        }
+    }
+}
+
+// Thread de simulation: blocs de parties jusqu'à épuisement, puis fusion.
+static void *sim_thread(void *arg) {
+    (void)arg;
+    PlaceAcc *pa = calloc(nplace, sizeof(*pa));
+    PickAcc *ka = calloc(npick, sizeof(*ka));
+    if (!pa || !ka) die("calloc");
+
+    for (;;) {
+        pthread_mutex_lock(&acc_lock);
+        long block = next_block++;
+        pthread_mutex_unlock(&acc_lock);
+        long first = block * BLOCK_GAMES;
+        if (first >= ngames) break;
+        long last = first + BLOCK_GAMES < ngames ? first + BLOCK_GAMES : ngames;
+        for (long i = first; i < last; i++) play_game(pa, ka, seed0 + (uint64_t)i);
+    }
+
+    pthread_mutex_lock(&acc_lock);
+    for (size_t i = 0; i < nplace; i++) {
+        place_acc[i].sum += pa[i].sum;
+        place_acc[i].rowb_taken += pa[i].rowb_taken;
+        place_acc[i].count += pa[i].count;
+        place_acc[i].takes += pa[i].takes;
+    }
+    for (size_t i = 0; i < npick; i++) {
+        pick_acc[i].sum += ka[i].sum;
+        pick_acc[i].count += ka[i].count;
+    }
+    pthread_mutex_unlock(&acc_lock);
+    free(pa);
+    free(ka);
+    return NULL;
+}
+
+static uint16_t to_fixed(double v) {
+    v = v * POLICY_SCALE + 0.5;
+    if (v < 0) return 0;
+    return v > 65535 ? 65535 : (uint16_t)v;
+}
+
+// Espérances lissées de place[]: la probabilité de ramasser et le surplus
+// de têtes (cartes posées entre-temps) viennent de la case toutes têtes
+// confondues, ou à défaut de la même pose toutes mains confondues.
+static void finish_place(uint16_t *out, long *seen) {
+    int nb = POLICY_BULLS_MAX + 1;
+    *seen = 0;
+    for (int len = 1; len <= shape.row_max; len++)
+        for (int gap = 1; gap <= shape.gap_max; gap++) {
+            PlaceAcc wide = { 0 };
+            for (int hn = 1; hn <= shape.hand_size; hn++)
+                for (int b = 0; b < nb; b++) {
+                    const PlaceAcc *a = &place_acc[policy_place_index(&shape, hn, len, gap, b)];
+                    wide.count += a->count;
+                    wide.takes += a->takes;
+                    wide.sum += a->sum;
+                    wide.rowb_taken += a->rowb_taken;
+                }
+
+            for (int hn = 1; hn <= shape.hand_size; hn++) {
+                PlaceAcc coarse = { 0 };
+                size_t base = policy_place_index(&shape, hn, len, gap, 0);
+                for (int b = 0; b < nb; b++) {
+                    const PlaceAcc *a = &place_acc[base + (size_t)b];
+                    coarse.count += a->count;
+                    coarse.takes += a->takes;
+                    coarse.sum += a->sum;
+                    coarse.rowb_taken += a->rowb_taken;
+                }
+                const PlaceAcc *ref = coarse.count >= SHRINK || !wide.count ? &coarse : &wide;
+                double ptake = ref->count ? (double)ref->takes / ref->count : 0;
+                double extra = ref->takes ? (ref->sum - ref->rowb_taken) / ref->takes : 0;
+
+                for (int b = 0; b < nb; b++) {
+                    const PlaceAcc *a = &place_acc[base + (size_t)b];
+                    double prior = ptake * (b + extra);
+                    out[base + (size_t)b] = to_fixed((a->sum + SHRINK * prior) / (a->count + SHRINK));
+                    *seen += a->count > 0;
+                }
+            }
+        }
+}
+
+// Valeurs lissées de pick[]: a priori, les têtes de la rangée plus le
+// surplus moyen du tour suivant pour cette longueur.
+static void finish_pick(uint16_t *out, long *seen) {
+    int nb = POLICY_BULLS_MAX + 1;
+    *seen = 0;
+    for (int len = 1; len <= shape.row_max; len++) {
+        double extra_sum = 0;
+        long extra_n = 0;
+        for (int b = 0; b < nb; b++) {
+            const PickAcc *a = &pick_acc[policy_pick_index(&shape, len, b)];
+            extra_sum += a->sum - (double)b * a->count;
+            extra_n += a->count;
+        }
+        double extra = extra_n ? extra_sum / extra_n : 0;
+        for (int b = 0; b < nb; b++) {
+            size_t i = policy_pick_index(&shape, len, b);
+            out[i] = to_fixed((pick_acc[i].sum + SHRINK * (b + extra)) / (pick_acc[i].count + SHRINK));
+            *seen += pick_acc[i].count > 0;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int seed = 1;
+    int games = 200000;
+    const char *outfile = "strategie.tables";
+    int opt;
+
+    rules = *rules_get(VARIANT_CLASSIQUE);
+
+    while ((opt = getopt(argc, argv, "n:j:J:v:e:s:o:")) != -1) {
+        int ok = 1;
+        switch (opt) {
+        case 'n': ok = parse_int(optarg, &games) && games > 0; break;
+        case 'j': ok = parse_int(optarg, &nthreads) && nthreads > 0; break;
+        case 'J': ok = parse_int(optarg, &nplayers) && nplayers >= MIN_PLAYERS && nplayers <= MAX_PLAYERS; break;
+        case 'v': ok = rules_lookup(optarg, &rules); break;
+        case 'e': explore = atof(optarg); ok = explore >= 0 && explore <= 1; break;
+        case 's': ok = parse_int(optarg, &seed); break;
+        case 'o': outfile = optarg; break;
+        default: ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr,
+                    "Usage: %s [-n parties] [-j threads] [-J joueurs] [-v variante]\n"
+                    "          [-e exploration 0..1] [-s graine] [-o fichier]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (!rules_check(&rules, nplayers)) {
+        fprintf(stderr, "Nombre de joueurs invalide pour la variante %s\n", rules.name);
+        return 1;
+    }
+
+    Game probe;
+    game_init_rules(&probe, nplayers, &rules);
+    shape.nplayers = nplayers;
+    shape.row_max = rules.row_max;
+    shape.hand_size = rules.hand_size;
+    shape.gap_max = probe.deck_len - 1;
+    snprintf(shape.variant, sizeof(shape.variant), "%s", rules.name);
+
+    ngames = games;
+    seed0 = (uint64_t)(unsigned)seed * 1000003ULL;
+    nplace = policy_place_cells(&shape);
+    npick = policy_pick_cells(&shape);
+    place_acc = calloc(nplace, sizeof(*place_acc));
+    pick_acc = calloc(npick, sizeof(*pick_acc));
+    uint16_t *place = malloc(nplace * sizeof(uint16_t));
+    uint16_t *pick = malloc(npick * sizeof(uint16_t));
+    if (!place_acc || !pick_acc || !place || !pick) die("malloc");
+
+    printf("tables: %d parties, %d joueurs, variante %s, exploration %.2f, %d threads\n",
+           games, nplayers, rules.name, explore, nthreads);
+    double t0 = mono_now();
+
+    pthread_t tids[256];
+    int started = 0;
+    for (int i = 0; i < nthreads && i < 256; i++)
+        if (pthread_create(&tids[started], NULL, sim_thread, NULL) == 0) started++;
+    if (!started) sim_thread(NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+    long poses = 0, picks = 0, seen_place, seen_pick;
+    for (size_t i = 0; i < nplace; i++) poses += place_acc[i].count;
+    for (size_t i = 0; i < npick; i++) picks += pick_acc[i].count;
+    finish_place(place, &seen_place);
+    finish_pick(pick, &seen_pick);
+
+    printf("%ld poses (%ld/%zu cases vues), %ld rangees prises (%ld/%zu cases vues) en %.1f s\n",
+           poses, seen_place, nplace, picks, seen_pick, npick, mono_now() - t0);
+
+    if (!policy_write(outfile, &shape, (uint64_t)games, place, pick)) die("ecriture des tables");
+    printf("Tables ecrites dans %s (%zu cases)\n", outfile, nplace + npick);
+    return 0;
+}
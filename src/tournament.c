@@ -0,0 +1,315 @@
+#include "headers/tournament.h"
+#include "headers/util.h"
+
+#include <math.h>
+
+// Ajoute un inscrit; le tableau grandit par doublement.
+static int add_entrant(Tournament *t, int *cap, const char *name, const Strategy *bot) {
+    if (t->count == *cap) {
+        int ncap = *cap ? *cap * 2 : 16;
+        Entrant *e = realloc(t->entrants, sizeof(Entrant) * (size_t)ncap);
+        if (!e) return 0;
+        t->entrants = e;
+        *cap = ncap;
+    }
+    Entrant *e = &t->entrants[t->count++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->bot = bot;
+    e->rating = TOURNAMENT_ELO_START;
+    if (!bot) t->clients++;
+    return 1;
+}
+
+// Lit la liste des inscrits: une ligne "bot:<strategie> [nom]" ou
+// "client:<pseudo>" par participant, '#' pour les commentaires.
+int tournament_load(Tournament *t, const char *path, int table_size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    memset(t, 0, sizeof(*t));
+    t->table_size = table_size;
+    pthread_mutex_init(&t->lock, NULL);
+
+    int cap = 0, ok = 1, lineno = 0;
+    char line[LINE_MAX];
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineno++;
+        trim_crlf(line);
+        char kind[64], arg[PLAYER_NAME_MAX], name[PLAYER_NAME_MAX];
+        name[0] = 0;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p || *p == '#') continue;
+
+        if (sscanf(p, "%63[^:]:%31s %31s", kind, arg, name) < 2) {
+            fprintf(stderr, "%s:%d: entree invalide: %s\n", path, lineno, p);
+            ok = 0;
+        } else if (strcmp(kind, "bot") == 0) {
+            const Strategy *s = strategy_lookup(arg);
+            if (!s) {
+                fprintf(stderr, "%s:%d: strategie inconnue: %s\n", path, lineno, arg);
+                ok = 0;
+            } else if (strcmp(s->name, "table") == 0 && !strategy_tables) {
+                fprintf(stderr, "%s:%d: strategie table sans fichier de tables (-Q)\n", path, lineno);
+                ok = 0;
+            } else {
+                if (!name[0]) snprintf(name, sizeof(name), "%.18s-%d", arg, t->count + 1);
+                ok = add_entrant(t, &cap, name, s);
+            }
+        } else if (strcmp(kind, "client") == 0) {
+            ok = add_entrant(t, &cap, arg, NULL);
+        } else {
+            fprintf(stderr, "%s:%d: type inconnu (bot: ou client:): %s\n", path, lineno, kind);
+            ok = 0;
+        }
+    }
+    fclose(f);
+
+    if (ok && t->count < MIN_PLAYERS) {
+        fprintf(stderr, "%s: au moins %d inscrits requis\n", path, MIN_PLAYERS);
+        ok = 0;
+    }
+    return ok;
+}
+
+// Index de l'inscrit client portant ce pseudo, -1 sinon.
+int tournament_find_client(Tournament *t, const char *name) {
+    for (int i = 0; i < t->count; i++)
+        if (!t->entrants[i].bot && strcmp(t->entrants[i].name, name) == 0)
+            return i;
+    return -1;
+}
+
+static Tournament *sort_ctx;
+
+// Ordre suisse: points décroissants, puis Elo décroissant.
+static int cmp_standing(const void *a, const void *b) {
+    const Entrant *x = &sort_ctx->entrants[*(const int *)a];
+    const Entrant *y = &sort_ctx->entrants[*(const int *)b];
+    if (x->points != y->points) return y->points - x->points;
+    return (x->rating < y->rating) - (x->rating > y->rating);
+}
+
+// Vrai si a et b ont déjà partagé une table (suisse).
+static int has_met(const Tournament *t, int a, int b) {
+    if (a < 0 || b < 0) return 0;
+    const int *m = &t->met[(size_t)a * (size_t)t->met_cap];
+    for (int i = 0; i < t->entrants[a].met_len; i++)
+        if (m[i] == b) return 1;
+    return 0;
+}
+
+static void add_met(Tournament *t, int a, int b) {
+    if (a < 0 || b < 0 || has_met(t, a, b)) return;
+    Entrant *e = &t->entrants[a];
+    if (e->met_len < t->met_cap) t->met[(size_t)a * (size_t)t->met_cap + (size_t)e->met_len++] = b;
+}
+
+#define SWISS_SEARCH_MAX 200000   // Pas de recherche avant de tolérer une revanche
+
+// Remplit les sièges à partir de pos sans aucune revanche: chaque table part
+// du premier non placé du classement, puis prend les suivants les plus
+// proches qui n'ont croisé personne de la table, en revenant sur ses choix
+// si la suite se bloque. Renvoie 0 si c'est impossible dans le budget.
+static int swiss_search(const Tournament *t, const int *order, int total, char *used, int *seats,
+                        int pos, long *budget) {
+    int n = t->table_size;
+    if (pos == total) return 1;
+    if (--*budget < 0) return 0;
+
+    int first = 0;
+    while (used[first]) first++;
+    int table = pos - pos % n;
+    for (int i = first; i < total; i++) {
+        if (used[i]) continue;
+        int clash = 0;
+        for (int j = table; j < pos && !clash; j++) clash = has_met(t, seats[j], order[i]);
+        if (clash) continue;
+        used[i] = 1;
+        seats[pos] = order[i];
+        if (swiss_search(t, order, total, used, seats, pos + 1, budget)) return 1;
+        used[i] = 0;
+        if (pos == table || *budget < 0) return 0;   // Le premier siège n'a pas le choix
+    }
+    return 0;
+}
+
+// Suisse: appariement sans revanche (swiss_search); à défaut, tables formées
+// une à une en prenant pour chaque siège celui qui a croisé le moins de
+// monde à la table, au plus près au classement.
+static int swiss_pairings(Tournament *t, const int *order, int total, int *seats) {
+    int n = t->table_size;
+    if (!t->met) {
+        t->met_cap = t->rounds * (n - 1);
+        t->met = calloc((size_t)t->count * (size_t)t->met_cap, sizeof(int));
+        if (!t->met) return 0;
+    }
+    char *used = calloc((size_t)total, 1);
+    if (!used) return 0;
+
+    long budget = SWISS_SEARCH_MAX;
+    if (!swiss_search(t, order, total, used, seats, 0, &budget)) {
+        memset(used, 0, (size_t)total);
+        for (int tb = 0, next = 0; tb < total / n; tb++) {
+            int *table = &seats[tb * n];
+            while (used[next]) next++;
+            used[next] = 1;
+            table[0] = order[next];
+            for (int k = 1; k < n; k++) {
+                int best = -1, best_clash = n;
+                for (int i = next + 1; i < total && best_clash > 0; i++) {
+                    if (used[i]) continue;
+                    int clash = 0;
+                    for (int j = 0; j < k; j++) clash += has_met(t, table[j], order[i]);
+                    if (clash < best_clash) {
+                        best = i;
+                        best_clash = clash;
+                    }
+                }
+                used[best] = 1;
+                table[k] = order[best];
+            }
+        }
+    }
+    for (int tb = 0; tb < total / n; tb++)
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                if (i != j) add_met(t, seats[tb * n + i], seats[tb * n + j]);
+    free(used);
+    return 1;
+}
+
+static int gcd(int a, int b) {
+    while (b) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Rondes, tables de plus de 2: grille ntables x table_size, la colonne c
+// avance de c tables à chaque ronde; deux inscrits de colonnes différentes
+// se croisent au plus une fois par cycle de ntables rondes (ntables premier).
+// Au cycle suivant, la grille est remplie avec un autre pas premier avec
+// total, ce qui refait les colonnes.
+static void rotate_tables(int ntables, int n, int round, const int *order, int *seats) {
+    int total = ntables * n;
+    int cycle = (round - 1) / ntables, shift = (round - 1) % ntables;
+    int step = 1;
+    for (int k = 0; k < cycle; k++)
+        do step = step % total + 1; while (gcd(step, total) != 1);
+    for (int tb = 0; tb < ntables; tb++)
+        for (int c = 0; c < n; c++) {
+            int q = c * ntables + (tb + c * shift) % ntables;
+            seats[tb * n + c] = order[(int)((long)q * step % total)];
+        }
+}
+
+// Remplit seats (ntables * table_size index d'inscrits, -1 = siège libre
+// tenu par un bot maison) pour la ronde donnée; renvoie le nombre de tables.
+// Rondes: méthode du cercle pour des tables de 2 (chacun rencontre chacun en
+// total - 1 rondes); au-delà, rotation par colonnes (rotate_tables).
+// Suisse: classement courant, sans revanche tant que c'est possible.
+int tournament_pairings(Tournament *t, int round, int *seats) {
+    int n = t->table_size;
+    int ntables = (t->count + n - 1) / n;
+    int total = ntables * n;
+
+    int *order = malloc(sizeof(int) * (size_t)total);
+    if (!order) return 0;
+    for (int i = 0; i < total; i++) order[i] = i < t->count ? i : -1;
+
+    if (t->mode == TOURNOI_SUISSE) {
+        pthread_mutex_lock(&t->lock);
+        sort_ctx = t;
+        qsort(order, (size_t)t->count, sizeof(int), cmp_standing);
+        pthread_mutex_unlock(&t->lock);
+        if (!swiss_pairings(t, order, total, seats)) ntables = 0;
+    } else if (n == 2) {
+        // Le premier reste fixe, les autres tournent; i affronte total - 1 - i.
+        int m = total - 1;
+        int *pos = malloc(sizeof(int) * (size_t)total);
+        if (!pos) {
+            free(order);
+            return 0;
+        }
+        pos[0] = order[0];
+        for (int i = 1; i < total; i++) pos[i] = order[1 + (i - 1 + (round - 1)) % m];
+        for (int tb = 0; tb < ntables; tb++) {
+            seats[tb * 2] = pos[tb];
+            seats[tb * 2 + 1] = pos[total - 1 - tb];
+        }
+        free(pos);
+    } else {
+        rotate_tables(ntables, n, round, order, seats);
+    }
+
+    free(order);
+    return ntables;
+}
+
+// Enregistre le résultat d'une table: points de rang et Elo par paires
+// (calculé sur les cotes d'avant la partie). entrant[i] < 0: siège non classé.
+void tournament_record(Tournament *t, const int *entrant, const int *scores, int n) {
+    double delta[MAX_PLAYERS] = { 0 };
+
+    pthread_mutex_lock(&t->lock);
+    for (int i = 0; i < n; i++) {
+        if (entrant[i] < 0) continue;
+        Entrant *a = &t->entrants[entrant[i]];
+
+        int better = 0, rated = 0;
+        for (int j = 0; j < n; j++) {
+            if (j == i) continue;
+            if (scores[j] < scores[i]) better++;
+            if (entrant[j] < 0) continue;
+            rated++;
+            const Entrant *b = &t->entrants[entrant[j]];
+            double s = scores[i] < scores[j] ? 1.0 : scores[i] == scores[j] ? 0.5 : 0.0;
+            double e = 1.0 / (1.0 + pow(10.0, (b->rating - a->rating) / 400.0));
+            delta[i] += s - e;
+        }
+        if (rated) delta[i] *= TOURNAMENT_ELO_K / rated;
+
+        a->games++;
+        a->points += n - 1 - better;
+        a->bulls += scores[i];
+        if (better == 0) a->firsts++;
+    }
+    for (int i = 0; i < n; i++)
+        if (entrant[i] >= 0) t->entrants[entrant[i]].rating += delta[i];
+    t->games_done++;
+    pthread_mutex_unlock(&t->lock);
+}
+
+static int cmp_rating(const void *a, const void *b) {
+    const Entrant *x = &sort_ctx->entrants[*(const int *)a];
+    const Entrant *y = &sort_ctx->entrants[*(const int *)b];
+    return (x->rating < y->rating) - (x->rating > y->rating);
+}
+
+// Écrit le classement courant (trié par Elo); utilisable pendant le tournoi.
+void tournament_leaderboard(Tournament *t, FILE *out) {
+    int *order = malloc(sizeof(int) * (size_t)t->count);
+    if (!order) return;
+
+    pthread_mutex_lock(&t->lock);
+    for (int i = 0; i < t->count; i++) order[i] = i;
+    sort_ctx = t;
+    qsort(order, (size_t)t->count, sizeof(int), cmp_rating);
+
+    double minutes = (mono_now() - t->started) / 60.0;
+    fprintf(out, "Classement (%s, ronde %d/%d, %ld parties, %.0f parties/min):\n",
+            t->mode == TOURNOI_SUISSE ? "suisse" : "rondes", t->round, t->rounds,
+            t->games_done, minutes > 0 ? t->games_done / minutes : 0.0);
+    for (int k = 0; k < t->count; k++) {
+        const Entrant *e = &t->entrants[order[k]];
+        fprintf(out, "  %3d. %-20s elo %7.1f  points %5d  parties %5d  1ers %5d  boeufs/partie %5.1f  (%s)\n",
+                k + 1, e->name, e->rating, e->points, e->games, e->firsts,
+                e->games ? (double)e->bulls / e->games : 0.0, e->bot ? e->bot->name : "client");
+    }
+    pthread_mutex_unlock(&t->lock);
+    free(order);
+}
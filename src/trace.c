@@ -0,0 +1,202 @@
+#include "headers/trace.h"
+
+#include <stdatomic.h>
+
+#define TRACE_RING 1024   // Événements conservés par thread (puissance de 2)
+#define TRACE_RETIRED 256 // Noms des derniers threads finis (leurs événements restent lisibles)
+#define TRACE_NAME_MAX 48
+
+typedef struct {
+    atomic_ulong seq;     // Index + 1 une fois l'événement écrit, 0 pendant l'écriture
+    const char *name;
+    uint64_t ts;
+    uint64_t dur;
+    int tid;
+    int a0;
+    int a1;
+} TraceEvent;
+
+// tid change au recyclage de l'anneau, sous rings_lock (tenu aussi par
+// trace_dump). Le nom est écrit sans verrou par le thread propriétaire:
+// name_seq est impair pendant l'écriture, comme seq pour un événement.
+typedef struct TraceRing {
+    struct TraceRing *next;
+    atomic_int in_use;
+    int tid;
+    atomic_ulong name_seq;
+    char thread_name[TRACE_NAME_MAX];
+    atomic_ulong head;
+    TraceEvent ev[TRACE_RING];
+} TraceRing;
+
+typedef struct {
+    int tid;
+    char name[TRACE_NAME_MAX];
+} TraceName;
+
+volatile int trace_enabled = 0;
+
+static TraceRing *rings;
+static TraceName retired[TRACE_RETIRED];   // Sous rings_lock
+static unsigned long nretired;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+static atomic_int next_tid = 1;
+static _Thread_local TraceRing *tl_ring;
+
+// Horloge des événements, en nanosecondes.
+uint64_t trace_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// À la fin d'un thread, son anneau redevient disponible (ses événements restent lisibles).
+static void ring_release(void *p) {
+    TraceRing *r = p;
+    atomic_store(&r->in_use, 0);
+}
+
+static void ring_key_init(void) {
+    pthread_key_create(&ring_key, ring_release);
+}
+
+// Copie le nom d'un anneau; 0 s'il est vide ou en cours d'écriture.
+static int ring_name(TraceRing *r, char *out) {
+    unsigned long s = atomic_load_explicit(&r->name_seq, memory_order_acquire);
+    if (s == 0 || (s & 1)) return 0;
+    memcpy(out, r->thread_name, TRACE_NAME_MAX);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&r->name_seq, memory_order_relaxed) != s) return 0;
+    out[TRACE_NAME_MAX - 1] = 0;
+    return out[0] != 0;
+}
+
+// Anneau du thread courant: recyclé si possible, sinon alloué et enregistré.
+// Un anneau recyclé reçoit un nouveau tid et perd le nom du thread précédent,
+// gardé à part pour ses événements encore présents.
+static TraceRing *ring_get(void) {
+    if (tl_ring) return tl_ring;
+    pthread_once(&ring_once, ring_key_init);
+
+    TraceRing *r;
+    pthread_mutex_lock(&rings_lock);
+    for (r = rings; r; r = r->next) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&r->in_use, &expected, 1)) break;
+    }
+    if (r) {
+        TraceName *n = &retired[nretired % TRACE_RETIRED];
+        if (ring_name(r, n->name)) {
+            n->tid = r->tid;
+            nretired++;
+        }
+    } else if ((r = calloc(1, sizeof(*r)))) {
+        atomic_store(&r->in_use, 1);
+        r->next = rings;
+        rings = r;
+    }
+    if (r) {
+        r->tid = atomic_fetch_add(&next_tid, 1);
+        atomic_store_explicit(&r->name_seq, 0, memory_order_release);
+    }
+    pthread_mutex_unlock(&rings_lock);
+    if (!r) return NULL;
+
+    pthread_setspecific(ring_key, r);
+    tl_ring = r;
+    return r;
+}
+
+// Enregistre une phase terminée dans l'anneau du thread.
+void trace_record(const TraceSpan *s, uint64_t t1) {
+    TraceRing *r = ring_get();
+    if (!r) return;
+
+    unsigned long h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    TraceEvent *e = &r->ev[h & (TRACE_RING - 1)];
+    atomic_store_explicit(&e->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    e->name = s->name;
+    e->ts = s->t0;
+    e->dur = t1 - s->t0;
+    e->tid = r->tid;
+    e->a0 = s->a0;
+    e->a1 = s->a1;
+    atomic_store_explicit(&e->seq, h + 1, memory_order_release);
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+// Nomme le thread courant dans la trace (ex: "partie 12").
+void trace_thread_name(const char *fmt, ...) {
+    if (!trace_enabled) return;
+    TraceRing *r = ring_get();
+    if (!r) return;
+    char name[TRACE_NAME_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(name, sizeof(name), fmt, ap);
+    va_end(ap);
+
+    unsigned long s = atomic_load_explicit(&r->name_seq, memory_order_relaxed);
+    atomic_store_explicit(&r->name_seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(r->thread_name, name, sizeof(name));
+    atomic_store_explicit(&r->name_seq, s + 2, memory_order_release);
+}
+
+static void dump_name(FILE *f, int *count, int tid, const char *name) {
+    fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+               "\"args\":{\"name\":\"%s\"}}",
+            *count ? ",\n" : "", tid, name);
+    (*count)++;
+}
+
+// Écrit le contenu de tous les anneaux au format Chrome trace-event.
+// Renvoie le nombre d'événements écrits, -1 si le fichier est inaccessible.
+int trace_dump(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    int count = 0;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    pthread_mutex_lock(&rings_lock);
+    unsigned long first = nretired > TRACE_RETIRED ? nretired - TRACE_RETIRED : 0;
+    for (unsigned long i = first; i < nretired; i++)
+        dump_name(f, &count, retired[i % TRACE_RETIRED].tid, retired[i % TRACE_RETIRED].name);
+    for (TraceRing *r = rings; r; r = r->next) {
+        char name[TRACE_NAME_MAX];
+        if (ring_name(r, name)) dump_name(f, &count, r->tid, name);
+
+        unsigned long h = atomic_load_explicit(&r->head, memory_order_acquire);
+        unsigned long from = h > TRACE_RING ? h - TRACE_RING : 0;
+        for (unsigned long i = from; i < h; i++) {
+            TraceEvent *e = &r->ev[i & (TRACE_RING - 1)];
+            unsigned long seq = atomic_load_explicit(&e->seq, memory_order_acquire);
+            if (seq != i + 1) continue; // En cours d'écriture ou déjà réécrit
+
+            TraceEvent copy;
+            copy.name = e->name;
+            copy.ts = e->ts;
+            copy.dur = e->dur;
+            copy.tid = e->tid;
+            copy.a0 = e->a0;
+            copy.a1 = e->a1;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&e->seq, memory_order_relaxed) != seq) continue; // Réécrit pendant la copie
+
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                       "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"partie\":%d,\"joueur\":%d}}",
+                    count ? ",\n" : "", copy.name, copy.tid,
+                    copy.ts / 1000.0, copy.dur / 1000.0, copy.a0, copy.a1);
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&rings_lock);
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return count;
+}
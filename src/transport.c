@@ -0,0 +1,419 @@
+#define _GNU_SOURCE
+
+#include "headers/transport.h"
+#include "headers/util.h"
+#include "headers/proto.h"
+
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define SHM_RING_SIZE (64 * 1024)   // Puissance de deux
+#define SHM_MAGIC 0x36515031u       // "6QP1"
+#define SHM_POLL_MS 250             // Vérification périodique du socket du pair
+#define SHM_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)   // Taille figée, exigée par le serveur
+
+// Anneau à un écrivain et un lecteur. head/tail comptent les octets écrits
+// et lus (modulo 2^32); un côté ne dort sur son sémaphore qu'après l'avoir
+// annoncé (reader_waiting/writer_waiting), l'autre ne poste qu'à ce moment.
+typedef struct {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic int reader_waiting;
+    _Atomic int writer_waiting;
+    _Atomic int closed;
+    sem_t data;
+    sem_t space;
+    char buf[SHM_RING_SIZE];
+} ShmRing;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;         // sizeof(ShmArea), vérifié par le serveur
+    ShmRing up;            // Client -> serveur
+    ShmRing down;          // Serveur -> client
+} ShmArea;
+
+// Vrai si le pair a fermé son socket (le socket ne sert plus qu'à ça).
+static int peer_gone(int sock) {
+    char ch;
+    ssize_t r = recv(sock, &ch, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (r == 0) return 1;
+    return r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+}
+
+// Attend le sémaphore par tranches de SHM_POLL_MS; 0 si le pair a disparu.
+static int ring_wait(sem_t *s, int sock) {
+    for (;;) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += SHM_POLL_MS * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        if (sem_timedwait(s, &ts) == 0) return 1;
+        if (errno == EINTR) continue;
+        if (errno != ETIMEDOUT) return 0;
+        return !peer_gone(sock);
+    }
+}
+
+// Lit au moins un octet (bloquant); 0 à la fermeture, -1 si l'anneau est incohérent.
+static ssize_t ring_read(ShmRing *r, char *buf, size_t n, int sock) {
+    for (;;) {
+        uint32_t tail = atomic_load(&r->tail);
+        uint32_t avail = atomic_load(&r->head) - tail;
+        if (avail > SHM_RING_SIZE) {
+            errno = EPROTO;
+            return -1;
+        }
+
+        if (avail > 0) {
+            size_t take = n < avail ? n : avail;
+            size_t off = tail & (SHM_RING_SIZE - 1);
+            size_t first = SHM_RING_SIZE - off < take ? SHM_RING_SIZE - off : take;
+            memcpy(buf, r->buf + off, first);
+            memcpy(buf + first, r->buf, take - first);
+            atomic_store(&r->tail, tail + (uint32_t)take);
+            if (atomic_exchange(&r->writer_waiting, 0)) sem_post(&r->space);
+            return (ssize_t)take;
+        }
+
+        if (atomic_load(&r->closed)) return 0;
+        atomic_store(&r->reader_waiting, 1);
+        if (atomic_load(&r->head) != tail || atomic_load(&r->closed)) continue;
+        if (!ring_wait(&r->data, sock)) return 0;
+    }
+}
+
+// Écrit tout le tampon, en attendant de la place si l'anneau est plein.
+// Non bloquant (nowait): s'arrête à l'anneau plein, EAGAIN si rien n'est passé.
+static ssize_t ring_write(ShmRing *r, const char *buf, size_t n, int sock, int nowait) {
+    size_t done = 0;
+
+    while (done < n) {
+        if (atomic_load(&r->closed)) {
+            errno = EPIPE;
+            return -1;
+        }
+
+        uint32_t head = atomic_load(&r->head);
+        uint32_t tail = atomic_load(&r->tail);
+        uint32_t used = head - tail;
+        if (used > SHM_RING_SIZE) {
+            errno = EPROTO;
+            return -1;
+        }
+
+        size_t room = SHM_RING_SIZE - used;
+        if (room == 0 && nowait) {
+            if (done > 0) return (ssize_t)done;
+            errno = EAGAIN;
+            return -1;
+        }
+        if (room == 0) {
+            atomic_store(&r->writer_waiting, 1);
+            if (atomic_load(&r->tail) != tail || atomic_load(&r->closed)) continue;
+            if (!ring_wait(&r->space, sock)) {
+                errno = EPIPE;
+                return -1;
+            }
+            continue;
+        }
+
+        size_t put = n - done < room ? n - done : room;
+        size_t off = head & (SHM_RING_SIZE - 1);
+        size_t first = SHM_RING_SIZE - off < put ? SHM_RING_SIZE - off : put;
+        memcpy(r->buf + off, buf + done, first);
+        memcpy(r->buf, buf + done + first, put - first);
+        atomic_store(&r->head, head + (uint32_t)put);
+        if (atomic_exchange(&r->reader_waiting, 0)) sem_post(&r->data);
+        done += put;
+    }
+    return (ssize_t)n;
+}
+
+// Marque les deux anneaux fermés et réveille un pair éventuellement endormi.
+static void area_shutdown(ShmArea *a) {
+    ShmRing *rings[2] = { &a->up, &a->down };
+    for (int i = 0; i < 2; i++) {
+        atomic_store(&rings[i]->closed, 1);
+        sem_post(&rings[i]->data);
+        sem_post(&rings[i]->space);
+    }
+}
+
+/* Côté serveur: socket local avec réception de descripteur, puis anneaux. */
+
+// Lecture sur socket local; un descripteur joint (SCM_RIGHTS) est conservé.
+static ssize_t unix_read(Conn *c, char *buf, size_t n) {
+    union {
+        struct cmsghdr h;
+        char b[CMSG_SPACE(sizeof(int))];
+    } ctl;
+    struct iovec iov = { buf, n };
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    m.msg_control = ctl.b;
+    m.msg_controllen = sizeof(ctl.b);
+
+    ssize_t r = recvmsg(c->fd, &m, MSG_CMSG_CLOEXEC);
+    for (struct cmsghdr *h = CMSG_FIRSTHDR(&m); r >= 0 && h; h = CMSG_NXTHDR(&m, h)) {
+        if (h->cmsg_level != SOL_SOCKET || h->cmsg_type != SCM_RIGHTS) continue;
+        size_t nfd = (h->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < nfd; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(h) + i * sizeof(int), sizeof(fd));
+            if (c->passed_fd < 0) c->passed_fd = fd;
+            else close(fd);
+        }
+    }
+    return r;
+}
+
+static ssize_t unix_write(Conn *c, const char *buf, size_t n) {
+    return send(c->fd, buf, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static void unix_close(Conn *c) {
+    close(c->fd);
+}
+
+static const ConnOps unix_ops = { unix_read, unix_write, unix_close, sock_wait_writable, sock_wait_readable, unix_close };
+
+static ssize_t shm_read(Conn *c, char *buf, size_t n) {
+    return ring_read(&((ShmArea *)c->priv)->up, buf, n, c->fd);
+}
+
+static ssize_t shm_write(Conn *c, const char *buf, size_t n) {
+    return ring_write(&((ShmArea *)c->priv)->down, buf, n, c->fd, 1);
+}
+
+// Attend de la place dans l'anneau descendant, au plus timeout_ms.
+static int shm_wait_writable(Conn *c, int timeout_ms) {
+    ShmRing *r = &((ShmArea *)c->priv)->down;
+    double deadline = mono_now() + timeout_ms / 1000.0;
+    for (;;) {
+        uint32_t tail = atomic_load(&r->tail);
+        if (atomic_load(&r->closed)) return 0;
+        if (atomic_load(&r->head) - tail < SHM_RING_SIZE) return 1;
+        if (mono_now() >= deadline) return 0;
+        atomic_store(&r->writer_waiting, 1);
+        if (atomic_load(&r->tail) != tail) continue;
+        if (!ring_wait(&r->space, c->fd)) return 0;
+    }
+}
+
+// Attend des octets dans l'anneau montant (ou sa fermeture), au plus timeout_ms.
+static int shm_wait_readable(Conn *c, int timeout_ms) {
+    ShmRing *r = &((ShmArea *)c->priv)->up;
+    double deadline = mono_now() + timeout_ms / 1000.0;
+    for (;;) {
+        uint32_t tail = atomic_load(&r->tail);
+        if (atomic_load(&r->head) != tail || atomic_load(&r->closed)) return 1;
+        if (mono_now() >= deadline) return 0;
+        atomic_store(&r->reader_waiting, 1);
+        if (atomic_load(&r->head) != tail) continue;
+        if (!ring_wait(&r->data, c->fd)) return 1;   // Pair parti: la lecture le dira
+    }
+}
+
+static void shm_close(Conn *c) {
+    area_shutdown(c->priv);
+    munmap(c->priv, sizeof(ShmArea));
+    c->priv = NULL;
+    close(c->fd);
+}
+
+// Libère la projection sans fermer les anneaux: le pair continue avec un autre processus.
+static void shm_detach(Conn *c) {
+    munmap(c->priv, sizeof(ShmArea));
+    c->priv = NULL;
+    close(c->fd);
+}
+
+static const ConnOps shm_ops = { shm_read, shm_write, shm_close, shm_wait_writable, shm_wait_readable, shm_detach };
+
+// Vrai si la connexion passe par les anneaux partagés (deux descripteurs à transmettre).
+int conn_is_shm(const Conn *c) {
+    return c->ops == &shm_ops;
+}
+
+// Connexion acceptée sur le socket local du serveur.
+void conn_init_unix(Conn *c, int fd) {
+    conn_init(c, fd);
+    c->ops = &unix_ops;
+}
+
+// Bascule la connexion sur la zone partagée reçue avec la ligne "SHM".
+int conn_attach_shm(Conn *c) {
+    if (c->passed_fd < 0) return 0;
+
+    // Le memfd reste ouvert (passed_fd) pour pouvoir transmettre la connexion
+    // à un processus de parties; conn_close le ferme. Sa taille doit être
+    // scellée: un client qui le tronquerait après coup ferait tomber le
+    // serveur sur SIGBUS en touchant la projection.
+    struct stat st;
+    ShmArea *a = MAP_FAILED;
+    int seals = fcntl(c->passed_fd, F_GET_SEALS);
+    if (seals >= 0 && (seals & SHM_SEALS) == SHM_SEALS &&
+        fstat(c->passed_fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmArea))
+        a = mmap(NULL, sizeof(ShmArea), PROT_READ | PROT_WRITE, MAP_SHARED, c->passed_fd, 0);
+    if (a != MAP_FAILED && (a->magic != SHM_MAGIC || a->size != sizeof(ShmArea))) {
+        munmap(a, sizeof(ShmArea));
+        a = MAP_FAILED;
+    }
+    if (a == MAP_FAILED) {
+        close(c->passed_fd);
+        c->passed_fd = -1;
+        return 0;
+    }
+
+    c->priv = a;
+    c->ops = &shm_ops;
+    return 1;
+}
+
+/* Côté client: flux stdio au-dessus des anneaux (fopencookie). */
+
+typedef struct {
+    ShmArea *a;
+    int sock;
+    int refs;              // Flux d'entrée et de sortie encore ouverts
+} ShmStream;
+
+static ssize_t stream_read(void *cookie, char *buf, size_t n) {
+    ShmStream *s = cookie;
+    return ring_read(&s->a->down, buf, n, s->sock);
+}
+
+static ssize_t stream_write(void *cookie, const char *buf, size_t n) {
+    ShmStream *s = cookie;
+    return ring_write(&s->a->up, buf, n, s->sock, 0) < 0 ? -1 : (ssize_t)n;
+}
+
+static int stream_close(void *cookie) {
+    ShmStream *s = cookie;
+    if (--s->refs > 0) return 0;
+    area_shutdown(s->a);
+    munmap(s->a, sizeof(ShmArea));
+    close(s->sock);
+    free(s);
+    return 0;
+}
+
+// Envoie une ligne accompagnée d'un descripteur.
+static int send_fd_line(int sock, const char *line, int fd) {
+    union {
+        struct cmsghdr h;
+        char b[CMSG_SPACE(sizeof(int))];
+    } ctl;
+    memset(&ctl, 0, sizeof(ctl));
+
+    struct iovec iov = { (void *)line, strlen(line) };
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    m.msg_control = ctl.b;
+    m.msg_controllen = sizeof(ctl.b);
+
+    struct cmsghdr *h = CMSG_FIRSTHDR(&m);
+    h->cmsg_level = SOL_SOCKET;
+    h->cmsg_type = SCM_RIGHTS;
+    h->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(h), &fd, sizeof(fd));
+
+    return sendmsg(sock, &m, MSG_NOSIGNAL) == (ssize_t)iov.iov_len;
+}
+
+// Crée la zone partagée, la transmet au serveur et ouvre les deux flux.
+static int shm_open_streams(const char *path, FILE **in, FILE **out) {
+    int sock = unix_connect(path);
+    if (sock < 0) return 0;
+
+    ShmArea *a = MAP_FAILED;
+    int mfd = memfd_create("6quiprend-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mfd >= 0 && ftruncate(mfd, sizeof(ShmArea)) == 0 && fcntl(mfd, F_ADD_SEALS, SHM_SEALS) == 0)
+        a = mmap(NULL, sizeof(ShmArea), PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+    if (a == MAP_FAILED) {
+        if (mfd >= 0) close(mfd);
+        close(sock);
+        return 0;
+    }
+
+    a->magic = SHM_MAGIC;
+    a->size = sizeof(ShmArea);
+    sem_init(&a->up.data, 1, 0);
+    sem_init(&a->up.space, 1, 0);
+    sem_init(&a->down.data, 1, 0);
+    sem_init(&a->down.space, 1, 0);
+
+    int sent = send_fd_line(sock, SHM_HELLO "\n", mfd);
+    close(mfd);
+
+    ShmStream *s = sent ? malloc(sizeof(*s)) : NULL;
+    if (!s) {
+        munmap(a, sizeof(ShmArea));
+        close(sock);
+        return 0;
+    }
+    s->a = a;
+    s->sock = sock;
+    s->refs = 2;
+
+    cookie_io_functions_t io = { stream_read, stream_write, NULL, stream_close };
+    *in = fopencookie(s, "r", io);
+    *out = *in ? fopencookie(s, "w", io) : NULL;
+    if (!*out) {
+        // Un seul propriétaire restant: la fermeture libère tout
+        s->refs = 1;
+        if (*in) fclose(*in);
+        else stream_close(s);
+        *in = NULL;
+        return 0;
+    }
+    setvbuf(*out, NULL, _IOLBF, 0);
+    return 1;
+}
+
+// Ouvre les flux d'un client selon le schéma d'adresse (tcp, unix:, shm:).
+int net_open(const char *host, const char *port, FILE **in, FILE **out) {
+    *in = *out = NULL;
+    if (str_starts(host, "shm:")) return shm_open_streams(host + 4, in, out);
+
+    int fd = str_starts(host, "unix:") ? unix_connect(host + 5) : tcp_connect(host, port);
+    if (fd < 0) return 0;
+
+    *in = fdopen_r(fd);
+    *out = fdopen_w(fd);
+    close(fd);
+    if (!*in || !*out) {
+        if (*in) fclose(*in);
+        if (*out) fclose(*out);
+        return 0;
+    }
+    return 1;
+}
+
+// Suit une ligne "INFO REDIRECT hote port" reçue à l'accueil: ferme les flux,
+// se connecte au nœud indiqué et y renvoie la ligne d'accueil. 0 si la ligne
+// n'est pas une redirection, 1 si elle a été suivie, -1 en cas d'échec (nœud
+// injoignable ou trop de rebonds).
+int net_follow_redirect(const char *line, const char *hello, FILE **in, FILE **out) {
+    static int hops = 0;
+    char host[256], port[32];
+    if (!parse_redirect(line, host, sizeof(host), port, sizeof(port))) return 0;
+    if (++hops > NET_REDIRECT_MAX) return -1;
+
+    fclose(*in);
+    fclose(*out);
+    fprintf(stderr, "Redirection vers %s %s\n", host, port);
+    if (!net_open(host, port, in, out)) return -1;
+    return send_line(*out, hello) ? 1 : -1;
+}
@@ -0,0 +1,287 @@
+#include "headers/common.h"
+#include "headers/util.h"
+#include "headers/game.h"
+#include "headers/strategy.h"
+
+#include <math.h>
+
+/*
+ * Réglage des poids de l'heuristique "risque" par stratégie d'évolution
+ * (μ/μ_w, λ) à échantillons miroirs et pas adapté au taux de succès.
+ * Chaque candidat joue les mêmes parties (graines communes à toute la
+ * génération, parent compris) contre des adversaires fixes; la note est
+ * l'écart moyen de têtes de bœuf avec eux (plus bas = meilleur). Les parties
+ * sont réparties sur tous les coeurs.
+ * Usage: ./reglage [-g generations] [-l lambda] [-n parties] [-j threads]
+ *                  [-J joueurs] [-a petite|risque] [-v variante] [-s graine] [-o fichier]
+ */
+
+#define BLOCK_GAMES 50
+#define TWO_PI 6.283185307179586
+#define LAMBDA_MAX 64
+
+// Échelle d'un pas unité pour chaque poids (même ordre que StrategyParams).
+static const double param_scale[STRATEGY_PARAMS_COUNT] = { 2000, 5, 1000, 2, 0.5, 5, 2 };
+
+static Rules rules;
+static int nplayers = 4;
+static int opp_smallest = 0;      // Adversaires "petite" au lieu de "risque" par défaut
+
+// Évaluation en cours: cands[k] joue les parties seed0 .. seed0 + ngames - 1.
+static StrategyParams cands[LAMBDA_MAX + 1];
+static int ncands;
+static int ngames;
+static uint64_t seed0;
+static double *block_sum;         // [candidat * nblocks + bloc]
+static int nblocks;
+static int next_job;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Joue une partie complète; renvoie les têtes du candidat moins la moyenne des adversaires.
+static double play_game(const StrategyParams *cand, uint64_t seed) {
+    const StrategyParams *opp = &strategy_params_default;
+    int n = nplayers;
+    int cseat = (int)(seed % (uint64_t)n);
+    Game g;
+    game_init_rules(&g, n, &rules);
+    game_reseed(&g, seed);
+    game_setup_rows(&g);
+    game_deal(&g);
+
+    while (!game_over(&g, rules.end_score)) {
+        for (int p = 0; p < n; p++) {
+            int c;
+            if (p == cseat)
+                c = choose_card_params(cand, g.hands[p], g.hand_len[p], g.rows, rules.row_max);
+            else if (opp_smallest)
+                c = choose_smallest_card(g.hands[p], g.hand_len[p]);
+            else
+                c = choose_card_params(opp, g.hands[p], g.hand_len[p], g.rows, rules.row_max);
+            game_hand_remove(&g, p, c);
+            g.carte_jouee[p] = c;
+        }
+
+        int order[MAX_PLAYERS];
+        for (int i = 0; i < n; i++) order[i] = i;
+        for (int i = 1; i < n; i++)
+            for (int j = i; j > 0 && g.carte_jouee[order[j]] < g.carte_jouee[order[j - 1]]; j--) {
+                int t = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = t;
+            }
+
+        for (int k = 0; k < n; k++) {
+            int pid = order[k];
+            int c = g.carte_jouee[pid];
+            int chosen = -1, taken, b;
+            if (card_takes_row(g.rows, c)) {
+                if (pid == cseat) chosen = choose_row_params(cand, g.rows);
+                else if (opp_smallest) chosen = choose_row_min_bulls(g.rows);
+                else chosen = choose_row_params(opp, g.rows);
+            }
+            game_place_card(&g, pid, c, chosen, &taken, &b);
+        }
+
+        g.tour++;
+        if (g.tour > rules.hand_size) game_next_manche(&g);
+    }
+
+    double others = 0;
+    for (int p = 0; p < n; p++)
+        if (p != cseat) others += g.scores[p];
+    return g.scores[cseat] - others / (n - 1);
+}
+
+// Thread de calcul: prend des blocs (candidat, parties) jusqu'à épuisement.
+static void *eval_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&job_lock);
+        int job = next_job++;
+        pthread_mutex_unlock(&job_lock);
+        if (job >= ncands * nblocks) return NULL;
+
+        int k = job / nblocks, b = job % nblocks;
+        int first = b * BLOCK_GAMES;
+        int last = first + BLOCK_GAMES < ngames ? first + BLOCK_GAMES : ngames;
+        double s = 0;
+        for (int i = first; i < last; i++) s += play_game(&cands[k], seed0 + (uint64_t)i);
+        block_sum[job] = s;
+    }
+}
+
+// Note moyenne de chaque candidat sur les mêmes parties, en parallèle.
+static void evaluate(int nthreads, double *fitness) {
+    nblocks = (ngames + BLOCK_GAMES - 1) / BLOCK_GAMES;
+    next_job = 0;
+
+    pthread_t tids[256];
+    int started = 0;
+    for (int i = 0; i < nthreads && i < 256; i++)
+        if (pthread_create(&tids[started], NULL, eval_thread, NULL) == 0) started++;
+    if (!started) eval_thread(NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+    for (int k = 0; k < ncands; k++) {
+        double s = 0;
+        for (int b = 0; b < nblocks; b++) s += block_sum[k * nblocks + b];
+        fitness[k] = s / ngames;
+    }
+}
+
+static uint64_t rng_state;
+
+static double rng_uniform(void) {
+    uint64_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    rng_state = x;
+    return ((x >> 11) + 0.5) / 9007199254740992.0;
+}
+
+// Tirage gaussien (Box-Muller).
+static double rng_gauss(void) {
+    return sqrt(-2.0 * log(rng_uniform())) * cos(TWO_PI * rng_uniform());
+}
+
+// Vecteur normalisé -> poids (x = 0: poids par défaut).
+static void to_params(const double *x, StrategyParams *p) {
+    *p = strategy_params_default;
+    for (int i = 0; i < STRATEGY_PARAMS_COUNT; i++)
+        *strategy_param(p, i, NULL) += x[i] * param_scale[i];
+}
+
+static double *sort_fitness;
+
+// Classe les descendants par note croissante.
+static int cmp_index(const void *a, const void *b) {
+    double x = sort_fitness[*(const int *)a], y = sort_fitness[*(const int *)b];
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    int generations = 30;
+    int lambda = 16;
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int seed = 1;
+    const char *outfile = "strategie.params";
+    int opt;
+
+    ngames = 10000;
+    rules = *rules_get(VARIANT_CLASSIQUE);
+
+    while ((opt = getopt(argc, argv, "g:l:n:j:J:a:v:s:o:")) != -1) {
+        int ok = 1;
+        switch (opt) {
+        case 'g': ok = parse_int(optarg, &generations) && generations > 0; break;
+        case 'l': ok = parse_int(optarg, &lambda) && lambda >= 2 && lambda <= LAMBDA_MAX && lambda % 2 == 0; break;
+        case 'n': ok = parse_int(optarg, &ngames) && ngames > 0; break;
+        case 'j': ok = parse_int(optarg, &nthreads) && nthreads > 0; break;
+        case 'J': ok = parse_int(optarg, &nplayers) && nplayers >= MIN_PLAYERS && nplayers <= MAX_PLAYERS; break;
+        case 'a':
+            ok = strcmp(optarg, "petite") == 0 || strcmp(optarg, "risque") == 0;
+            opp_smallest = strcmp(optarg, "petite") == 0;
+            break;
+        case 'v': ok = rules_lookup(optarg, &rules); break;
+        case 's': ok = parse_int(optarg, &seed); break;
+        case 'o': outfile = optarg; break;
+        default: ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr,
+                    "Usage: %s [-g generations] [-l lambda (pair)] [-n parties] [-j threads]\n"
+                    "          [-J joueurs] [-a petite|risque] [-v variante] [-s graine] [-o fichier]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (!rules_check(&rules, nplayers)) {
+        fprintf(stderr, "Nombre de joueurs invalide pour la variante %s\n", rules.name);
+        return 1;
+    }
+
+    block_sum = malloc(sizeof(double) * (size_t)(lambda + 1) * (size_t)((ngames + BLOCK_GAMES - 1) / BLOCK_GAMES));
+    if (!block_sum) die("malloc");
+    rng_state = (uint64_t)(unsigned)seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    // Poids logarithmiques de recombinaison des μ = λ/2 meilleurs.
+    int mu = lambda / 2;
+    double w[LAMBDA_MAX], wsum = 0;
+    for (int i = 0; i < mu; i++) wsum += w[i] = log(mu + 0.5) - log(i + 1.0);
+    for (int i = 0; i < mu; i++) w[i] /= wsum;
+
+    double x[STRATEGY_PARAMS_COUNT] = { 0 };
+    double z[LAMBDA_MAX][STRATEGY_PARAMS_COUNT];
+    double sigma = 0.5;
+    double fitness[LAMBDA_MAX + 1];
+    int idx[LAMBDA_MAX];
+    double t0 = mono_now();
+
+    printf("reglage: %d generations, lambda=%d, %d parties par candidat, %d joueurs, %d threads\n",
+           generations, lambda, ngames, nplayers, nthreads);
+
+    for (int gen = 0; gen < generations; gen++) {
+        // Parent en 0, puis λ descendants miroirs (z, -z).
+        ncands = lambda + 1;
+        to_params(x, &cands[0]);
+        for (int k = 0; k < lambda; k += 2) {
+            for (int i = 0; i < STRATEGY_PARAMS_COUNT; i++) {
+                z[k][i] = rng_gauss();
+                z[k + 1][i] = -z[k][i];
+            }
+            for (int m = 0; m < 2; m++) {
+                double y[STRATEGY_PARAMS_COUNT];
+                for (int i = 0; i < STRATEGY_PARAMS_COUNT; i++) y[i] = x[i] + sigma * z[k + m][i];
+                to_params(y, &cands[k + m + 1]);
+            }
+        }
+
+        seed0 = (uint64_t)(unsigned)seed * 1000003ULL + (uint64_t)gen * (uint64_t)ngames;
+        evaluate(nthreads, fitness);
+
+        sort_fitness = fitness + 1;
+        for (int k = 0; k < lambda; k++) idx[k] = k;
+        qsort(idx, (size_t)lambda, sizeof(int), cmp_index);
+
+        int better = 0;
+        for (int k = 0; k < lambda; k++) better += fitness[k + 1] < fitness[0];
+
+        for (int i = 0; i < STRATEGY_PARAMS_COUNT; i++) {
+            double step = 0;
+            for (int r = 0; r < mu; r++) step += w[r] * z[idx[r]][i];
+            x[i] += sigma * step;
+        }
+        // Règle du cinquième: le pas grandit quand plus d'un descendant sur cinq bat le parent.
+        sigma *= exp(((double)better / lambda - 0.2) / 0.8);
+        if (sigma < 0.01) sigma = 0.01;
+        if (sigma > 2) sigma = 2;
+
+        printf("gen %3d  parent %+7.3f  meilleur %+7.3f  succes %2d/%d  pas %.3f  (%.1f s)\n",
+               gen + 1, fitness[0], fitness[idx[0] + 1], better, lambda, sigma, mono_now() - t0);
+        fflush(stdout);
+    }
+
+    // Validation sur des parties jamais vues: poids par défaut contre poids réglés.
+    ncands = 2;
+    cands[0] = strategy_params_default;
+    to_params(x, &cands[1]);
+    seed0 = (uint64_t)(unsigned)seed * 1000003ULL + (uint64_t)generations * (uint64_t)ngames + 7919;
+    evaluate(nthreads, fitness);
+
+    long total = (long)generations * (lambda + 1) * ngames + 2L * ngames;
+    printf("validation (%d parties): defaut %+7.3f  regle %+7.3f  (%ld parties en %.1f s)\n",
+           ngames, fitness[0], fitness[1], total, mono_now() - t0);
+
+    if (fitness[1] >= fitness[0]) {
+        printf("Les poids regles ne battent pas les poids par defaut: %s inchange\n", outfile);
+        return 2;
+    }
+
+    char comment[160];
+    snprintf(comment, sizeof(comment), "reglage: %d generations x %d parties, ecart %+.3f (defaut %+.3f) contre %s",
+             generations, ngames, fitness[1], fitness[0], opp_smallest ? "petite" : "risque");
+    if (!strategy_params_save(outfile, &cands[1], comment)) die("ecriture des poids");
+    printf("Poids ecrits dans %s\n", outfile);
+    return 0;
+}
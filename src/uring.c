@@ -0,0 +1,574 @@
+#define _GNU_SOURCE
+
+#include "headers/uring.h"
+#include "headers/util.h"
+
+#include <linux/io_uring.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define UR_ENTRIES 1024
+#define UR_BUFS 256                 // Tampons de réception fournis (puissance de deux)
+#define UR_BUF_SIZE 4096
+#define UR_BGID 0
+#define UR_IN_MAX (64 * 1024)       // Reçu non lu au-delà duquel la connexion est coupée
+#define UR_OUT_SIZE (16 * 1024)
+#define UR_ACCEPT_MAX 256           // Connexions acceptées en attente de l'accueil
+
+// Type d'opération dans les 3 bits bas de user_data (UringConn aligné sur 16).
+enum { OP_ACCEPT = 1, OP_WAKE, OP_RECV, OP_SEND, OP_CANCEL };
+#define OP_MASK 7u
+
+// État io_uring d'une connexion; survit au Conn (rendu au pool dès la
+// fermeture) jusqu'à la dernière complétion qui la concerne.
+typedef struct UringConn {
+    int fd;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;           // Données reçues, place libérée, fin
+    char *in;
+    int in_len;
+    int in_cap;
+    int eof;
+    int err;                       // errno de la fin, 0 pour une fermeture normale
+    int closing;
+    uint32_t out_head;
+    uint32_t out_len;
+    // Thread io_uring seulement
+    int recv_armed;
+    int sends;                     // SQE d'envoi en vol
+    int cancel_sent;
+    int queued;                    // Dans la liste de travail (work_lock)
+    struct UringConn *work_next;
+    char out[UR_OUT_SIZE];
+} UringConn;
+
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned sq_local;             // Prochaine queue, publiée à la soumission
+    unsigned sq_entries;
+    unsigned pending;              // SQE préparées, pas encore soumises
+} Ring;
+
+static Ring ring;
+static struct io_uring_buf_ring *bufring;
+static char *bufs;
+static unsigned short buf_tail;
+static int listen_sock = -1;
+static int wake_fd = -1;           // Threads de partie -> thread io_uring
+static uint64_t wake_buf;
+static int wake_armed;
+static _Atomic int wake_pending;
+static int accept_fd = -1;         // Thread io_uring -> boucle d'accueil (sémaphore)
+
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+static UringConn *work_head;
+
+static pthread_mutex_t accept_lock = PTHREAD_MUTEX_INITIALIZER;
+static int accepted[UR_ACCEPT_MAX];
+static int acc_head, acc_len;
+
+static _Atomic long st_enters, st_accepts, st_recvs, st_sends, st_wakeups;
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(unsigned submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, ring.fd, submit, min_complete, flags, NULL, 0);
+}
+
+// Crée l'anneau et projette ses files (une seule projection SQ/CQ).
+static int ring_init(unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ring.fd = sys_setup(entries, &p);
+    if (ring.fd < 0) return 0;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_NODROP)) {
+        errno = ENOSYS;
+        return 0;
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    size_t size = sq_size > cq_size ? sq_size : cq_size;
+    char *q = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (q == MAP_FAILED) return 0;
+    ring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) return 0;
+
+    ring.sq_head = (unsigned *)(q + p.sq_off.head);
+    ring.sq_tail = (unsigned *)(q + p.sq_off.tail);
+    ring.sq_mask = (unsigned *)(q + p.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(q + p.sq_off.array);
+    ring.cq_head = (unsigned *)(q + p.cq_off.head);
+    ring.cq_tail = (unsigned *)(q + p.cq_off.tail);
+    ring.cq_mask = (unsigned *)(q + p.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(q + p.cq_off.cqes);
+    ring.sq_entries = p.sq_entries;
+    ring.sq_local = *ring.sq_tail;
+    return 1;
+}
+
+// Soumet les SQE préparées; attend au moins wait complétions.
+static void ring_submit(unsigned wait) {
+    __atomic_store_n(ring.sq_tail, ring.sq_local, __ATOMIC_RELEASE);
+    unsigned n = ring.pending;
+    ring.pending = 0;
+    st_enters++;
+    while (sys_enter(n, wait, wait ? IORING_ENTER_GETEVENTS : 0) < 0 && errno == EINTR) n = 0;
+}
+
+// SQE libre (mise à zéro); soumet d'abord si la file est pleine.
+static struct io_uring_sqe *sqe_get(void) {
+    if (ring.sq_local - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) >= ring.sq_entries) ring_submit(0);
+    unsigned idx = ring.sq_local & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sq_array[idx] = idx;
+    ring.sq_local++;
+    ring.pending++;
+    return sqe;
+}
+
+// Rend un tampon de réception au noyau.
+static void buf_recycle(unsigned bid) {
+    struct io_uring_buf *b = &bufring->bufs[buf_tail & (UR_BUFS - 1)];
+    b->addr = (uint64_t)(uintptr_t)(bufs + (size_t)bid * UR_BUF_SIZE);
+    b->len = UR_BUF_SIZE;
+    b->bid = (uint16_t)bid;
+    buf_tail++;
+    __atomic_store_n(&bufring->tail, buf_tail, __ATOMIC_RELEASE);
+}
+
+// Enregistre l'anneau de tampons fournis (groupe UR_BGID).
+static int bufring_init(void) {
+    size_t size = UR_BUFS * sizeof(struct io_uring_buf);
+    bufring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufring == MAP_FAILED) return 0;
+    bufs = malloc((size_t)UR_BUFS * UR_BUF_SIZE);
+    if (!bufs) return 0;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)bufring;
+    reg.ring_entries = UR_BUFS;
+    reg.bgid = UR_BGID;
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return 0;
+    for (unsigned i = 0; i < UR_BUFS; i++) buf_recycle(i);
+    return 1;
+}
+
+static void arm_accept(void) {
+    struct io_uring_sqe *sqe = sqe_get();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_sock;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = OP_ACCEPT;
+}
+
+static void arm_wake(void) {
+    struct io_uring_sqe *sqe = sqe_get();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd;
+    sqe->addr = (uint64_t)(uintptr_t)&wake_buf;
+    sqe->len = sizeof(wake_buf);
+    sqe->user_data = OP_WAKE;
+    wake_armed = 1;
+}
+
+// Signale au thread io_uring qu'une connexion a du travail (envoi, fermeture, réception à armer).
+// Ordre des verrous: uc->lock puis work_lock.
+static void conn_kick(UringConn *uc) {
+    pthread_mutex_lock(&work_lock);
+    if (!uc->queued) {
+        uc->queued = 1;
+        uc->work_next = work_head;
+        work_head = uc;
+    }
+    pthread_mutex_unlock(&work_lock);
+    if (!atomic_exchange(&wake_pending, 1)) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {}
+    }
+}
+
+// Prépare ce que demande l'état d'une connexion: réception multishot,
+// envoi de la file de sortie (deux SQE liées si elle fait le tour), puis à
+// la fermeture l'annulation de la réception et la libération. Thread io_uring,
+// seul à libérer uc: jamais tant qu'elle est dans la liste de travail.
+static void conn_service(UringConn *uc) {
+    pthread_mutex_lock(&uc->lock);
+    if (!uc->closing && !uc->eof && !uc->recv_armed) {
+        struct io_uring_sqe *sqe = sqe_get();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = uc->fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = UR_BGID;
+        sqe->user_data = (uint64_t)(uintptr_t)uc | OP_RECV;
+        uc->recv_armed = 1;
+    }
+
+    if (!uc->sends && uc->out_len > 0 && !uc->eof) {
+        uint32_t first = UR_OUT_SIZE - uc->out_head < uc->out_len ? UR_OUT_SIZE - uc->out_head : uc->out_len;
+        uint32_t second = uc->out_len - first;
+        struct io_uring_sqe *sqe = sqe_get();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = uc->fd;
+        sqe->addr = (uint64_t)(uintptr_t)(uc->out + uc->out_head);
+        sqe->len = first;
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;   // Envoi partiel: lien rompu
+        sqe->user_data = (uint64_t)(uintptr_t)uc | OP_SEND;
+        uc->sends = 1;
+        if (second) {
+            sqe->flags = IOSQE_IO_LINK;
+            sqe = sqe_get();
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = uc->fd;
+            sqe->addr = (uint64_t)(uintptr_t)uc->out;
+            sqe->len = second;
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            sqe->user_data = (uint64_t)(uintptr_t)uc | OP_SEND;
+            uc->sends = 2;
+        }
+    }
+
+    // Fermeture: la file de sortie part d'abord, puis la réception est annulée
+    int drained = !uc->sends && (uc->out_len == 0 || uc->eof);
+    if (uc->closing && drained && uc->recv_armed && !uc->cancel_sent) {
+        struct io_uring_sqe *sqe = sqe_get();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = uc->fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = (uint64_t)(uintptr_t)uc | OP_CANCEL;
+        uc->cancel_sent = 1;
+    }
+    int done = uc->closing && drained && !uc->recv_armed && !uc->cancel_sent;
+    if (done) {
+        // Remise en liste (ur_close, sous uc->lock): libérée au passage suivant
+        pthread_mutex_lock(&work_lock);
+        done = !uc->queued;
+        pthread_mutex_unlock(&work_lock);
+    }
+    pthread_mutex_unlock(&uc->lock);
+
+    if (done) {
+        close(uc->fd);
+        pthread_mutex_destroy(&uc->lock);
+        pthread_cond_destroy(&uc->cond);
+        free(uc->in);
+        free(uc);
+    }
+}
+
+// Octets reçus: ajoutés à l'entrée de la connexion (agrandie au besoin).
+static void conn_received(UringConn *uc, const char *data, int n) {
+    pthread_mutex_lock(&uc->lock);
+    if (uc->in_len + n > uc->in_cap) {
+        int cap = uc->in_cap ? uc->in_cap : UR_BUF_SIZE;
+        while (cap < uc->in_len + n) cap *= 2;
+        char *in = cap <= UR_IN_MAX ? realloc(uc->in, (size_t)cap) : NULL;
+        if (!in) {
+            uc->eof = 1;           // Client qui ne lit pas ses réponses: coupé
+            uc->err = EMSGSIZE;
+            pthread_cond_broadcast(&uc->cond);
+            pthread_mutex_unlock(&uc->lock);
+            return;
+        }
+        uc->in = in;
+        uc->in_cap = cap;
+    }
+    memcpy(uc->in + uc->in_len, data, (size_t)n);
+    uc->in_len += n;
+    pthread_cond_broadcast(&uc->cond);
+    pthread_mutex_unlock(&uc->lock);
+}
+
+// Traite une complétion.
+static void cqe_handle(const struct io_uring_cqe *cqe) {
+    unsigned op = (unsigned)(cqe->user_data & OP_MASK);
+    UringConn *uc = (UringConn *)(uintptr_t)(cqe->user_data & ~(uint64_t)OP_MASK);
+    int more = cqe->flags & IORING_CQE_F_MORE;
+
+    switch (op) {
+    case OP_ACCEPT:
+        st_accepts++;
+        if (cqe->res >= 0) {
+            pthread_mutex_lock(&accept_lock);
+            int queued = acc_len < UR_ACCEPT_MAX;
+            if (queued) accepted[(acc_head + acc_len++) % UR_ACCEPT_MAX] = cqe->res;
+            pthread_mutex_unlock(&accept_lock);
+            uint64_t one = 1;
+            if (!queued) close(cqe->res);
+            else if (write(accept_fd, &one, sizeof(one)) < 0) {}
+        }
+        if (!more) arm_accept();
+        return;
+
+    case OP_WAKE:
+        wake_armed = 0;
+        st_wakeups++;
+        return;
+
+    case OP_RECV:
+        st_recvs++;
+        if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+            unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            conn_received(uc, bufs + (size_t)bid * UR_BUF_SIZE, cqe->res);
+            buf_recycle(bid);
+        }
+        if (!more) {
+            pthread_mutex_lock(&uc->lock);
+            uc->recv_armed = 0;
+            if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECANCELED)) {
+                uc->eof = 1;
+                uc->err = cqe->res < 0 ? -cqe->res : 0;
+                pthread_cond_broadcast(&uc->cond);
+            }
+            pthread_mutex_unlock(&uc->lock);
+        }
+        conn_service(uc);   // ENOBUFS: réarmée dès que des tampons sont rendus
+        return;
+
+    case OP_SEND:
+        st_sends++;
+        pthread_mutex_lock(&uc->lock);
+        if (cqe->res > 0) {
+            uc->out_head = (uc->out_head + (uint32_t)cqe->res) % UR_OUT_SIZE;
+            uc->out_len -= (uint32_t)cqe->res;
+        } else if (cqe->res < 0 && cqe->res != -ECANCELED) {
+            uc->eof = 1;
+            uc->err = -cqe->res;
+        }
+        uc->sends--;
+        pthread_cond_broadcast(&uc->cond);
+        pthread_mutex_unlock(&uc->lock);
+        if (!uc->sends) conn_service(uc);
+        return;
+
+    case OP_CANCEL:
+        pthread_mutex_lock(&uc->lock);
+        uc->cancel_sent = 0;
+        if (cqe->res < 0) uc->recv_armed = 0;   // Rien à annuler: réception déjà terminée
+        pthread_mutex_unlock(&uc->lock);
+        conn_service(uc);
+        return;
+    }
+}
+
+// Boucle du thread propriétaire de l'anneau.
+static void *uring_thread(void *arg) {
+    (void)arg;
+    arm_accept();
+    for (;;) {
+        if (!wake_armed) arm_wake();
+        atomic_store(&wake_pending, 0);
+
+        pthread_mutex_lock(&work_lock);
+        UringConn *list = work_head;
+        work_head = NULL;
+        for (UringConn *uc = list; uc; uc = uc->work_next) uc->queued = 0;
+        pthread_mutex_unlock(&work_lock);
+        while (list) {
+            UringConn *next = list->work_next;
+            conn_service(list);
+            list = next;
+        }
+
+        // Tous les envois du tour et les réarmements partent en un appel
+        ring_submit(1);
+
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            cqe_handle(&ring.cqes[head & *ring.cq_mask]);
+            head++;
+            __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+            tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        }
+    }
+    return NULL;
+}
+
+// Démarre le moteur sur le socket d'écoute TCP; 0 si le noyau refuse
+// io_uring ou une fonction requise (accept et réception multishot, tampons fournis).
+int uring_start(int listen_fd) {
+    listen_sock = listen_fd;
+    if (!ring_init(UR_ENTRIES) || !bufring_init()) return 0;
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    accept_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    if (wake_fd < 0 || accept_fd < 0) return 0;
+
+    // Sonde: une réception multishot doit être acceptée par ce noyau
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) return 0;
+    struct io_uring_sqe *sqe = sqe_get();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sv[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = UR_BGID;
+    sqe->user_data = 0;
+    ring_submit(0);
+    close(sv[1]);
+    ring_submit(1);
+    unsigned head = *ring.cq_head;
+    int res = ring.cqes[head & *ring.cq_mask].res;
+    __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+    close(sv[0]);
+    if (res < 0) {
+        errno = -res;
+        return 0;
+    }
+
+    pthread_t t;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int ok = pthread_create(&t, &attr, uring_thread, NULL) == 0;
+    pthread_attr_destroy(&attr);
+    return ok;
+}
+
+// Descripteur lisible tant qu'une connexion acceptée attend (à surveiller
+// à la place du socket d'écoute TCP).
+int uring_accept_fd(void) {
+    return accept_fd;
+}
+
+// Connexion acceptée suivante et son adresse; -1 s'il n'y en a pas.
+int uring_accept_pop(struct sockaddr_in *cli) {
+    uint64_t v;
+    if (read(accept_fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) return -1;
+    pthread_mutex_lock(&accept_lock);
+    int fd = acc_len ? accepted[acc_head] : -1;
+    if (acc_len) {
+        acc_head = (acc_head + 1) % UR_ACCEPT_MAX;
+        acc_len--;
+    }
+    pthread_mutex_unlock(&accept_lock);
+
+    socklen_t len = sizeof(*cli);
+    if (fd >= 0 && getpeername(fd, (struct sockaddr *)cli, &len) < 0) memset(cli, 0, sizeof(*cli));
+    return fd;
+}
+
+/* Opérations de connexion, côté threads de partie. */
+
+static ssize_t ur_read(Conn *c, char *buf, size_t n) {
+    UringConn *uc = c->priv;
+    pthread_mutex_lock(&uc->lock);
+    while (!uc->in_len && !uc->eof) pthread_cond_wait(&uc->cond, &uc->lock);
+    ssize_t k = (size_t)uc->in_len < n ? uc->in_len : (ssize_t)n;
+    if (k > 0) {
+        memcpy(buf, uc->in, (size_t)k);
+        memmove(uc->in, uc->in + k, (size_t)(uc->in_len - k));
+        uc->in_len -= (int)k;
+    } else if (uc->err) {
+        errno = uc->err;
+        k = -1;
+    }
+    pthread_mutex_unlock(&uc->lock);
+    return k;
+}
+
+// Copie dans la file de sortie, envoyée par le thread io_uring; EAGAIN si pleine.
+static ssize_t ur_write(Conn *c, const char *buf, size_t n) {
+    UringConn *uc = c->priv;
+    pthread_mutex_lock(&uc->lock);
+    if (uc->eof) {
+        errno = uc->err ? uc->err : EPIPE;
+        pthread_mutex_unlock(&uc->lock);
+        return -1;
+    }
+    size_t room = UR_OUT_SIZE - uc->out_len;
+    size_t k = n < room ? n : room;
+    uint32_t tail = (uc->out_head + uc->out_len) % UR_OUT_SIZE;
+    size_t first = UR_OUT_SIZE - tail < k ? UR_OUT_SIZE - tail : k;
+    memcpy(uc->out + tail, buf, first);
+    memcpy(uc->out, buf + first, k - first);
+    uc->out_len += (uint32_t)k;
+    pthread_mutex_unlock(&uc->lock);
+
+    if (k == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    conn_kick(uc);
+    return (ssize_t)k;
+}
+
+// Attend une condition de la connexion au plus timeout_ms (want: 0 lecture, 1 écriture).
+static int ur_wait(Conn *c, int timeout_ms, int want) {
+    UringConn *uc = c->priv;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&uc->lock);
+    int ok;
+    for (;;) {
+        ok = uc->eof || (want ? uc->out_len < UR_OUT_SIZE : uc->in_len > 0);
+        if (ok || pthread_cond_timedwait(&uc->cond, &uc->lock, &ts) == ETIMEDOUT) break;
+    }
+    ok = want ? !uc->eof && uc->out_len < UR_OUT_SIZE : uc->eof || uc->in_len > 0;
+    pthread_mutex_unlock(&uc->lock);
+    return ok;
+}
+
+static int ur_wait_readable(Conn *c, int timeout_ms) {
+    return ur_wait(c, timeout_ms, 0);
+}
+
+static int ur_wait_writable(Conn *c, int timeout_ms) {
+    return ur_wait(c, timeout_ms, 1);
+}
+
+// Fermeture confiée au thread io_uring (fin des envois, annulation, close).
+// La connexion est mise en liste avant de rendre uc->lock: conn_service ne
+// peut pas la libérer entre-temps, et uc n'est plus touchée ensuite.
+static void ur_close(Conn *c) {
+    UringConn *uc = c->priv;
+    c->priv = NULL;
+    pthread_mutex_lock(&uc->lock);
+    uc->closing = 1;
+    conn_kick(uc);
+    pthread_mutex_unlock(&uc->lock);
+}
+
+static const ConnOps uring_ops = { ur_read, ur_write, ur_close, ur_wait_writable, ur_wait_readable, ur_close };
+
+// Connexion TCP acceptée servie par io_uring; 0 si la mémoire manque.
+int uring_conn_init(Conn *c, int fd) {
+    UringConn *uc = calloc(1, sizeof(*uc));
+    if (!uc) return 0;
+    uc->fd = fd;
+    pthread_mutex_init(&uc->lock, NULL);
+    pthread_cond_init(&uc->cond, NULL);
+    conn_init(c, fd);
+    c->ops = &uring_ops;
+    c->priv = uc;
+    conn_kick(uc);   // Réception multishot armée par le thread io_uring
+    return 1;
+}
+
+// Relevé des compteurs du moteur.
+void uring_stats(UringStats *st) {
+    st->enters = st_enters;
+    st->accepts = st_accepts;
+    st->recvs = st_recvs;
+    st->sends = st_sends;
+    st->wakeups = st_wakeups;
+}
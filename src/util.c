@@ -18,6 +18,12 @@ int parse_int(const char *s, int *out) {
     *out = (int)v;
     return 1;
 }
+// Horloge monotone en secondes, pour mesurer attentes et délais.
+double mono_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
 // Supprime les caractères de fin de ligne d'une chaîne. pour I/O du txte.
 void trim_crlf(char *s) {
     size_t n = strlen(s);
@@ -6,9 +6,15 @@ ROOT_DIR=$(cd "$(dirname "$0")" && pwd)
 # Vérifie les arguments.
 LOG="$1"
 if [ -z "$LOG" ]; then
-    echo "Usage: ./stats.sh <path/to/log>"
+    echo "Usage: ./stats.sh <path/to/log|game_id>"
     exit 1
 fi
+# Un numéro de partie est extrait de l'archive.
+if echo "$LOG" | grep -qE '^[0-9]+$'; then
+    mkdir -p "$ROOT_DIR/logs"
+    "$ROOT_DIR/archive" cat "$LOG" > "$ROOT_DIR/logs/partie_$LOG.log"
+    LOG="$ROOT_DIR/logs/partie_$LOG.log"
+fi
 # Vérifie si le fichier de log existe.
 if [ ! -f "$LOG" ]; then
     if [ -f "$ROOT_DIR/$LOG" ]; then